@@ -18,43 +18,186 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <thread>
 #include "BufferQueue.h"
 
+/*
+ * Wait policy for blocking calls. Spin on the ring for a short interval,
+ * then yield the processor, and finally park on the condition variable.
+ */
+#define QUEUE_SPIN_LIMIT        256
+#define QUEUE_YIELD_LIMIT       1024
+
+using namespace std;
+
+static size_t roundCapacity(size_t n)
+{
+    size_t c = 2;
+    while (c < n) c <<= 1;
+    return c;
+}
+
+bool BufferQueue::push(int handle)
+{
+    Cell *cell;
+    size_t pos = _tail.load(memory_order_relaxed);
+
+    for (;;) {
+        cell = &_cells[pos & _mask];
+        size_t seq = cell->seq.load(memory_order_acquire);
+        auto diff = (intptr_t) seq - (intptr_t) pos;
+
+        if (!diff) {
+            if (_tail.compare_exchange_weak(pos, pos + 1,
+                                            memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _tail.load(memory_order_relaxed);
+        }
+    }
+
+    cell->handle = handle;
+    cell->seq.store(pos + 1, memory_order_release);
+    return true;
+}
+
+bool BufferQueue::pop(int &handle)
+{
+    Cell *cell;
+    size_t pos = _head.load(memory_order_relaxed);
+
+    for (;;) {
+        cell = &_cells[pos & _mask];
+        size_t seq = cell->seq.load(memory_order_acquire);
+        auto diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+        if (!diff) {
+            if (_head.compare_exchange_weak(pos, pos + 1,
+                                            memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _head.load(memory_order_relaxed);
+        }
+    }
+
+    handle = cell->handle;
+    cell->seq.store(pos + _mask + 1, memory_order_release);
+    return true;
+}
+
+/* Only take the lock if someone is parked */
+void BufferQueue::wake()
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_waiters.load(memory_order_relaxed) > 0) {
+        lock_guard<mutex> guard(_mutex);
+        _cv.notify_all();
+    }
+}
+
 size_t BufferQueue::size()
 {
-    std::lock_guard<std::mutex> guard(mutex);
-    return q.size();
-};
+    size_t head = _head.load(memory_order_acquire);
+    size_t tail = _tail.load(memory_order_acquire);
+    return tail > head ? tail - head : 0;
+}
+
+size_t BufferQueue::capacity() const
+{
+    return _mask + 1;
+}
 
-std::shared_ptr<LteBuffer> BufferQueue::read()
+int BufferQueue::read()
 {
-    std::unique_lock<std::mutex> lock(mutex);
-    cv.wait(lock, [this]{ return !q.empty(); });
-    auto buf = q.front();
-    q.pop();
+    int handle;
+    if (pop(handle)) {
+        wake();
+        return handle;
+    }
+
+    _empty++;
 
-    return buf;
+    for (int i = 0; i < QUEUE_YIELD_LIMIT; i++) {
+        if (pop(handle)) {
+            wake();
+            return handle;
+        }
+        if (i >= QUEUE_SPIN_LIMIT) this_thread::yield();
+    }
+
+    unique_lock<mutex> lock(_mutex);
+    _waiters++;
+    _cv.wait(lock, [this, &handle]{ return pop(handle); });
+    _waiters--;
+    lock.unlock();
+
+    wake();
+    return handle;
 }
 
-std::shared_ptr<LteBuffer> BufferQueue::readNoBlock()
+int BufferQueue::readNoBlock()
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (q.empty()) return nullptr;
-    auto buf = q.front();
-    q.pop();
+    int handle;
+    if (!pop(handle)) {
+        _empty++;
+        return -1;
+    }
 
-    return buf;
+    wake();
+    return handle;
 }
-bool BufferQueue::write(std::shared_ptr<LteBuffer> buf)
+
+bool BufferQueue::write(int handle)
 {
-    std::unique_lock<std::mutex> lock(mutex);
-    q.push(buf);
+    if (push(handle)) {
+        wake();
+        return true;
+    }
+
+    _full++;
+
+    for (int i = 0; i < QUEUE_YIELD_LIMIT; i++) {
+        if (push(handle)) {
+            wake();
+            return true;
+        }
+        if (i >= QUEUE_SPIN_LIMIT) this_thread::yield();
+    }
+
+    unique_lock<mutex> lock(_mutex);
+    _waiters++;
+    _cv.wait(lock, [this, handle]{ return push(handle); });
+    _waiters--;
     lock.unlock();
-    cv.notify_one();
+
+    wake();
     return true;
 }
 
+unsigned long BufferQueue::emptyCount() const
+{
+    return _empty.load(memory_order_relaxed);
+}
+
+unsigned long BufferQueue::fullCount() const
+{
+    return _full.load(memory_order_relaxed);
+}
+
+BufferQueue::BufferQueue(size_t capacity)
+  : _cells(new Cell[roundCapacity(capacity)]),
+    _mask(roundCapacity(capacity) - 1),
+    _tail(0), _head(0), _empty(0), _full(0), _waiters(0)
+{
+    for (size_t i = 0; i <= _mask; i++)
+        _cells[i].seq.store(i, memory_order_relaxed);
+}
+
 BufferQueue::BufferQueue(const BufferQueue &q)
-  : BufferQueue()
+  : BufferQueue(q.capacity())
 {
 }
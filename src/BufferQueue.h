@@ -3,26 +3,65 @@
 
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <atomic>
 #include <condition_variable>
 
-#include "LteBuffer.h"
+/*
+ * Number of LTE subframe buffers passed between PDSCH processing threads
+ */
+#define NUM_RECV_SUBFRAMES        128
 
+/*
+ * Bounded lock-free buffer queue
+ *
+ * Multi-producer multi-consumer ring of LteBufferPool handles with fixed
+ * capacity (rounded up to a power of two). Each cell carries a sequence
+ * number that tells producers and consumers whether the slot is ready, so
+ * the fast path is a single compare-and-swap on the head or tail index.
+ * Blocking calls spin briefly before parking on a condition variable, and
+ * writers only touch the mutex when a thread is actually parked.
+ */
 class BufferQueue {
 public:
-    BufferQueue() = default;
+    BufferQueue(size_t capacity = NUM_RECV_SUBFRAMES);
     BufferQueue(const BufferQueue &q);
     ~BufferQueue() = default;
 
     size_t size();
+    size_t capacity() const;
 
-    std::shared_ptr<LteBuffer> read();
-    std::shared_ptr<LteBuffer> readNoBlock();
-    bool write(std::shared_ptr<LteBuffer> buf);
+    /* Buffer handles are non-negative; readNoBlock() returns -1 if empty */
+    int read();
+    int readNoBlock();
+    bool write(int handle);
+
+    /* Number of times a reader found the queue empty or a writer full */
+    unsigned long emptyCount() const;
+    unsigned long fullCount() const;
 
 private:
-    std::mutex mutex;
-    std::condition_variable cv;
-    std::queue<std::shared_ptr<LteBuffer>> q;
+    struct Cell {
+        std::atomic<size_t> seq;
+        int handle;
+    };
+
+    bool push(int handle);
+    bool pop(int &handle);
+    void wake();
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+
+    /* Keep producer and consumer indices on separate cache lines */
+    char _pad0[64];
+    std::atomic<size_t> _tail;
+    char _pad1[64];
+    std::atomic<size_t> _head;
+    char _pad2[64];
+
+    std::atomic<unsigned long> _empty, _full;
+    std::atomic<int> _waiters;
+    std::mutex _mutex;
+    std::condition_variable _cv;
 };
 #endif /* _BUFFER_QUEUE_ */
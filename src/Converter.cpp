@@ -19,6 +19,8 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
 #include "Converter.h"
 
 extern "C" {
@@ -70,6 +72,66 @@ static auto decim(int rbs)
     }
 }
 
+/*
+ * PBCH decimation at 20 MHz. The single-stage filter used there sets the
+ * transition width that the final stage of each cascade keeps.
+ */
+#define REF_DECIM		12
+
+/*
+ * Decimation cascade from the PDSCH rate to the PBCH rate. Factors of two
+ * run first at the highest rates followed by a final factor of two or
+ * three that sets the PBCH passband.
+ */
+static vector<int> factors(int q)
+{
+    vector<int> f;
+
+    if (q == 1)
+        return f;
+
+    int last = q % 3 ? 2 : 3;
+    for (q /= last; !(q % 2); q /= 2)
+        f.push_back(2);
+    if (q != 1)
+        throw invalid_argument("Unsupported decimation");
+
+    f.push_back(last);
+    return f;
+}
+
+/*
+ * Filter length for transition half-width 'w' at rate 'r', both relative
+ * to the PBCH rate. Blackman-Harris main lobe half-width is four bins.
+ * Lengths are rounded up to multiples of eight, which keeps group delay at
+ * an integer n/2 samples and the vector kernels free of scalar tails.
+ */
+static size_t stageLen(double r, double w)
+{
+    size_t n = ceil(4.0 * r / w);
+    return (n + 7) & ~7;
+}
+
+/* Device samples to float */
+template <typename T> static float sampleScale();
+template <> float sampleScale<complex<short>>() { return 1.0 / 128.0; }
+template <> float sampleScale<complex<float>>() { return 1.0; }
+
+/* Sample conversion and frequency correction in a single pass */
+static void convert(complex<float> *out, const complex<short> *in,
+                    size_t len, struct nco *nco)
+{
+    convert_short_float_nco((float *) out, (short *) in, len,
+                            sampleScale<complex<short>>(), nco);
+}
+
+static void convert(complex<float> *out, const complex<float> *in,
+                    size_t len, struct nco *nco)
+{
+    convert_float_nco((float *) out, (float *) in, len,
+                      sampleScale<complex<float>>(), nco);
+}
+
 template <typename T>
 void Converter<T>::init(size_t rbs)
 {
@@ -80,150 +142,282 @@ void Converter<T>::init(size_t rbs)
     size_t pbchLen = lte_subframe_len(6);
     size_t pssLen = lte_subframe_len(6) / 2;
 
-    for (auto &b : _buffers) b.resize(pdschLen);
-    for (auto &b : _prev) b = SignalVector(pdschLen, _taps);
-    for (auto &b : _pdsch) b = SignalVector(pdschLen, _taps);
-    for (auto &b : _pbch) b = SignalVector(pbchLen);
-    for (auto &b : _pss) b = SignalVector(pssLen);
-
     int d = decim(rbs);
     int pss_q = use_fft_1536(rbs) ? 32 * 3 / 4 / d : 32 / d;
     int pbch_q = pss_q / 2;
 
-    for (auto &p : _pssResamplers) p = Resampler(1, pss_q, _taps);
-    for (auto &p : _pbchResamplers) p = Resampler(1, pbch_q, _taps);
+    /*
+     * Leading half-band stages only need to keep aliases out of the final
+     * stage passband. The final stage and the PSS half-band use the
+     * transition width of the single-stage 20 MHz filter.
+     */
+    auto f = factors(pbch_q);
+    double w = 4.0 * REF_DECIM / _taps;
+    double r = pbch_q;
+
+    vector<size_t> lens;
+    for (size_t k = 0; k < f.size(); k++) {
+        if (k < f.size() - 1)
+            lens.push_back(stageLen(r, max(r / 4 - (0.5 + w), w)));
+        else
+            lens.push_back(stageLen(r, w));
+        r /= f[k];
+    }
+    lens.push_back(stageLen(1, w));
+
+    if (lens.front() > _taps)
+        throw invalid_argument("Insufficient filter length");
+
+    /* Group delay at the PDSCH rate, matched on PBCH with a delay line */
+    size_t q = 1;
+    _delay = 0;
+    for (size_t k = 0; k < f.size(); k++) {
+        _delay += lens[k] / 2 * q;
+        q *= f[k];
+    }
+    _delay += lens.back() / 2 * pbch_q;
+
+    /*
+     * Trailing outputs per stage that seed the following stage history,
+     * followed by the PBCH rate tail kept by the PSS half-band
+     */
+    size_t tail = lens.back();
+    _stageTails.resize(f.size() + 1);
+    _stageTails.back() = tail;
+    for (int k = f.size() - 1; k >= 0; k--) {
+        _stageTails[k] = tail;
+        tail = tail * f[k] + lens[k];
+    }
+
+    for (auto &b : _buffers) b.resize(pdschLen);
+    for (auto &b : _prev) b.assign(pdschLen, T());
+    for (auto &b : _pbch) b = SignalVector(pbchLen);
+    for (auto &b : _pss) b = SignalVector(pssLen);
+    for (auto &b : _pbchHistory) b = SignalVector(lens.back() / 2);
+    for (auto &p : _pssResamplers) p = Resampler(1, 2, lens.back());
+
+    nco_set_freq(&_nco, -_freqOffset / (pdschLen * 1000.0));
+    nco_set_freq(&_pbchNco, -_freqOffset / (pbchLen * 1000.0));
+
+    for (size_t i = 0; i < channels(); i++) {
+        _pbchResamplers[i].clear();
+        _pbchStages[i].clear();
+
+        size_t len = pdschLen;
+        for (size_t k = 0; k < f.size(); k++) {
+            len /= f[k];
+            _pbchResamplers[i].emplace_back(1, f[k], lens[k]);
+            _pbchStages[i].emplace_back(len, lens[k + 1]);
+        }
+
+        /* Without a cascade device samples are converted at the PBCH rate */
+        if (f.empty())
+            _pbchStages[i].emplace_back(pbchLen, lens.back());
+    }
 
     _rbs = rbs;
     reset();
 }
 
+/*
+ * Frequency correction in Hz applied during PDSCH and PBCH conversion.
+ * Oscillator phase is continuous across subframes and offset changes.
+ */
 template <typename T>
-void Converter<T>::convertPDSCH()
-{
-    if (_convertPDSCH) return;
-
-    auto convert = [](const auto &in, auto &out) {
-        const auto s = 1.0 / 128.0;
-        transform(cbegin(in), cend(in), begin(out), [s](auto &a) {
-            return complex<float>(a.real()*s, a.imag()*s);
-        });
-    };
-
-    auto _copy = [](const auto &in, auto &out) {
-        copy(cbegin(in), cend(in), begin(out));
-    };
-
-    auto p = begin(_pdsch);
-    if (sizeof(T) == sizeof(complex<short>))
-        for (auto &b : _buffers) convert(b, *p++);
-    else if (sizeof(T) == sizeof(complex<float>))
-        for (auto &b : _buffers) _copy(b, *p++);
-    else
-        throw runtime_error("Unsupported sample type");
+void Converter<T>::setFreqOffset(double offset)
+{
+    if (offset == _freqOffset)
+        return;
 
-    _convertPDSCH = true;
+    _freqOffset = offset;
+    if (pdschLen()) {
+        nco_set_freq(&_nco, -offset / (pdschLen() * 1000.0));
+        nco_set_freq(&_pbchNco, -offset / (_pbch.front().size() * 1000.0));
+    }
 }
 
+/*
+ * The first cascade stage decimates device samples directly, which for
+ * 16-bit input runs the fixed-point kernel. Frequency correction follows
+ * at the PBCH rate.
+ */
 template <typename T>
 void Converter<T>::convertPBCH()
 {
     if (_convertPBCH) return;
-    if (_convertPDSCH == false) convertPDSCH();
 
-    auto p = begin(_pbch);
-    auto r = begin(_pbchResamplers);
+    for (size_t i = 0; i < channels(); i++) {
+        auto &r = _pbchResamplers[i];
+        auto &s = _pbchStages[i];
+
+        if (!r.empty())
+            r[0].rotate(_prev[i], _buffers[i], s[0], sampleScale<T>());
+        for (size_t k = 1; k < r.size(); k++)
+            r[k].rotate(s[k - 1], s[k]);
 
-    for (auto &b : _pdsch) r++->rotate(b, *p++);
-   _convertPBCH = true;
+        correctPBCH(i, s.back().size());
+        delayPBCH(i);
+    }
+    _convertPBCH = true;
 }
 
+/* PSS is decimated from the PBCH rate cascade output */
 template <typename T>
 void Converter<T>::convertPSS()
 {
     if (_convertPSS) return;
-    if (_convertPDSCH == false) convertPDSCH();
-
-    auto p = begin(_pss);
-    auto r = begin(_pssResamplers);
+    if (_convertPBCH == false) convertPBCH();
 
-    for (auto &b : _pdsch) r++->rotate(b, *p++);
+    for (size_t i = 0; i < channels(); i++)
+        _pssResamplers[i].rotate(pbchRate(i), _pss[i]);
    _convertPSS = true;
 }
 
 template <typename T>
 void Converter<T>::convertPBCH(size_t channel, SignalVector &v)
 {
-    if (channel > channels()) throw out_of_range("");
-    if (_convertPDSCH == false) convertPDSCH();
+    if (channel >= channels()) throw out_of_range("");
+    if (v.size() != _pbch[channel].size()) throw out_of_range("");
+    if (_convertPBCH == false) convertPBCH();
 
-    auto &b = _pdsch[channel];
-    auto &r = _pbchResamplers[channel];
-
-    r.rotate(b, v);
+    auto &p = _pbch[channel];
+    copy(p.cbegin(), p.cend(), v.begin());
 }
 
+/*
+ * Write the timing adjusted PDSCH subframe into caller owned channel buffers
+ * of at least 'maxLen' samples. Returns the number of samples written.
+ * Device samples are converted and frequency corrected directly into the
+ * caller buffers, with oscillator phase set back over the samples taken
+ * from the previous subframe.
+ */
 template <typename T>
-void Converter<T>::delayPDSCH(vector<vector<complex<float>>> &v, int offset)
+size_t Converter<T>::delayPDSCH(vector<complex<float> *> &v,
+                                size_t maxLen, int offset)
 {
     if (v.size() != channels()) throw out_of_range("");
-    if (_convertPDSCH == false) convertPDSCH();
+    if (pdschLen() > maxLen) throw out_of_range("");
 
-    int min = - _taps/2;
-    int max = pdschLen() - _taps/2;
+    int min = - (int) _delay;
+    int max = pdschLen() - _delay;
 
     if (offset < min) offset = min;
     else if (offset > max) offset = max;
 
-    auto pi = begin(_prev);
-    auto bi = begin(_pdsch);
+    size_t len = pdschLen();
+    size_t head = _delay + offset;
 
-    for (auto &vi : v) {
-        vi.resize(bi->size());
-        auto iter = copy(pi->end() - _taps/2 - offset, pi->end(), begin(vi));
-        copy_n(bi->begin(), distance(iter, end(vi)), iter);
-        pi++;
-        bi++;
+    for (size_t i = 0; i < channels(); i++) {
+        struct nco nco = _nco;
+        nco_advance(&nco, -(int) head);
+
+        convert(v[i], _prev[i].data() + len - head, head, &nco);
+        convert(v[i] + head, _buffers[i].data(), len - head, &nco);
     }
+
+    return len;
 }
 
+/*
+ * Advance filter history over an unconverted subframe. Cascade stages only
+ * compute the trailing outputs that the following stage keeps as history.
+ */
 template <typename T>
 void Converter<T>::update()
 {
-    auto r = begin(_pssResamplers);
-    for (auto &b : _pdsch) r++->update(b);
-
-    r = begin(_pbchResamplers);
-    for (auto &b : _pdsch) r++->update(b);
+    for (size_t i = 0; i < channels(); i++) {
+        if (_convertPBCH == false) {
+            auto &r = _pbchResamplers[i];
+            auto &s = _pbchStages[i];
+            auto &t = _stageTails;
+
+            if (!r.empty())
+                r[0].rotateTail(_buffers[i], s[0], t[0], sampleScale<T>());
+            for (size_t k = 1; k < r.size(); k++)
+                r[k].rotateTail(s[k - 1], s[k], t[k]);
+
+            correctPBCH(i, t.back());
+
+            auto &in = pbchRate(i);
+            auto &h = _pbchHistory[i];
+            copy(in.end() - h.size(), in.end(), h.begin());
+        }
+        if (_convertPSS == false) _pssResamplers[i].update(pbchRate(i));
+    }
 }
 
 template <typename T>
 void Converter<T>::reset()
 {
-    _convertPDSCH = false;
     _convertPBCH = false;
     _convertPSS = false;
 
-    swap(_prev, _pdsch);
+    swap(_prev, _buffers);
+
+    nco_advance(&_nco, pdschLen());
+    if (!_pbch.empty()) nco_advance(&_pbchNco, _pbch.front().size());
 }
 
 template <typename T>
 size_t Converter<T>::channels() const
 {
-    return _pdsch.size();
+    return _buffers.size();
 }
 
 template <typename T>
 size_t Converter<T>::pdschLen() const
 {
-    return !_pdsch.size() ? 0 : _pdsch.front().size();
+    return !_buffers.size() ? 0 : _buffers.front().size();
+}
+
+template <typename T>
+SignalVector &Converter<T>::pbchRate(size_t channel)
+{
+    return _pbchStages[channel].back();
+}
+
+/*
+ * Frequency correction of the trailing 'len' PBCH rate samples, converting
+ * device samples in the same pass when there is no cascade. Correcting
+ * after decimation shifts the cascade response by the offset, which is
+ * small against the transition bands.
+ */
+template <typename T>
+void Converter<T>::correctPBCH(size_t channel, size_t len)
+{
+    size_t start = pbchRate(channel).size() - len;
+    auto out = &pbchRate(channel).begin()[start];
+
+    struct nco nco = _pbchNco;
+    nco_advance(&nco, start);
+
+    if (_pbchResamplers[channel].empty())
+        convert(out, &_buffers[channel][start], len, &nco);
+    else
+        convert(out, out, len, &nco);
+}
+
+/* Delay PBCH to match the group delay of the PSS half-band */
+template <typename T>
+void Converter<T>::delayPBCH(size_t channel)
+{
+    auto &in = pbchRate(channel);
+    auto &h = _pbchHistory[channel];
+
+    auto iter = copy(h.begin(), h.end(), _pbch[channel].begin());
+    copy(in.begin(), in.end() - h.size(), iter);
+    copy(in.end() - h.size(), in.end(), h.begin());
 }
 
 template <typename T>
 Converter<T>::Converter(size_t chans, size_t taps)
-  : _prev(chans), _buffers(chans), _pdsch(chans), _pbch(chans),
-    _pss(chans), _pssResamplers(chans), _pbchResamplers(chans),
-    _taps(taps), _rbs(0)
+  : _buffers(chans), _prev(chans), _pbch(chans), _pss(chans),
+    _pbchResamplers(chans), _pbchStages(chans), _pbchHistory(chans),
+    _pssResamplers(chans), _freqOffset(0.0),
+    _taps(taps), _rbs(0), _delay(taps / 2)
 {
+    nco_init(&_nco);
+    nco_init(&_pbchNco);
 }
 
 template class Converter<complex<short>>;
@@ -8,6 +8,10 @@
 #include "Resampler.h"
 #include "SignalVector.h"
 
+extern "C" {
+#include "dsp/convert.h"
+}
+
 template <typename T>
 class Converter {
 public:
@@ -20,37 +24,48 @@ public:
     Converter &operator=(Converter &&c) = default;
 
     void init(size_t rbs);
+    void setFreqOffset(double offset);
 
-    void convertPDSCH();
     void convertPBCH();
     void convertPSS();
     void convertPBCH(size_t channel, SignalVector &v);
 
-    void delayPDSCH(std::vector<std::vector<std::complex<float>>> &v, int offset);
+    size_t delayPDSCH(std::vector<std::complex<float> *> &v,
+                      size_t maxLen, int offset);
     void update();
     void reset();
 
     auto& raw() { return _buffers; };
     auto& pss() { return _pss; }
     auto& pbch() { return _pbch; }
-    auto& pdsch() { return _pdsch; }
 
 private:
     size_t channels() const;
     size_t pdschLen() const;
+    SignalVector &pbchRate(size_t channel);
+    void correctPBCH(size_t channel, size_t len);
+    void delayPBCH(size_t channel);
 
+    /* Device samples of the current and previous subframes */
     std::vector<std::vector<T>> _buffers;
+    std::vector<std::vector<T>> _prev;
 
-    std::vector<SignalVector> _prev;
-    std::vector<SignalVector> _pdsch;
     std::vector<SignalVector> _pbch;
     std::vector<SignalVector> _pss;
 
+    /* PBCH cascade stages and outputs per channel, PSS from PBCH rate */
+    std::vector<std::vector<Resampler>> _pbchResamplers;
+    std::vector<std::vector<SignalVector>> _pbchStages;
+    std::vector<SignalVector> _pbchHistory;
     std::vector<Resampler> _pssResamplers;
-    std::vector<Resampler> _pbchResamplers;
+    std::vector<size_t> _stageTails;
+
+    /* Frequency correction at the PDSCH and PBCH rates */
+    struct nco _nco, _pbchNco;
+    double _freqOffset;
 
-    bool _convertPDSCH, _convertPBCH, _convertPSS;
-    size_t _taps, _rbs;
+    bool _convertPBCH, _convertPSS;
+    size_t _taps, _rbs, _delay;
 };
 
 #endif /* _CONVERTER_H_ */
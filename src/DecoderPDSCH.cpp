@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <complex>
+#include <algorithm>
 
 #include "DecoderPDSCH.h"
 
@@ -64,14 +65,36 @@ void DecoderPDSCH::generateReferences()
 bool DecoderPDSCH::addRNTI(unsigned rnti, string s)
 {
     auto r = _rntis.insert(pair<unsigned, string>(rnti, s));
+    if (r.second) lte_rnti_set_add(&_rntiSet, rnti);
+    _searchStale = true;
     return r.second;
 }
 
 bool DecoderPDSCH::delRNTI(unsigned rnti)
 {
+    lte_rnti_set_del(&_rntiSet, rnti);
+    _searchStale = true;
     return _rntis.erase(rnti);
 }
 
+void DecoderPDSCH::setTurboIterations(int maxIter, int stop)
+{
+    _turboIter = maxIter;
+    _turboStop = stop;
+}
+
+void DecoderPDSCH::setTurboWindow(int window, int train)
+{
+    _turboWindow = window;
+    _turboTrain = train;
+}
+
+struct lte_pdsch_iter_stats DecoderPDSCH::turboStats() const
+{
+    lock_guard<mutex> guard(_statsLock);
+    return _turboStats;
+}
+
 void DecoderPDSCH::generateSequences()
 {
     unsigned c_init;
@@ -96,73 +119,107 @@ void DecoderPDSCH::initSubframes()
 
     for (auto &s : _subframes) {
         lte_subframe_free(s);
-        s = lte_subframe_alloc(_rbs, _cellId, _txAntennas, m1, m2);
+        s = nullptr;
     }
+
+    if (lte_subframe_alloc_chans(_subframes.data(), _subframes.size(),
+                                 _rbs, _cellId, _txAntennas, m1, m2) < 0)
+        LOG_PDSCH_ERR("Subframe allocation failed");
 }
 
-void DecoderPDSCH::readBufferState(shared_ptr<LteBuffer> lbuf)
+void DecoderPDSCH::readBufferState(LteBuffer &lbuf)
 {
-    auto &m1 = _pdcchRefMaps[lbuf->sfn * 2 + 0];
-    auto &m2 = _pdcchRefMaps[lbuf->sfn * 2 + 1];
+    auto &m1 = _pdcchRefMaps[lbuf.sfn * 2 + 0];
+    auto &m2 = _pdcchRefMaps[lbuf.sfn * 2 + 1];
 
     /*
      * Reinitialization on cellid change
      */
     bool idChange = !_cellIdValid ||
-                    lbuf->cellId     != _cellId ||
-                    lbuf->txAntennas != _txAntennas ||
-                    lbuf->rbs        != _rbs ||
-                    lbuf->ng         != _ng;
+                    lbuf.cellId     != _cellId ||
+                    lbuf.txAntennas != _txAntennas ||
+                    lbuf.rbs        != _rbs ||
+                    lbuf.ng         != _ng;
 
     if (idChange)
-        setCellId(lbuf->cellId, lbuf->rbs, lbuf->ng, lbuf->txAntennas);
+        setCellId(lbuf.cellId, lbuf.rbs, lbuf.ng, lbuf.txAntennas);
     else
         for (auto &s : _subframes) lte_subframe_reset(s, m1, m2);
 
     /* Allow multi-channel decoder with single channel sample input */
-    auto convert = [](vector<complex<float>> &buf, struct cxvec *vec) {
-        copy(begin(buf), end(buf), (complex<float> *) cxvec_data(vec));
+    auto convert = [&lbuf](complex<float> *buf, struct cxvec *vec) {
+        copy_n(buf, lbuf.len, (complex<float> *) cxvec_data(vec));
     };
 
-    auto b = begin(lbuf->buffers);
+    auto b = begin(lbuf.buffers);
     for (auto &s : _subframes) {
-        if (b != end(lbuf->buffers)) convert(*b++, s->samples);
+        if (b != end(lbuf.buffers)) convert(*b++, s->samples);
         else break;
     }
 
     /* Set initial return values back to the synchronizer */
-    lbuf->freqOffset = 0.0;
-    lbuf->crcValid = false;
+    lbuf.freqOffset = 0.0;
+    lbuf.crcValid = false;
 }
 
-void DecoderPDSCH::decode(shared_ptr<LteBuffer> lbuf, int cfi)
+/* Merge discovered RNTIs whenever the table changes */
+const struct lte_rnti_set *DecoderPDSCH::searchSet()
 {
-    auto scramSeq = _pdcchScramSeq[lbuf->sfn];
+    if (!_rntiTable) return &_rntiSet;
+
+    if (_searchStale || _rntiTable->generation() != _searchGen) {
+        _searchGen = _rntiTable->active(&_searchSet);
+        for (auto &r : _rntis) lte_rnti_set_add(&_searchSet, r.first);
+        _searchStale = false;
+    }
+
+    return &_searchSet;
+}
+
+void DecoderPDSCH::decode(LteBuffer &lbuf, int cfi)
+{
+    auto scramSeq = _pdcchScramSeq[lbuf.sfn];
+    auto exec = _executor ? _executor->exec() : nullptr;
 
     struct lte_time t {
-        .frame = lbuf->fn,
-        .subframe = lbuf->sfn,
+        .frame = lbuf.fn,
+        .subframe = lbuf.sfn,
     };
 
-    for (auto &r : _rntis) {
-        auto ndci = lte_decode_pdcch(_subframes.data(),
-                                     _subframes.size(),
-                                     cfi,
-                                     _cellId,
-                                     _ng,
-                                     r.first,
-                                     scramSeq.data());
-        while (--ndci >= 0) {
-            if (lte_decode_pdsch(_subframes.data(),
+    /* One search covers all monitored RNTIs */
+    auto ndci = lte_decode_pdcch(_subframes.data(),
                                  _subframes.size(),
-                                 _block, cfi, ndci, &t) > 0) {
-                lbuf->crcValid = true;
-                int len;
-                auto data = (const char *) lte_pdsch_blk_abuf(_block, &len);
-                _decoderASN1->send(data, len/8, r.first);
-            }
+                                 _pdcch,
+                                 cfi,
+                                 _cellId,
+                                 _ng,
+                                 searchSet(),
+                                 scramSeq.data(),
+                                 exec);
+
+    if (_rntiTable) {
+        const struct lte_pdcch_rnti *found;
+        auto num = lte_pdcch_dec_found(_pdcch, &found);
+        _rntiTable->update(lbuf.seq, found, num);
+    }
+    while (--ndci >= 0) {
+        if (lte_decode_pdsch(_subframes.data(),
+                             _subframes.size(),
+                             _pdsch, _block, cfi, ndci, &t) > 0) {
+            lbuf.crcValid = true;
+            int len;
+            auto data = (const char *) lte_pdsch_blk_abuf(_block, &len);
+
+            /* Held until the reorder buffer releases this subframe */
+            lbuf.pdus.push_back({ _subframes[0]->dci[ndci].rnti,
+                                  lbuf.pduData.size(),
+                                  (size_t) len / 8 });
+            lbuf.pduData.insert(end(lbuf.pduData), data, data + len / 8);
         }
     }
+
+    lock_guard<mutex> guard(_statsLock);
+    _turboStats = *lte_pdsch_blk_stats(_block);
 }
 
 void DecoderPDSCH::start()
@@ -170,14 +227,22 @@ void DecoderPDSCH::start()
     struct lte_pcfich_info info;
 
     if (_block == nullptr) _block = lte_pdsch_blk_alloc();
+    if (_pdcch == nullptr) _pdcch = lte_pdcch_dec_alloc();
+    if (_pdsch == nullptr) _pdsch = lte_pdsch_dec_alloc();
+    lte_pdcch_dec_discover(_pdcch, _rntiTable != nullptr);
+    lte_pdsch_blk_set_iter(_block, _turboIter, _turboStop);
+    lte_pdsch_blk_set_window(_block, _turboWindow, _turboTrain);
+    if (_executor) lte_pdsch_blk_set_exec(_block, _executor->exec());
 
     for (;;) {
-        auto lbuf = _inboundQueue->read();
-        if (!lbuf)
+        int handle = _inboundQueue->read();
+        if (handle < 0)
             continue;
 
+        auto &lbuf = (*_pool)[handle];
+
         readBufferState(lbuf);
-        auto scramSeq = _pcfichScramSeq[lbuf->sfn];
+        auto scramSeq = _pcfichScramSeq[lbuf.sfn];
         int rc = lte_decode_pcfich(&info,
                                    _subframes.data(),
                                    _cellId,
@@ -187,7 +252,7 @@ void DecoderPDSCH::start()
 
         setFreqOffset(lbuf);
 
-        _outboundQueue->write(lbuf);
+        _reorder->commit(handle);
     }
 }
 
@@ -196,14 +261,25 @@ void DecoderPDSCH::attachInboundQueue(shared_ptr<BufferQueue> q)
     _inboundQueue = q;
 }
 
-void DecoderPDSCH::attachOutboundQueue(shared_ptr<BufferQueue> q)
+void DecoderPDSCH::attachBufferPool(shared_ptr<LteBufferPool> p)
+{
+    _pool = p;
+}
+
+void DecoderPDSCH::attachReorderBuffer(shared_ptr<ReorderBuffer> r)
+{
+    _reorder = r;
+}
+
+void DecoderPDSCH::attachTaskExecutor(shared_ptr<TaskExecutor> e)
 {
-    _outboundQueue = q;
+    _executor = e;
 }
 
-void DecoderPDSCH::attachDecoderASN1(shared_ptr<DecoderASN1> d)
+void DecoderPDSCH::attachRntiTable(shared_ptr<RntiTable> t)
 {
-    _decoderASN1 = d;
+    _rntiTable = t;
+    _searchStale = true;
 }
 
 void DecoderPDSCH::setCellId(unsigned cellId, unsigned rbs,
@@ -220,31 +296,35 @@ void DecoderPDSCH::setCellId(unsigned cellId, unsigned rbs,
     initSubframes();
 }
 
-void DecoderPDSCH::setFreqOffset(shared_ptr<LteBuffer> lbuf)
+void DecoderPDSCH::setFreqOffset(LteBuffer &lbuf)
 {
     auto offset = 0.0f;
 
     for (auto &s : _subframes)
         offset += lte_ofdm_offset(s);
 
-    lbuf->freqOffset = offset / _subframes.size();
+    lbuf.freqOffset = offset / _subframes.size();
 }
 
 DecoderPDSCH::DecoderPDSCH(unsigned chans)
   : _pdcchScramSeq(10, ScramSequence(LTE_PDCCH_MAX_BITS)),
     _pcfichScramSeq(10, ScramSequence(32)), _pdcchRefMaps(20),
-    _cellIdValid(false), _block(nullptr), _subframes(chans)
+    _searchGen(0), _searchStale(true),
+    _cellIdValid(false), _turboIter(LTE_PDSCH_DEF_ITER),
+    _turboStop(LTE_PDSCH_STOP_CRC), _turboWindow(0), _turboTrain(0),
+    _block(nullptr), _pdcch(nullptr), _pdsch(nullptr), _subframes(chans)
 {
+    lte_rnti_set_clear(&_rntiSet);
 }
 
 DecoderPDSCH::DecoderPDSCH(const DecoderPDSCH &d)
-  : _pdcchRefMaps(20), _block(nullptr)
+  : _pdcchRefMaps(20), _block(nullptr), _pdcch(nullptr), _pdsch(nullptr)
 {
     *this = d;
 }
 
 DecoderPDSCH::DecoderPDSCH(DecoderPDSCH &&d)
-  : _pdcchRefMaps(20), _block(nullptr)
+  : _pdcchRefMaps(20), _block(nullptr), _pdcch(nullptr), _pdsch(nullptr)
 {
     *this = move(d);
 }
@@ -262,6 +342,8 @@ DecoderPDSCH::~DecoderPDSCH()
         lte_subframe_free(s);
 
     lte_pdsch_blk_free(_block);
+    lte_pdcch_dec_free(_pdcch);
+    lte_pdsch_dec_free(_pdsch);
 }
 
 DecoderPDSCH &DecoderPDSCH::operator=(const DecoderPDSCH &d)
@@ -269,11 +351,21 @@ DecoderPDSCH &DecoderPDSCH::operator=(const DecoderPDSCH &d)
     if (this != &d) {
         for (auto &s : _subframes) lte_subframe_free(s);
         lte_pdsch_blk_free(_block);
+        lte_pdcch_dec_free(_pdcch);
+        lte_pdsch_dec_free(_pdsch);
 
         _pdcchScramSeq = d._pdcchScramSeq;
         _pcfichScramSeq = d._pcfichScramSeq;
         _rntis = d._rntis;
+        _rntiSet = d._rntiSet;
+        _searchStale = true;
+        _turboIter = d._turboIter;
+        _turboStop = d._turboStop;
+        _turboWindow = d._turboWindow;
+        _turboTrain = d._turboTrain;
         _block = nullptr;
+        _pdcch = nullptr;
+        _pdsch = nullptr;
         _cellIdValid = d._cellIdValid;
         _subframes.resize(d._subframes.size());
 
@@ -287,11 +379,21 @@ DecoderPDSCH &DecoderPDSCH::operator=(DecoderPDSCH &&d)
     if (this != &d) {
         for (auto &s : _subframes) lte_subframe_free(s);
         lte_pdsch_blk_free(_block);
+        lte_pdcch_dec_free(_pdcch);
+        lte_pdsch_dec_free(_pdsch);
 
         _pdcchScramSeq = move(d._pdcchScramSeq);
         _pcfichScramSeq = move(d._pcfichScramSeq);
         _rntis = move(d._rntis);
+        _rntiSet = d._rntiSet;
+        _searchStale = true;
+        _turboIter = d._turboIter;
+        _turboStop = d._turboStop;
+        _turboWindow = d._turboWindow;
+        _turboTrain = d._turboTrain;
         _block = nullptr;
+        _pdcch = nullptr;
+        _pdsch = nullptr;
         _cellIdValid = d._cellIdValid;
         _subframes = move(d._subframes);
 
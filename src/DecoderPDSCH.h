@@ -2,15 +2,26 @@
 #define _DECODER_PDSCH_
 
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <queue>
 #include <map>
 #include <string>
 
 #include "BufferQueue.h"
-#include "DecoderASN1.h"
+#include "LteBuffer.h"
+#include "ReorderBuffer.h"
+#include "TaskExecutor.h"
+#include "RntiTable.h"
+
+extern "C" {
+#include "lte/pdcch.h"
+#include "lte/pdsch_block.h"
+}
 
 struct lte_ref_map;
+struct lte_pdcch_dec;
+struct lte_pdsch_dec;
 typedef std::vector<int8_t> ScramSequence;
 
 class DecoderPDSCH {
@@ -24,12 +35,23 @@ public:
     DecoderPDSCH &operator=(DecoderPDSCH &&d);
 
     void attachInboundQueue(std::shared_ptr<BufferQueue> q);
-    void attachOutboundQueue(std::shared_ptr<BufferQueue> q);
-    void attachDecoderASN1(std::shared_ptr<DecoderASN1> d);
+    void attachBufferPool(std::shared_ptr<LteBufferPool> p);
+    void attachReorderBuffer(std::shared_ptr<ReorderBuffer> r);
+    void attachTaskExecutor(std::shared_ptr<TaskExecutor> e);
+
+    /* Enables blind RNTI discovery feeding and following the table */
+    void attachRntiTable(std::shared_ptr<RntiTable> t);
 
     bool addRNTI(unsigned rnti, std::string s = "");
     bool delRNTI(unsigned rnti);
 
+    /* Turbo iteration cap and LTE_PDSCH_STOP_* early termination flags */
+    void setTurboIterations(int maxIter, int stop);
+    /* Sliding window length and training steps, zero window for full block */
+    void setTurboWindow(int window, int train);
+    /* Safe to call while the decoder thread is running */
+    struct lte_pdsch_iter_stats turboStats() const;
+
     void start();
 
 private:
@@ -39,21 +61,39 @@ private:
     void generateReferences();
     void initSubframes();
 
-    void readBufferState(std::shared_ptr<LteBuffer> lbuf);
-    void setFreqOffset(std::shared_ptr<LteBuffer> lbuf);
-    void decode(std::shared_ptr<LteBuffer> lbuf, int cfi);
+    void readBufferState(LteBuffer &lbuf);
+    void setFreqOffset(LteBuffer &lbuf);
+    void decode(LteBuffer &lbuf, int cfi);
+    const struct lte_rnti_set *searchSet();
 
     std::vector<ScramSequence> _pdcchScramSeq;
     std::vector<ScramSequence> _pcfichScramSeq;
     std::map<unsigned, std::string> _rntis;
+    struct lte_rnti_set _rntiSet;
+
+    /* Configured and discovered RNTIs */
+    struct lte_rnti_set _searchSet;
+    unsigned long _searchGen;
+    bool _searchStale;
 
     bool _cellIdValid;
+    int _turboIter, _turboStop;
+    int _turboWindow, _turboTrain;
     unsigned _cellId, _rbs, _ng, _txAntennas;
 
-    std::shared_ptr<BufferQueue> _inboundQueue, _outboundQueue;
-    std::shared_ptr<DecoderASN1> _decoderASN1;
+    std::shared_ptr<BufferQueue> _inboundQueue;
+    std::shared_ptr<LteBufferPool> _pool;
+    std::shared_ptr<ReorderBuffer> _reorder;
+    std::shared_ptr<TaskExecutor> _executor;
+    std::shared_ptr<RntiTable> _rntiTable;
+
+    /* Turbo statistics copied after each subframe for other threads */
+    struct lte_pdsch_iter_stats _turboStats { };
+    mutable std::mutex _statsLock;
 
     struct lte_pdsch_blk *_block;
+    struct lte_pdcch_dec *_pdcch;
+    struct lte_pdsch_dec *_pdsch;
     std::vector<struct lte_subframe *> _subframes;
     std::vector<struct lte_ref_map *[4]> _pdcchRefMaps;
 };
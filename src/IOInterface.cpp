@@ -40,6 +40,9 @@ extern "C" {
 
 #define DEV_START_OFFSET    20
 
+/* Largest frequency offset in Hz corrected digitally before device retune */
+#define DIGITAL_FREQ_MAX    1000.0
+
 using namespace std;
 
 /*
@@ -181,11 +184,6 @@ bool IOInterface<T>::open(unsigned rbs)
         return -1;
     }
 
-    if (isFile()) {
-        _freqCorr = SignalVector(lte_subframe_len(rbs));
-        generateFreqOffset();
-    }
-
     return true;
 }
 
@@ -254,7 +252,6 @@ int IOInterface<T>::getBuffer(vector<vector<T>> &bufs,
     }
 
     _prevFrameNum = frameNum;
-    if (isFile()) applyFreqOffset(bufs);
     return shift;
 }
 
@@ -263,10 +260,7 @@ void IOInterface<T>::setFreq(double freq)
 {
     _freq = freq;
     _device->setFreq(freq);
-    if (isFile()) {
-        _offset = 0.0;
-        generateFreqOffset();
-    }
+    _offset = 0.0;
 }
 
 template <typename T>
@@ -288,13 +282,22 @@ double IOInterface<T>::getGain()
     return _gain;
 }
 
+/*
+ * Frequency offsets are corrected digitally during sample conversion. File
+ * input is always corrected digitally, while devices are retuned once the
+ * accumulated offset exceeds the digital correction range.
+ */
 template <typename T>
 void IOInterface<T>::shiftFreq(double freq)
 {
-    _device->shiftFreq(freq);
     if (isFile()) {
+        _device->shiftFreq(freq);
+        _offset += freq;
+    } else if (fabs(_offset + freq) > DIGITAL_FREQ_MAX) {
+        _device->shiftFreq(_offset + freq);
+        _offset = 0.0;
+    } else {
         _offset += freq;
-        generateFreqOffset();
     }
 }
 
@@ -302,10 +305,14 @@ template <typename T>
 void IOInterface<T>::resetFreq()
 {
     _device->resetFreq();
-    if (isFile()) {
-        _offset = 0.0;
-        generateFreqOffset();
-    }
+    _offset = 0.0;
+}
+
+/* Offset in Hz to be removed from received samples */
+template <typename T>
+double IOInterface<T>::getFreqOffset()
+{
+    return _offset;
 }
 
 template <typename T>
@@ -318,28 +325,5 @@ void IOInterface<T>::reset()
     _frameSize = 0;
 }
 
-template <typename T>
-void IOInterface<T>::generateFreqOffset()
-{
-    float n = 0;
-    double rate = get<1>(rb_rate_map[_rbs]);
-    for (auto &samp:_freqCorr) {
-        samp = complex<float>(sinf(n * _offset*2*M_PI/rate),
-                              cosf(n * _offset*2*M_PI/rate));
-        n++;
-    }
-}
-
-template <typename T>
-void IOInterface<T>::applyFreqOffset(vector<vector<T>> &bufs)
-{
-    for (auto &buf:bufs) {
-        auto it = buf.begin();
-        for (auto n:_freqCorr)
-            *it++ *= n;
-    }
-}
-
-
 template class IOInterface<complex<short>>;
 template class IOInterface<complex<float>>;
@@ -32,6 +32,7 @@ public:
 
     void shiftFreq(double offset);
     void resetFreq();
+    double getFreqOffset();
 
     int getBuffer(std::vector<std::vector<T>> &bufs,
                   unsigned frameNum, int coarse, int fine, int state);
@@ -49,10 +50,6 @@ private:
     std::string _args;
     int64_t _ts0;
     double _freq, _offset, _gain;
-
-    SignalVector _freqCorr;
-    void generateFreqOffset();
-    void applyFreqOffset(std::vector<std::vector<T>> &bufs);
 };
 
 #endif /* _IO_INTERFACE_ */
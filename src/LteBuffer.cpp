@@ -18,9 +18,67 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <stdexcept>
 #include "LteBuffer.h"
 
+extern "C" {
+#include "lte/slot.h"
+#include "dsp/fft.h"
+}
+
+/* Pad channel buffers to 64 byte cache lines */
+#define POOL_ALIGN_SAMPS        (64 / sizeof(std::complex<float>))
+
+using namespace std;
+
 LteBuffer::LteBuffer(unsigned chans)
- : buffers(chans), freqOffset(0.0), crcValid(false)
+ : freqOffset(0.0), crcValid(false), seq(0), len(0), buffers(chans)
+{
+}
+
+LteBufferPool::LteBufferPool(size_t count, unsigned chans)
+  : _len(0), _slab(nullptr), _buffers(count, LteBuffer(chans))
+{
+    for (auto rbs : { 6, 15, 25, 50, 75, 100 }) {
+        size_t len = lte_subframe_len(rbs);
+        if (len > _len) _len = len;
+    }
+
+    _stride = (_len + POOL_ALIGN_SAMPS - 1) / POOL_ALIGN_SAMPS * POOL_ALIGN_SAMPS;
+
+    size_t bytes = count * chans * _stride * sizeof(complex<float>);
+    _slab = (complex<float> *) fft_malloc(bytes);
+    if (!_slab) throw bad_alloc();
+
+    fill_n(_slab, count * chans * _stride, complex<float>(0.0f, 0.0f));
+
+    auto p = _slab;
+    for (auto &b : _buffers) {
+        for (auto &c : b.buffers) {
+            c = p;
+            p += _stride;
+        }
+    }
+}
+
+LteBufferPool::~LteBufferPool()
+{
+    fft_free_buf(_slab);
+}
+
+size_t LteBufferPool::size() const
+{
+    return _buffers.size();
+}
+
+/* Per-channel sample capacity of each slot */
+size_t LteBufferPool::capacity() const
+{
+    return _len;
+}
+
+LteBuffer &LteBufferPool::operator[](int handle)
 {
+    return _buffers.at(handle);
 }
@@ -3,6 +3,13 @@
 
 #include <vector>
 #include <complex>
+#include <stdint.h>
+
+/* Decoded MAC PDU staged in the buffer until in-order release */
+struct LtePdu {
+    uint16_t rnti;
+    size_t offset, len;
+};
 
 struct LteBuffer {
     LteBuffer(unsigned chans = 1);
@@ -18,6 +25,42 @@ struct LteBuffer {
     double freqOffset;
     bool crcValid;
 
-    std::vector<std::vector<std::complex<float>>> buffers;
+    /* Synchronizer assigned order of the subframe */
+    unsigned long seq;
+
+    std::vector<LtePdu> pdus;
+    std::vector<char> pduData;
+
+    /* Per-channel sample pointers into the pool slab */
+    size_t len;
+    std::vector<std::complex<float> *> buffers;
+};
+
+/*
+ * Subframe Buffer Pool
+ *
+ * Preallocated slots for subframes passed between the synchronizer and
+ * PDSCH decoders. Sample memory for all slots and channels is a single
+ * FFT aligned allocation sized for the largest supported bandwidth with
+ * each channel padded to a cache line. Slots are referenced by integer
+ * handles so queue hand-offs do not touch the allocator or refcounts.
+ */
+class LteBufferPool {
+public:
+    LteBufferPool(size_t count, unsigned chans = 1);
+    ~LteBufferPool();
+
+    LteBufferPool(const LteBufferPool &) = delete;
+    LteBufferPool &operator=(const LteBufferPool &) = delete;
+
+    size_t size() const;
+    size_t capacity() const;
+
+    LteBuffer &operator[](int handle);
+
+private:
+    size_t _len, _stride;
+    std::complex<float> *_slab;
+    std::vector<LteBuffer> _buffers;
 };
 #endif /* _LTE_BUFFER_H_ */
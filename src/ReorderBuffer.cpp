@@ -0,0 +1,125 @@
+/*
+ * Subframe Reorder Buffer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include "ReorderBuffer.h"
+
+extern "C" {
+#include "lte/log.h"
+}
+
+using namespace std;
+
+ReorderBuffer::ReorderBuffer(size_t window)
+  : _slots(window ? window : 1, -1), _next(0),
+    _depth(0), _maxDepth(0), _late(0)
+{
+}
+
+/* Send staged PDUs and hand the buffer back to the synchronizer */
+void ReorderBuffer::release(int handle)
+{
+    auto &lbuf = (*_pool)[handle];
+
+    for (auto &p : lbuf.pdus) {
+        _decoderASN1->send(lbuf.pduData.data() + p.offset,
+                           p.len, p.rnti);
+    }
+
+    lbuf.pdus.clear();
+    lbuf.pduData.clear();
+    _outboundQueue->write(handle);
+}
+
+/* Step past the next sequence number, releasing it if present */
+void ReorderBuffer::advance()
+{
+    auto &slot = _slots[_next % _slots.size()];
+    if (slot >= 0) {
+        release(slot);
+        slot = -1;
+        _depth--;
+    }
+    _next++;
+}
+
+void ReorderBuffer::commit(int handle)
+{
+    lock_guard<mutex> guard(_mutex);
+
+    auto &lbuf = (*_pool)[handle];
+    auto seq = lbuf.seq;
+
+    if (seq < _next) {
+        ostringstream ostr;
+        ostr << "PDSCH : Late subframe " << seq
+             << ", reorder window exceeded " << ++_late << " times";
+        LOG_ERR(ostr.str().c_str());
+
+        lbuf.freqOffset = 0.0;
+        lbuf.pdus.clear();
+        lbuf.pduData.clear();
+        _outboundQueue->write(handle);
+        return;
+    }
+
+    /* Bound latency by skipping anything older than the window */
+    while (seq >= _next + _slots.size())
+        advance();
+
+    _slots[seq % _slots.size()] = handle;
+    _depth++;
+    if (_depth > _maxDepth) _maxDepth = _depth;
+
+    while (_slots[_next % _slots.size()] >= 0)
+        advance();
+}
+
+size_t ReorderBuffer::depth()
+{
+    lock_guard<mutex> guard(_mutex);
+    return _depth;
+}
+
+size_t ReorderBuffer::maxDepth()
+{
+    lock_guard<mutex> guard(_mutex);
+    return _maxDepth;
+}
+
+unsigned long ReorderBuffer::lateCount()
+{
+    lock_guard<mutex> guard(_mutex);
+    return _late;
+}
+
+void ReorderBuffer::attachOutboundQueue(shared_ptr<BufferQueue> q)
+{
+    _outboundQueue = q;
+}
+
+void ReorderBuffer::attachBufferPool(shared_ptr<LteBufferPool> p)
+{
+    _pool = p;
+}
+
+void ReorderBuffer::attachDecoderASN1(shared_ptr<DecoderASN1> d)
+{
+    _decoderASN1 = d;
+}
@@ -0,0 +1,59 @@
+#ifndef _REORDER_BUFFER_H_
+#define _REORDER_BUFFER_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "BufferQueue.h"
+#include "LteBuffer.h"
+#include "DecoderASN1.h"
+
+/*
+ * Default reorder window in subframes
+ */
+#define REORDER_WINDOW            8
+
+/*
+ * Subframe Reorder Buffer
+ *
+ * Sits between parallel PDSCH decoders and the ASN1 output and return
+ * queue. Decoded buffers are committed by sequence number and released
+ * strictly in order, so PDUs reach Wireshark and frequency offsets reach
+ * the synchronizer in subframe order. A buffer that is more than a
+ * window behind the newest commit is skipped over and, when it finally
+ * arrives, returned without sending its PDUs or frequency estimate.
+ */
+class ReorderBuffer {
+public:
+    ReorderBuffer(size_t window = REORDER_WINDOW);
+
+    ReorderBuffer(const ReorderBuffer &) = delete;
+    ReorderBuffer &operator=(const ReorderBuffer &) = delete;
+
+    void attachOutboundQueue(std::shared_ptr<BufferQueue> q);
+    void attachBufferPool(std::shared_ptr<LteBufferPool> p);
+    void attachDecoderASN1(std::shared_ptr<DecoderASN1> d);
+
+    void commit(int handle);
+
+    /* Buffers currently held waiting on an earlier sequence number */
+    size_t depth();
+    size_t maxDepth();
+    unsigned long lateCount();
+
+private:
+    void release(int handle);
+    void advance();
+
+    std::vector<int> _slots;
+    unsigned long _next;
+    size_t _depth, _maxDepth;
+    unsigned long _late;
+
+    std::shared_ptr<BufferQueue> _outboundQueue;
+    std::shared_ptr<LteBufferPool> _pool;
+    std::shared_ptr<DecoderASN1> _decoderASN1;
+    std::mutex _mutex;
+};
+#endif /* _REORDER_BUFFER_H_ */
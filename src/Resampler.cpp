@@ -19,19 +19,20 @@
  */
 
 #include <algorithm>
+#include <stdexcept>
 #include "Resampler.h"
 
 extern "C" {
 #include "dsp/convolve.h"
+#include "dsp/polyphase.h"
 }
 
-#define INIT_OUTPUT_LEN		4096
-
 using namespace std;
 
 void Resampler::init(unsigned cutoff)
 {
-    vector<float> proto(partitions.size() * filterLen);
+    vector<float> proto(P * filterLen);
+    vector<float> taps(P * filterLen);
 
     /* 
      * Generate the prototype filter with a Blackman-harris window.
@@ -52,7 +53,7 @@ void Resampler::init(unsigned cutoff)
         sum += p;
         i++;
     }
-    scale = partitions.size() / sum;
+    scale = P / sum;
 
     /* 
      * Populate partition filters and reverse the coefficients per
@@ -60,55 +61,127 @@ void Resampler::init(unsigned cutoff)
      */
     for (int j = 0; j < filterLen; j++) {
         for (int n = 0; n < P; n++)
-            partitions[n][j] = proto[j * P + n] * scale;
+            taps[n * filterLen + filterLen - 1 - j] = proto[j * P + n] * scale;
     }
-    for (auto &p:partitions)
-        reverse(p.begin(), p.end());
+
+    auto f = poly_fir_alloc(P, filterLen, taps.data());
+    fir = shared_ptr<struct poly_fir>(f, poly_fir_free);
+    if (!fir)
+        throw runtime_error("Resampler filter allocation failed");
 }
 
+/* All outputs of the block are computed in one filter call */
 void Resampler::rotate(SignalVector &in, SignalVector &out)
 {
     if (in.begin()-in.head() < history.size())
         throw out_of_range("Insufficient input head space");
 
-    if (out.size() > paths.size())
-        generatePaths(out.size());
+    copy(history.begin(), history.end(), in.begin()-history.size());
 
-    copy(in.begin()-history.size(), in.begin(), history.begin());
-
-    auto out_iter = out.begin();
-    auto path_iter = begin(paths);
-    while (out_iter != out.end()) {
-	single_convolve((float *) &in[path_iter->first],
-                        (float *) partitions[path_iter->second].begin(),
-                        filterLen,
-                        (float *) out_iter++);
-        path_iter++;
-    }
+    poly_fir_run(fir.get(), Q, (const float *) in.begin(),
+                 (float *) out.begin(), out.size());
 
     copy(in.end()-history.size(), in.end(), history.begin());
 }
 
+/*
+ * Compute only the last 'len' outputs of the block, which must not reach
+ * into filter history, and update history
+ */
+void Resampler::rotateTail(SignalVector &in, SignalVector &out, size_t len)
+{
+    size_t start = out.size() - min(len, out.size());
+    start -= start % P;
+
+    if (Q * start / P + 1 < filterLen)
+        throw out_of_range("Insufficient input for partial block");
+
+    poly_fir_run(fir.get(), Q, (const float *) &in.begin()[Q * start / P],
+                 (float *) &out.begin()[start], out.size() - start);
+
+    update(in);
+}
+
 void Resampler::update(SignalVector &in)
 {
     copy(in.end()-history.size(), in.end(), history.begin());
 }
 
-void Resampler::generatePaths(size_t n)
+/* 16-bit input runs the fixed-point kernel */
+void Resampler::run(const complex<short> *in, complex<float> *out,
+                    size_t len, float scale)
 {
-    paths.resize(n);
+    poly_fir_run_si16(fir.get(), Q, (const short *) in,
+                      (float *) out, len, scale);
+}
 
-    int i = 0;
-    for (auto &p : paths) {
-        p = pair<int, int>((Q * i) / P, (Q * i) % P);
-        i++;
-    }
+void Resampler::run(const complex<float> *in, complex<float> *out,
+                    size_t len, float scale)
+{
+    poly_fir_run(fir.get(), Q, (const float *) in, (float *) out, len);
+    if (scale != 1.0f)
+        for_each(out, out + len, [scale](complex<float> &c) { c *= scale; });
+}
+
+/*
+ * Device buffers carry no head room, so outputs whose filter span reaches
+ * into the previous buffer are computed from a short converted copy of both
+ * buffers. All other outputs read the device samples directly.
+ */
+template <typename T>
+void Resampler::rotate(const vector<T> &prev, const vector<T> &in,
+                       SignalVector &out, float scale)
+{
+    if (P != 1)
+        throw invalid_argument("Device input requires integer decimation");
+
+    size_t h = filterLen - 1;
+    size_t m = min((h + Q - 1) / Q, out.size());
+    size_t n = m ? Q * (m - 1) + 1 : 0;
+
+    if ((prev.size() < h) || (in.size() < Q * out.size()))
+        throw out_of_range("Insufficient device input");
+
+    auto widen = [scale](const T &t) {
+        return complex<float>(t.real(), t.imag()) * scale;
+    };
+
+    auto s = transform(prev.end() - h, prev.end(), stitch.begin(), widen);
+    transform(in.begin(), in.begin() + n, s, widen);
+
+    poly_fir_run(fir.get(), Q, (const float *) s, (float *) out.begin(), m);
+    run(in.data() + Q * m, &out.begin()[m], out.size() - m, scale);
+}
+
+/* Trailing outputs only, which must not reach into the previous buffer */
+template <typename T>
+void Resampler::rotateTail(const vector<T> &in, SignalVector &out,
+                           size_t len, float scale)
+{
+    size_t start = out.size() - min(len, out.size());
+
+    if (P != 1)
+        throw invalid_argument("Device input requires integer decimation");
+    if (Q * start + 1 < filterLen)
+        throw out_of_range("Insufficient input for partial block");
+
+    run(in.data() + Q * start, &out.begin()[start], out.size() - start, scale);
 }
 
 Resampler::Resampler(unsigned P, unsigned Q, size_t filterLen)
-  : partitions(P, SignalVector(filterLen)), history(filterLen),
-    paths(INIT_OUTPUT_LEN), filterLen(filterLen), P(P), Q(Q)
+  : history(filterLen), stitch(2 * filterLen + Q), filterLen(filterLen),
+    P(P), Q(Q)
 {
     init(P > Q ? P : Q);
-    generatePaths(paths.size());
 }
+
+template void Resampler::rotate(const vector<complex<short>> &,
+                                const vector<complex<short>> &,
+                                SignalVector &, float);
+template void Resampler::rotate(const vector<complex<float>> &,
+                                const vector<complex<float>> &,
+                                SignalVector &, float);
+template void Resampler::rotateTail(const vector<complex<short>> &,
+                                    SignalVector &, size_t, float);
+template void Resampler::rotateTail(const vector<complex<float>> &,
+                                    SignalVector &, size_t, float);
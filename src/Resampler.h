@@ -1,8 +1,13 @@
 #ifndef _RESAMPLER_H_
 #define _RESAMPLER_H_
 
+#include <memory>
+#include <vector>
+#include <complex>
 #include "SignalVector.h"
 
+struct poly_fir;
+
 class Resampler {
 public:
     Resampler() = default;
@@ -15,17 +20,29 @@ public:
     Resampler& operator=(Resampler &&r) = default;
 
     void rotate(SignalVector &in, SignalVector &out);
+    void rotateTail(SignalVector &in, SignalVector &out, size_t len);
     void update(SignalVector &in);
 
+    /* Decimate device samples with history from the previous buffer */
+    template <typename T>
+    void rotate(const std::vector<T> &prev, const std::vector<T> &in,
+                SignalVector &out, float scale);
+    template <typename T>
+    void rotateTail(const std::vector<T> &in, SignalVector &out,
+                    size_t len, float scale);
+
 private:
-    std::vector<SignalVector> partitions;
-    std::vector<std::pair<int, int>> paths;
+    std::shared_ptr<struct poly_fir> fir;
     SignalVector history;
+    SignalVector stitch;
     size_t filterLen;
     unsigned P, Q;
 
     void init(unsigned Q);
-    void generatePaths(size_t n);
+    void run(const std::complex<short> *in, std::complex<float> *out,
+             size_t len, float scale);
+    void run(const std::complex<float> *in, std::complex<float> *out,
+             size_t len, float scale);
 };
 
 #endif /* _RESAMPLER_H_ */
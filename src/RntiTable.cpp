@@ -0,0 +1,138 @@
+/*
+ * Discovered RNTI Table
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <iomanip>
+#include "RntiTable.h"
+
+extern "C" {
+#include "lte/log.h"
+}
+
+using namespace std;
+
+RntiTable::RntiTable(unsigned threshold, unsigned long confirm,
+                     unsigned long timeout)
+  : _threshold(threshold ? threshold : 1),
+    _confirm(confirm), _timeout(timeout),
+    _discovered(0), _generation(0)
+{
+    lte_rnti_set_clear(&_active);
+}
+
+static void log_rnti(const char *event, uint16_t rnti, unsigned score)
+{
+    ostringstream ostr;
+    ostr << "PDCCH : " << event << " RNTI 0x" << hex << setfill('0')
+         << setw(4) << rnti << dec << ", confidence " << score;
+    LOG_CTRL(ostr.str().c_str());
+}
+
+/* Raise confidence once per subframe and activate at the threshold */
+void RntiTable::sight(uint16_t rnti, unsigned long seq)
+{
+    auto r = _entries.insert(pair<uint16_t, Entry>(rnti, { 0, seq, seq }));
+    auto &e = r.first->second;
+
+    if (!r.second && e.last == seq)
+        return;
+    if (seq > e.last)
+        e.last = seq;
+    if (e.score < 2 * _threshold)
+        e.score++;
+
+    if (e.score >= _threshold && lte_rnti_set_add(&_active, rnti)) {
+        log_rnti("Discovered", rnti, e.score);
+        _discovered++;
+        _generation++;
+    }
+}
+
+/* Drop unconfirmed RNTIs and lower confidence of silent active ones */
+void RntiTable::expire(unsigned long seq)
+{
+    for (auto it = begin(_entries); it != end(_entries);) {
+        auto &e = it->second;
+        bool active = e.score >= _threshold;
+
+        if (active ? seq <= e.last + _timeout : seq <= e.first + _confirm) {
+            it++;
+            continue;
+        }
+
+        if (!active) {
+            it = _entries.erase(it);
+            continue;
+        }
+
+        e.score--;
+        e.last = seq;
+
+        /* Released RNTIs get a new confirmation window */
+        if (e.score < _threshold) {
+            e.first = seq;
+            lte_rnti_set_del(&_active, it->first);
+            log_rnti("Expired", it->first, e.score);
+            _generation++;
+        }
+        it++;
+    }
+}
+
+void RntiTable::update(unsigned long seq,
+                       const struct lte_pdcch_rnti *found, int num)
+{
+    lock_guard<mutex> guard(_mutex);
+
+    for (int i = 0; i < num; i++)
+        sight(found[i].rnti, seq);
+
+    expire(seq);
+}
+
+unsigned long RntiTable::generation() const
+{
+    return _generation;
+}
+
+/* Copy the active set and return the generation it belongs to */
+unsigned long RntiTable::active(struct lte_rnti_set *set)
+{
+    lock_guard<mutex> guard(_mutex);
+    *set = _active;
+    return _generation;
+}
+
+size_t RntiTable::size()
+{
+    lock_guard<mutex> guard(_mutex);
+    return _entries.size();
+}
+
+size_t RntiTable::activeCount()
+{
+    lock_guard<mutex> guard(_mutex);
+    return _active.num;
+}
+
+unsigned long RntiTable::discoveredCount()
+{
+    lock_guard<mutex> guard(_mutex);
+    return _discovered;
+}
@@ -0,0 +1,74 @@
+#ifndef _RNTI_TABLE_H_
+#define _RNTI_TABLE_H_
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+extern "C" {
+#include "lte/pdcch.h"
+}
+
+/*
+ * Confidence required before a discovered RNTI is decoded, subframes
+ * allowed to reach it, and subframes without a sighting before the
+ * confidence of an active RNTI drops by one
+ */
+#define RNTI_TABLE_THRESHOLD      3
+#define RNTI_TABLE_CONFIRM        200
+#define RNTI_TABLE_TIMEOUT        1000
+
+/*
+ * Discovered RNTI Table
+ *
+ * Shared by PDSCH decoders running blind RNTI discovery. Every verified
+ * PDCCH candidate is a sighting of its RNTI, counted at most once per
+ * subframe, and raises the confidence of that RNTI up to twice the
+ * threshold. RNTIs at or above the threshold are active and searched like
+ * configured RNTIs. Falsely verified candidates rarely repeat an RNTI, so
+ * pending entries are dropped unless confirmed within a short window of
+ * their first sighting.
+ * Each timeout without a sighting lowers the confidence of an active RNTI
+ * by one until released RNTIs fall back to pending and age out.
+ */
+class RntiTable {
+public:
+    RntiTable(unsigned threshold = RNTI_TABLE_THRESHOLD,
+              unsigned long confirm = RNTI_TABLE_CONFIRM,
+              unsigned long timeout = RNTI_TABLE_TIMEOUT);
+
+    RntiTable(const RntiTable &) = delete;
+    RntiTable &operator=(const RntiTable &) = delete;
+
+    /* Record verified candidates of the subframe with sequence number */
+    void update(unsigned long seq, const struct lte_pdcch_rnti *found,
+                int num);
+
+    /* Incremented on every change of the active set */
+    unsigned long generation() const;
+    unsigned long active(struct lte_rnti_set *set);
+
+    size_t size();
+    size_t activeCount();
+    unsigned long discoveredCount();
+
+private:
+    struct Entry {
+        unsigned score;
+        unsigned long first;
+        unsigned long last;
+    };
+
+    void sight(uint16_t rnti, unsigned long seq);
+    void expire(unsigned long seq);
+
+    unsigned _threshold;
+    unsigned long _confirm, _timeout;
+    unsigned long _discovered;
+    std::map<uint16_t, Entry> _entries;
+    struct lte_rnti_set _active;
+    std::atomic<unsigned long> _generation;
+    std::mutex _mutex;
+};
+#endif /* _RNTI_TABLE_H_ */
@@ -357,9 +357,14 @@ bool Synchronizer<T>::decodePBCH(struct lte_time *time, struct lte_mib *mib)
 {
     struct lte_subframe *lsub[IOInterface<T>::_chans];
 
+    if (lte_subframe_alloc_chans(lsub, IOInterface<T>::_chans, 6, _cellId, 2,
+                                 _pbchRefMaps[0], _pbchRefMaps[1]) < 0) {
+        LOG_PBCH_ERR("Internal error");
+        return false;
+    }
+
     int i = 0;
     for (auto &l : lsub) {
-        l = lte_subframe_alloc(6, _cellId, 2, _pbchRefMaps[0], _pbchRefMaps[1]);
         SignalVector s(l->samples);
         _converter.convertPBCH(i++, s);
     }
@@ -87,6 +87,7 @@ void SynchronizerPBCH<T>::start()
                                   Synchronizer<T>::_rx->sync.fine, 0);
         Synchronizer<T>::_rx->sync.coarse = 0;
         Synchronizer<T>::_rx->sync.fine = 0;
+        Synchronizer<T>::_converter.setFreqOffset(IOInterface<T>::getFreqOffset());
 
         if (!_mibValid)
             drive();
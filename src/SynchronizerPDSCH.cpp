@@ -96,30 +96,37 @@ void SynchronizerPDSCH<T>::drive(int adjust)
         }
     case LTE_STATE_PDSCH:
         if (Synchronizer<T>::timePDSCH(time)) {
-            auto lbuf = IOInterface<T>::isFile() ? _inboundQueue->read() :
-                                                   _inboundQueue->readNoBlock();
-            if (!lbuf) {
-                LOG_ERR("SYNC  : Dropped frame");
+            int handle = IOInterface<T>::isFile() ? _inboundQueue->read() :
+                                                    _inboundQueue->readNoBlock();
+            if (handle < 0) {
+                ostringstream ostr;
+                ostr << "SYNC  : Dropped frame, return queue empty "
+                     << _inboundQueue->emptyCount() << " times";
+                LOG_ERR(ostr.str().c_str());
                 break;
             }
 
-            handleFreqOffset(lbuf->freqOffset);
+            auto &lbuf = (*_pool)[handle];
+            handleFreqOffset(lbuf.freqOffset);
 
-            if (lbuf->crcValid) {
+            if (lbuf.crcValid) {
                 Synchronizer<T>::_pssMisses = 0;
                 Synchronizer<T>::_sssMisses = 0;
-                lbuf->crcValid = false;
+                lbuf.crcValid = false;
             }
 
-            lbuf->rbs = mib.rbs;
-            lbuf->cellId = Synchronizer<T>::_cellId;
-            lbuf->ng = mib.phich_ng;
-            lbuf->txAntennas = mib.ant;
-            lbuf->sfn = time->subframe;
-            lbuf->fn = time->frame;
-
-            Synchronizer<T>::_converter.delayPDSCH(lbuf->buffers, adjust);
-            _outboundQueue->write(lbuf);
+            lbuf.rbs = mib.rbs;
+            lbuf.cellId = Synchronizer<T>::_cellId;
+            lbuf.ng = mib.phich_ng;
+            lbuf.txAntennas = mib.ant;
+            lbuf.sfn = time->subframe;
+            lbuf.fn = time->frame;
+            lbuf.seq = _seq++;
+
+            lbuf.len = Synchronizer<T>::_converter.delayPDSCH(lbuf.buffers,
+                                                              _pool->capacity(),
+                                                              adjust);
+            _outboundQueue->write(handle);
         }
     }
 
@@ -142,6 +149,7 @@ void SynchronizerPDSCH<T>::start()
                                               Synchronizer<T>::_rx->state == LTE_STATE_PDSCH_SYNC);
         Synchronizer<T>::_rx->sync.coarse = 0;
         Synchronizer<T>::_rx->sync.fine = 0;
+        Synchronizer<T>::_converter.setFreqOffset(IOInterface<T>::getFreqOffset());
 
         drive(shift);
         Synchronizer<T>::_converter.reset();
@@ -163,9 +171,15 @@ void SynchronizerPDSCH<T>::attachOutboundQueue(shared_ptr<BufferQueue> q)
     _outboundQueue = q;
 }
 
+template <typename T>
+void SynchronizerPDSCH<T>::attachBufferPool(shared_ptr<LteBufferPool> p)
+{
+    _pool = p;
+}
+
 template <typename T>
 SynchronizerPDSCH<T>::SynchronizerPDSCH(size_t chans)
-  : Synchronizer<T>::Synchronizer(chans), _freqOffsets(200)
+  : Synchronizer<T>::Synchronizer(chans), _freqOffsets(200), _seq(0)
 {
 }
 
@@ -3,6 +3,7 @@
 
 #include "Synchronizer.h"
 #include "BufferQueue.h"
+#include "LteBuffer.h"
 #include "FreqAverager.h"
 
 template <typename T>
@@ -12,6 +13,7 @@ public:
 
     void attachInboundQueue(std::shared_ptr<BufferQueue> q);
     void attachOutboundQueue(std::shared_ptr<BufferQueue> q);
+    void attachBufferPool(std::shared_ptr<LteBufferPool> p);
 
     void start();
 
@@ -21,7 +23,9 @@ private:
 
     std::shared_ptr<BufferQueue> _inboundQueue;
     std::shared_ptr<BufferQueue> _outboundQueue;
+    std::shared_ptr<LteBufferPool> _pool;
 
     FreqAverager _freqOffsets;
+    unsigned long _seq;
 };
 #endif /* _SYNCHRONIZER_PDSCH_ */
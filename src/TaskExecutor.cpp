@@ -0,0 +1,236 @@
+/*
+ * Work-stealing Task Executor
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <new>
+
+#include "TaskExecutor.h"
+
+/* Per-worker deque depth and idle spins before sleeping */
+#define EXEC_RING_LEN           64
+#define EXEC_SPIN_LIMIT         512
+
+using namespace std;
+
+static void runTasks(void *ctx, void (*fn)(void *, int), void *arg, int n)
+{
+    static_cast<TaskExecutor *>(ctx)->run(fn, arg, n);
+}
+
+bool TaskExecutor::push(size_t w, const Task &task)
+{
+    auto &q = *_workers[w];
+    lock_guard<mutex> guard(q.lock);
+
+    if (q.tail - q.head >= q.ring.size())
+        return false;
+
+    q.ring[q.tail++ % q.ring.size()] = task;
+    return true;
+}
+
+bool TaskExecutor::popBack(size_t w, Task &task)
+{
+    auto &q = *_workers[w];
+    lock_guard<mutex> guard(q.lock);
+
+    if (q.tail == q.head)
+        return false;
+
+    task = q.ring[--q.tail % q.ring.size()];
+    return true;
+}
+
+bool TaskExecutor::popFront(size_t w, Task &task)
+{
+    auto &q = *_workers[w];
+    lock_guard<mutex> guard(q.lock);
+
+    if (q.tail == q.head)
+        return false;
+
+    task = q.ring[q.head++ % q.ring.size()];
+    return true;
+}
+
+/* Take the oldest task from any deque other than 'w' */
+bool TaskExecutor::steal(size_t w, Task &task)
+{
+    auto n = _workers.size();
+
+    for (size_t i = 1; i <= n; i++) {
+        auto v = (w + i) % n;
+        if (v != w && popFront(v, task)) {
+            _stolen++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Completing the last task wakes the submitter. The batch lives on the
+ * submitter stack, so it is not touched once the lock is released.
+ */
+void TaskExecutor::finish(Batch *batch)
+{
+    if (batch->remaining.fetch_sub(1, memory_order_acq_rel) > 1)
+        return;
+
+    lock_guard<mutex> lock(batch->lock);
+    batch->done = true;
+    batch->cv.notify_one();
+}
+
+void TaskExecutor::execute(const Task &task)
+{
+    _queued--;
+    task.batch->fn(task.batch->arg, task.index);
+    finish(task.batch);
+}
+
+void TaskExecutor::loop(size_t w, function<void(size_t)> init)
+{
+    Task task;
+    int spins = 0;
+
+    if (init)
+        init(w);
+
+    while (!_stop.load(memory_order_relaxed)) {
+        if (popBack(w, task) || steal(w, task)) {
+            execute(task);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < EXEC_SPIN_LIMIT) {
+            this_thread::yield();
+            continue;
+        }
+
+        unique_lock<mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return _queued.load() > 0 || _stop.load(); });
+        spins = 0;
+    }
+}
+
+/*
+ * Spread tasks round-robin starting at a rotating worker so concurrent
+ * submitters do not pile onto the same deque. Tasks that do not fit run
+ * on the caller, which then steals until no queued task is left and
+ * sleeps until the tasks taken by workers complete.
+ */
+void TaskExecutor::run(void (*fn)(void *, int), void *arg, int n)
+{
+    if (_workers.empty() || n < 2) {
+        for (int i = 0; i < n; i++) fn(arg, i);
+        return;
+    }
+
+    Batch batch;
+    batch.fn = fn;
+    batch.arg = arg;
+    batch.remaining.store(n);
+    batch.done = false;
+
+    auto start = _next.fetch_add(1);
+    int queued = 0;
+
+    for (int i = 1; i < n; i++) {
+        Task task { &batch, i };
+        _queued++;
+        if (push((start + i) % _workers.size(), task)) {
+            queued++;
+        } else {
+            _queued--;
+            fn(arg, i);
+            finish(&batch);
+        }
+    }
+
+    if (queued) {
+        lock_guard<mutex> lock(_mutex);
+        _cv.notify_all();
+    }
+
+    fn(arg, 0);
+    finish(&batch);
+
+    Task task;
+    while (batch.remaining.load(memory_order_acquire) > 0 &&
+           steal(_workers.size(), task))
+        execute(task);
+
+    unique_lock<mutex> lock(batch.lock);
+    batch.cv.wait(lock, [&batch] { return batch.done; });
+}
+
+void TaskExecutor::WorkerDelete::operator()(Worker *w) const
+{
+    w->~Worker();
+    free(w);
+}
+
+const struct lte_exec *TaskExecutor::exec() const
+{
+    return &_exec;
+}
+
+size_t TaskExecutor::workers() const
+{
+    return _workers.size();
+}
+
+unsigned long TaskExecutor::stolenCount() const
+{
+    return _stolen.load();
+}
+
+TaskExecutor::TaskExecutor(unsigned workers, function<void(size_t)> init)
+  : _next(0), _queued(0), _stolen(0), _stop(false)
+{
+    _exec.run = runTasks;
+    _exec.ctx = this;
+
+    for (unsigned i = 0; i < workers; i++) {
+        void *mem;
+        if (posix_memalign(&mem, EXEC_CACHE_LINE, sizeof(Worker)))
+            throw bad_alloc();
+
+        _workers.emplace_back(new (mem) Worker());
+        _workers.back()->ring.resize(EXEC_RING_LEN);
+    }
+
+    for (unsigned i = 0; i < workers; i++)
+        _threads.push_back(thread(&TaskExecutor::loop, this, i, init));
+}
+
+TaskExecutor::~TaskExecutor()
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+
+    for (auto &t : _threads)
+        t.join();
+}
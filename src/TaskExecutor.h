@@ -0,0 +1,98 @@
+#ifndef _TASK_EXECUTOR_H_
+#define _TASK_EXECUTOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "lte/exec.h"
+}
+
+#define EXEC_CACHE_LINE         64
+#define EXEC_MAX_WORKERS        256
+
+/*
+ * Work-stealing Task Executor
+ *
+ * Pool of worker threads for parallel work within a single subframe such
+ * as turbo code blocks and PDCCH search blocks. Each worker owns a task
+ * deque; the submitting thread spreads a batch across the deques, then
+ * helps execute until the batch completes. Workers pop from the back of
+ * their own deque and steal from the front of others when idle.
+ */
+class TaskExecutor {
+public:
+    /* 'init' runs first on each worker thread, such as for placement */
+    TaskExecutor(unsigned workers,
+                 std::function<void(size_t)> init = nullptr);
+    ~TaskExecutor();
+
+    TaskExecutor(const TaskExecutor &) = delete;
+    TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+    /* Run fn(arg, i) for i in [0, n) and wait for completion */
+    void run(void (*fn)(void *, int), void *arg, int n);
+
+    /* C interface for the LTE library */
+    const struct lte_exec *exec() const;
+
+    size_t workers() const;
+    unsigned long stolenCount() const;
+
+private:
+    /* The submitter sleeps on 'cv' until 'done' is set by the last task */
+    struct Batch {
+        void (*fn)(void *, int);
+        void *arg;
+        std::atomic<int> remaining;
+        std::mutex lock;
+        std::condition_variable cv;
+        bool done;
+    };
+
+    struct Task {
+        Batch *batch;
+        int index;
+    };
+
+    /*
+     * Fixed size deque guarded by a per-worker lock. Workers are allocated
+     * on cache line boundaries, since operator new ignores extended
+     * alignment before C++17, and padded to whole cache lines.
+     */
+    struct alignas(EXEC_CACHE_LINE) Worker {
+        std::mutex lock;
+        std::vector<Task> ring;
+        size_t head = 0, tail = 0;
+    };
+
+    struct WorkerDelete {
+        void operator()(Worker *w) const;
+    };
+
+    bool push(size_t w, const Task &task);
+    bool popBack(size_t w, Task &task);
+    bool popFront(size_t w, Task &task);
+    bool steal(size_t w, Task &task);
+    void finish(Batch *batch);
+    void execute(const Task &task);
+    void loop(size_t w, std::function<void(size_t)> init);
+
+    std::vector<std::unique_ptr<Worker, WorkerDelete>> _workers;
+    std::vector<std::thread> _threads;
+    std::atomic<size_t> _next;
+    std::atomic<long> _queued;
+    std::atomic<unsigned long> _stolen;
+    std::atomic<bool> _stop;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+
+    struct lte_exec _exec;
+};
+#endif /* _TASK_EXECUTOR_H_ */
@@ -0,0 +1,114 @@
+/*
+ * Thread Placement
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <cstring>
+#include <pthread.h>
+#include "ThreadPlacement.h"
+
+extern "C" {
+#include "lte/log.h"
+}
+
+using namespace std;
+
+ThreadPlacement::ThreadPlacement(const vector<int> &cpus, int priority)
+  : _cpus(cpus), _priority(priority)
+{
+    CPU_ZERO(&_default);
+    sched_getaffinity(0, sizeof(_default), &_default);
+}
+
+bool ThreadPlacement::place(int cpu, const char *name)
+{
+    ostringstream ostr;
+    bool success = true;
+    auto self = pthread_self();
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+
+        int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+        if (rc) {
+            ostr << "APP   : " << name << " failed to pin to CPU "
+                 << cpu << " (" << strerror(rc) << ")";
+            LOG_ERR(ostr.str().c_str());
+            success = false;
+        }
+    } else {
+        pthread_setaffinity_np(self, sizeof(_default), &_default);
+    }
+
+    if (_priority > 0) {
+        struct sched_param param;
+        param.sched_priority = _priority;
+
+        int rc = pthread_setschedparam(self, SCHED_FIFO, &param);
+        if (rc) {
+            ostr.str("");
+            ostr << "APP   : " << name << " failed to set SCHED_FIFO priority "
+                 << _priority << " (" << strerror(rc) << ")";
+            LOG_ERR(ostr.str().c_str());
+            success = false;
+        }
+    }
+
+    if (cpu >= 0 && success) {
+        ostr.str("");
+        ostr << "APP   : " << name << " running on CPU " << cpu;
+        LOG_APP(ostr.str().c_str());
+    }
+
+    return success;
+}
+
+bool ThreadPlacement::placeSync()
+{
+    return place(_cpus.empty() ? -1 : _cpus[0], "Synchronizer");
+}
+
+bool ThreadPlacement::placeDecoder(unsigned index)
+{
+    ostringstream name;
+    name << "Decoder " << index;
+
+    if (_cpus.size() < 2)
+        return place(-1, name.str().c_str());
+
+    return place(_cpus[1 + index % (_cpus.size() - 1)], name.str().c_str());
+}
+
+bool ThreadPlacement::placeDefault()
+{
+    auto self = pthread_self();
+    bool success = !pthread_setaffinity_np(self, sizeof(_default), &_default);
+
+    /* Drop the SCHED_FIFO priority inherited from a placed thread */
+    if (_priority > 0) {
+        struct sched_param param;
+        param.sched_priority = 0;
+
+        if (pthread_setschedparam(self, SCHED_OTHER, &param))
+            success = false;
+    }
+
+    return success;
+}
@@ -0,0 +1,38 @@
+#ifndef _THREAD_PLACEMENT_H_
+#define _THREAD_PLACEMENT_H_
+
+#include <vector>
+#include <sched.h>
+
+/*
+ * Thread Placement
+ *
+ * Pins the synchronizer and PDSCH decoder threads to configured cores and
+ * optionally raises them to SCHED_FIFO. The first core in the list is used
+ * by the synchronizer and remaining cores are assigned to decoders in
+ * turn. Threads without an assigned core keep the affinity the process
+ * started with. Placement is applied by the thread itself before it
+ * allocates and first touches its working state, so that under the default
+ * local allocation policy memory lands on the NUMA node of its core.
+ */
+class ThreadPlacement {
+public:
+    ThreadPlacement(const std::vector<int> &cpus = {}, int priority = 0);
+
+    bool placeSync();
+    bool placeDecoder(unsigned index);
+
+    /*
+     * Restore the startup affinity and default scheduling of threads
+     * spawned by placed threads
+     */
+    bool placeDefault();
+
+private:
+    bool place(int cpu, const char *name);
+
+    std::vector<int> _cpus;
+    int _priority;
+    cpu_set_t _default;
+};
+#endif /* _THREAD_PLACEMENT_H_ */
@@ -20,6 +20,7 @@
 
 #include <malloc.h>
 #include <string.h>
+#include <math.h>
 #include "convert.h"
 
 #ifdef HAVE_CONFIG_H
@@ -219,3 +220,193 @@ void convert_short_float(float *out, short *in, int len, float scale)
 	convert_scale_si16_ps(out, in, len, scale);
 #endif
 }
+
+/*
+ * Numerically controlled oscillator
+ *
+ * Each block of samples is rotated by NCO_LANES recursive rotators, one per
+ * vector lane, that advance by the lane stride once per group of samples.
+ * Rotators are reseeded from the exact phase at the start of every block,
+ * which renormalises their magnitude and discards accumulated rounding
+ * error. Output scaling is folded into the rotator magnitude.
+ */
+#define NCO_BLOCK	1024
+#define NCO_2PI		(2.0 * 3.14159265358979323846)
+
+#if defined(HAVE_AVX2)
+#include <immintrin.h>
+
+#define NCO_CX			4
+
+typedef __m256 nco_v;
+
+#define NCO_LOAD(P)		_mm256_loadu_ps(P)
+#define NCO_STORE(P,V)		_mm256_storeu_ps(P, V)
+#define NCO_SETCX(R,I)		_mm256_setr_ps(R, I, R, I, R, I, R, I)
+#define NCO_MUL(A,B)		_mm256_mul_ps(A, B)
+#define NCO_ADDSUB(A,B)		_mm256_addsub_ps(A, B)
+#define NCO_DUPRE(A)		_mm256_moveldup_ps(A)
+#define NCO_DUPIM(A)		_mm256_movehdup_ps(A)
+#define NCO_SWAPRI(A)		_mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1))
+#define NCO_LOAD_SI16(P) \
+	_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32( \
+		_mm_loadu_si128((const __m128i *) (P))))
+#elif defined(HAVE_SSE3)
+#include <immintrin.h>
+
+#define NCO_CX			2
+
+typedef __m128 nco_v;
+
+#define NCO_LOAD(P)		_mm_loadu_ps(P)
+#define NCO_STORE(P,V)		_mm_storeu_ps(P, V)
+#define NCO_SETCX(R,I)		_mm_setr_ps(R, I, R, I)
+#define NCO_MUL(A,B)		_mm_mul_ps(A, B)
+#define NCO_ADDSUB(A,B)		_mm_addsub_ps(A, B)
+#define NCO_DUPRE(A)		_mm_moveldup_ps(A)
+#define NCO_DUPIM(A)		_mm_movehdup_ps(A)
+#define NCO_SWAPRI(A)		_mm_shuffle_ps(A, A, _MM_SHUFFLE(2, 3, 0, 1))
+#ifdef HAVE_SSE4_1
+#define NCO_LOAD_SI16(P) \
+	_mm_cvtepi32_ps(_mm_cvtepi16_epi32( \
+		_mm_loadl_epi64((const __m128i *) (P))))
+#else
+#define NCO_LOAD_SI16(P) \
+	_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), \
+		_mm_loadl_epi64((const __m128i *) (P))), 16))
+#endif
+#endif
+
+/* Rotate one sample */
+static inline void nco_rotate1(float *y, float re, float im, const float *r)
+{
+	y[0] = re * r[0] - im * r[1];
+	y[1] = re * r[1] + im * r[0];
+}
+
+#ifdef NCO_CX
+#define NCO_VECS		(NCO_LANES / NCO_CX)
+
+static inline nco_v nco_cmul(nco_v a, nco_v b)
+{
+	nco_v t = NCO_MUL(NCO_SWAPRI(a), NCO_DUPIM(b));
+
+	return NCO_ADDSUB(NCO_MUL(a, NCO_DUPRE(b)), t);
+}
+
+#define NCO_GROUPS(IN, LOAD) \
+	nco_v x, v[NCO_VECS], sv = NCO_SETCX(s[0], s[1]); \
+\
+	for (k = 0; k < NCO_VECS; k++) \
+		v[k] = NCO_LOAD(&r[2 * NCO_CX * k]); \
+\
+	for (i = 0; i + NCO_LANES <= n; i += NCO_LANES) { \
+		for (k = 0; k < NCO_VECS; k++) { \
+			x = LOAD(&IN[2 * (i + NCO_CX * k)]); \
+			x = nco_cmul(x, v[k]); \
+			NCO_STORE(&out[2 * (i + NCO_CX * k)], x); \
+			v[k] = nco_cmul(v[k], sv); \
+		} \
+	} \
+\
+	for (k = 0; k < NCO_VECS; k++) \
+		NCO_STORE(&r[2 * NCO_CX * k], v[k]);
+#else
+#define NCO_GROUPS(IN, LOAD) \
+	for (i = 0; i + NCO_LANES <= n; i += NCO_LANES) { \
+		for (k = 0; k < NCO_LANES; k++) { \
+			nco_rotate1(&out[2 * (i + k)], IN[2 * (i + k) + 0], \
+				    IN[2 * (i + k) + 1], &r[2 * k]); \
+			nco_rotate1(&r[2 * k], r[2 * k + 0], \
+				    r[2 * k + 1], s); \
+		} \
+	}
+#endif
+
+/*
+ * Rotate whole groups of NCO_LANES samples with the lane rotators 'r' and
+ * group stride 's'. Remaining samples use the rotators of the next group.
+ */
+#define NCO_KERNEL(NAME, TYPE, LOAD) \
+static void NAME(float *out, const TYPE *in, int n, float *r, const float *s) \
+{ \
+	int i, k; \
+\
+	NCO_GROUPS(in, LOAD) \
+\
+	for (k = 0; i + k < n; k++) { \
+		nco_rotate1(&out[2 * (i + k)], in[2 * (i + k) + 0], \
+			    in[2 * (i + k) + 1], &r[2 * k]); \
+	} \
+}
+
+NCO_KERNEL(nco_rotate_si16, short, NCO_LOAD_SI16)
+NCO_KERNEL(nco_rotate_ps, float, NCO_LOAD)
+
+/* Lane rotators at the current phase and the per group stride */
+static void nco_seed(const struct nco *nco, float *r, float *s, float scale)
+{
+	const double *l = nco->lanes;
+	double re = scale * cos(NCO_2PI * nco->phase);
+	double im = scale * sin(NCO_2PI * nco->phase);
+
+	for (int k = 0; k < NCO_LANES; k++) {
+		r[2 * k + 0] = re * l[2 * k + 0] - im * l[2 * k + 1];
+		r[2 * k + 1] = re * l[2 * k + 1] + im * l[2 * k + 0];
+	}
+
+	s[0] = l[2 * NCO_LANES + 0];
+	s[1] = l[2 * NCO_LANES + 1];
+}
+
+void nco_advance(struct nco *nco, int len)
+{
+	nco->phase += len * nco->freq;
+	nco->phase -= floor(nco->phase);
+}
+
+void nco_set_freq(struct nco *nco, double freq)
+{
+	nco->freq = freq;
+
+	for (int k = 0; k <= NCO_LANES; k++) {
+		nco->lanes[2 * k + 0] = cos(NCO_2PI * k * freq);
+		nco->lanes[2 * k + 1] = sin(NCO_2PI * k * freq);
+	}
+}
+
+void nco_init(struct nco *nco)
+{
+	nco->phase = 0.0;
+	nco_set_freq(nco, 0.0);
+}
+
+void convert_short_float_nco(float *out, short *in, int len,
+			     float scale, struct nco *nco)
+{
+	float r[2 * NCO_LANES], s[2];
+	int i, n;
+
+	for (i = 0; i < len; i += n) {
+		n = len - i < NCO_BLOCK ? len - i : NCO_BLOCK;
+
+		nco_seed(nco, r, s, scale);
+		nco_rotate_si16(&out[2 * i], &in[2 * i], n, r, s);
+		nco_advance(nco, n);
+	}
+}
+
+void convert_float_nco(float *out, float *in, int len,
+		       float scale, struct nco *nco)
+{
+	float r[2 * NCO_LANES], s[2];
+	int i, n;
+
+	for (i = 0; i < len; i += n) {
+		n = len - i < NCO_BLOCK ? len - i : NCO_BLOCK;
+
+		nco_seed(nco, r, s, scale);
+		nco_rotate_ps(&out[2 * i], &in[2 * i], n, r, s);
+		nco_advance(nco, n);
+	}
+}
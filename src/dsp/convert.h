@@ -4,4 +4,35 @@
 void convert_float_short(short *out, float *in, float scale, int len);
 void convert_short_float(float *out, short *in, int len, float scale);
 
+/*
+ * Numerically controlled oscillator
+ *
+ * Phase is in cycles at the next sample and frequency in cycles per sample.
+ * Lane rotations hold exp(j*2*pi*k*freq) for each vector lane 'k' with the
+ * lane stride last. Phase carries across calls so that consecutive buffers
+ * are rotated continuously.
+ */
+#define NCO_LANES	8
+
+struct nco {
+	double phase;
+	double freq;
+	double lanes[2 * (NCO_LANES + 1)];
+};
+
+void nco_init(struct nco *nco);
+void nco_set_freq(struct nco *nco, double freq);
+
+/* Advance phase over 'len' samples, which may be negative */
+void nco_advance(struct nco *nco, int len);
+
+/*
+ * Frequency shift, scale and convert 'len' interleaved complex samples in
+ * a single pass
+ */
+void convert_short_float_nco(float *out, short *in, int len,
+			     float scale, struct nco *nco);
+void convert_float_nco(float *out, float *in, int len,
+		       float scale, struct nco *nco);
+
 #endif /* CONVERT_H */
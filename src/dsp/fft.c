@@ -18,6 +18,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -56,6 +57,65 @@ struct fft_hdl {
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Wisdom file updated with each newly measured plan */
+static char *wisdom_path = NULL;
+
+/* Wisdom last loaded from or written to the file */
+static char *wisdom_saved = NULL;
+
+/*
+ * Rewrite the wisdom file if planning added wisdom. The file is written
+ * under a temporary name and renamed into place, so that an interrupted
+ * write never leaves a truncated file. Caller holds the planner lock.
+ */
+static void wisdom_update(void)
+{
+	char *wisdom, *tmp;
+	FILE *file;
+	int rc;
+
+	if (!wisdom_path)
+		return;
+
+	wisdom = fftwf_export_wisdom_to_string();
+	if (!wisdom)
+		return;
+
+	if (wisdom_saved && !strcmp(wisdom, wisdom_saved)) {
+		free(wisdom);
+		return;
+	}
+
+	tmp = malloc(strlen(wisdom_path) + 5);
+	if (!tmp) {
+		free(wisdom);
+		return;
+	}
+
+	strcpy(tmp, wisdom_path);
+	strcat(tmp, ".tmp");
+
+	file = fopen(tmp, "w");
+	if (!file) {
+		free(tmp);
+		free(wisdom);
+		return;
+	}
+
+	rc = fputs(wisdom, file) < 0;
+	rc |= fclose(file) != 0;
+
+	if (rc || rename(tmp, wisdom_path)) {
+		remove(tmp);
+		free(wisdom);
+	} else {
+		free(wisdom_saved);
+		wisdom_saved = wisdom;
+	}
+
+	free(tmp);
+}
+
 struct fft_hdl *init_fft(int reverse, int m, int many,
 			 int idist, int odist, int istride, int ostride,
 			 struct cxvec *in, struct cxvec *out, int no_align)
@@ -92,11 +152,94 @@ struct fft_hdl *init_fft(int reverse, int m, int many,
 					    ibuffer, inembed, istride, idist,
 					    obuffer, onembed, ostride, odist,
 					    direction, FFTW_MEASURE | flags);
+	if (hdl->fft_plan)
+		wisdom_update();
+	pthread_mutex_unlock(&mutex);
+
+	return hdl;
+}
+
+/*! \brief Initialize multi-dimensional batch FFT
+ *  \param[in] reverse FFT direction
+ *  \param[in] m FFT length
+ *  \param[in] dims number of batch dimensions, outermost first
+ *  \param[in] many transforms in each dimension
+ *  \param[in] idist input distance of each dimension
+ *  \param[in] odist output distance of each dimension
+ *  \param[in] in input planning buffer (FFTW aligned)
+ *  \param[in] out output planning buffer (FFTW aligned)
+ *
+ * Planning buffers are overwritten and may be released after planning. The
+ * handle must then always be run with explicit buffers of the same alignment.
+ */
+struct fft_hdl *init_fft_dims(int reverse, int m, int dims, const int *many,
+			      const int *idist, const int *odist,
+			      struct cxvec *in, struct cxvec *out)
+{
+	fftwf_iodim n = { .n = m, .is = 1, .os = 1 };
+	fftwf_iodim howmany[FFT_MAX_DIMS];
+
+	if ((dims < 1) || (dims > FFT_MAX_DIMS) || !in || !out)
+		return NULL;
+
+	struct fft_hdl *hdl = malloc(sizeof *hdl);
+	if (!hdl)
+		return NULL;
+
+	for (int i = 0; i < dims; i++) {
+		howmany[i].n = many[i];
+		howmany[i].is = idist[i];
+		howmany[i].os = odist[i];
+	}
+
+	hdl->fft_in = NULL;
+	hdl->fft_out = NULL;
+
+	pthread_mutex_lock(&mutex);
+
+	hdl->fft_plan = fftwf_plan_guru_dft(1, &n, dims, howmany,
+					    (fftwf_complex *) in->data,
+					    (fftwf_complex *) out->data,
+					    reverse ? FFTW_BACKWARD : FFTW_FORWARD,
+					    FFTW_MEASURE);
+	if (hdl->fft_plan)
+		wisdom_update();
 	pthread_mutex_unlock(&mutex);
 
+	if (!hdl->fft_plan) {
+		free(hdl);
+		return NULL;
+	}
+
 	return hdl;
 }
 
+/*! \brief Merge FFTW wisdom from a file
+ *  \param[in] path wisdom file
+ *
+ * Plans measured in a previous run are then created without measurement.
+ * The file, created if missing, is replaced whenever a newly measured plan
+ * adds wisdom so that wisdom is kept without an orderly shutdown.
+ */
+int fft_wisdom_import(const char *path)
+{
+	int rc;
+
+	pthread_mutex_lock(&mutex);
+	rc = fftwf_import_wisdom_from_filename(path);
+	free(wisdom_path);
+	wisdom_path = malloc(strlen(path) + 1);
+	if (wisdom_path)
+		strcpy(wisdom_path, path);
+
+	/* A missing or rejected file is written with the first plan */
+	free(wisdom_saved);
+	wisdom_saved = rc ? fftwf_export_wisdom_to_string() : NULL;
+	pthread_mutex_unlock(&mutex);
+
+	return rc ? 0 : -1;
+}
+
 void *fft_malloc(size_t size)
 {
 	return fftwf_malloc(size);
@@ -4,17 +4,26 @@
 #include <stddef.h>
 #include "sigvec.h"
 
+/* Maximum batch dimensions of init_fft_dims() */
+#define FFT_MAX_DIMS		3
+
 struct fft_hdl;
 
 struct fft_hdl *init_fft(int reverse, int m, int many,
 			 int idist, int odist, int istride, int ostride,
 			 struct cxvec *in, struct cxvec *out, int flags);
+struct fft_hdl *init_fft_dims(int reverse, int m, int dims, const int *many,
+			      const int *idist, const int *odist,
+			      struct cxvec *in, struct cxvec *out);
 void *fft_malloc(size_t size);
 void fft_free_hdl(struct fft_hdl *hdl);
 
 /* Free the aligned FFT buffer */
 void fft_free_buf(void *buf);
 
+/* FFTW wisdom file import, saved again as new plans are measured */
+int fft_wisdom_import(const char *path);
+
 void cxvec_fft(struct fft_hdl *hdl, struct cxvec *in, struct cxvec *out);
 
 #endif /* _FFT_H_ */
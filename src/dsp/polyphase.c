@@ -0,0 +1,551 @@
+/*
+ * Block Polyphase FIR
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <complex.h>
+
+#include "polyphase.h"
+
+#ifdef HAVE_SSE3
+#include <immintrin.h>
+#endif
+
+/*
+ * Kernels compute 'len' outputs with output 'i' written to y[i * ostride]
+ * from the 'n' complex inputs starting at x[i * istep]. Taps are stored
+ * with each real tap duplicated for the real and imaginary parts, so
+ * complex inputs multiply taps directly.
+ *
+ * Vector kernels compute blocks of four outputs. Each tap vector is loaded
+ * once per block and applied to all four outputs, with two accumulators
+ * per output to cover multiply-add latency.
+ */
+typedef void (*poly_kernel)(const float *x, const float *h, int n,
+			    int istep, float complex *y, int ostride, int len);
+
+/*
+ * 16-bit kernels accumulate 32-bit products of 16-bit samples and taps,
+ * with outputs converted to float once per output. x86 kernels multiply
+ * pairs of adjacent samples with pairs of taps, so taps are stored as pairs
+ * duplicated for the real and imaginary parts. Partitions are padded to an
+ * even number of taps.
+ */
+typedef void (*poly_kernel_si16)(const short *x, const short *h, int n,
+				 int istep, float complex *y, int ostride,
+				 int len, float scale);
+
+#define POLY_SI16_RE(J)		(4 * ((J) >> 1) + ((J) & 1))
+#define POLY_SI16_IM(J)		(4 * ((J) >> 1) + ((J) & 1) + 2)
+
+struct poly_fir {
+	int p;
+	int n;
+	float *taps;
+	short *taps16;
+	int stride16;
+	float scale16;
+	poly_kernel kernel;
+	poly_kernel_si16 kernel16;
+	const char *name;
+};
+
+/* Taps beyond the last whole vector block */
+static inline float complex poly_tail(const float *x, const float *h,
+				      int m, int n)
+{
+	float re = 0.0f, im = 0.0f;
+
+	for (int j = m; j < n; j++) {
+		re += x[2 * j + 0] * h[2 * j + 0];
+		im += x[2 * j + 1] * h[2 * j + 1];
+	}
+
+	return re + I * im;
+}
+
+static void poly_fir_generic(const float *x, const float *h, int n,
+			     int istep, float complex *y, int ostride, int len)
+{
+	for (int i = 0; i < len; i++)
+		y[i * ostride] = poly_tail(&x[2 * i * istep], h, 0, n);
+}
+
+static inline float complex poly_tail_si16(const short *x, const short *h,
+					   int m, int n, float scale)
+{
+	int re = 0, im = 0;
+
+	for (int j = m; j < n; j++) {
+		re += x[2 * j + 0] * h[POLY_SI16_RE(j)];
+		im += x[2 * j + 1] * h[POLY_SI16_IM(j)];
+	}
+
+	return scale * re + I * scale * im;
+}
+
+static void poly_fir_si16_generic(const short *x, const short *h, int n,
+				  int istep, float complex *y, int ostride,
+				  int len, float scale)
+{
+	for (int i = 0; i < len; i++)
+		y[i * ostride] = poly_tail_si16(&x[2 * i * istep], h, 0, n, scale);
+}
+
+#ifdef HAVE_SSE3
+static inline float complex poly_hsum_sse(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+
+	return _mm_cvtss_f32(v) + I * _mm_cvtss_f32(_mm_movehdup_ps(v));
+}
+
+#define POLY_SSE_MAC(A,X,H) \
+	A = _mm_add_ps(A, _mm_mul_ps(_mm_loadu_ps(X), H))
+
+/* 4 taps per step */
+static void poly_fir_sse3(const float *x, const float *h, int n,
+			  int istep, float complex *y, int ostride, int len)
+{
+	int i, j, m = n & ~3;
+	const float *x0, *x1, *x2, *x3;
+	__m128 h0, h1, a0, a1, a2, a3, b0, b1, b2, b3;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		x0 = &x[2 * (i + 0) * istep];
+		x1 = &x[2 * (i + 1) * istep];
+		x2 = &x[2 * (i + 2) * istep];
+		x3 = &x[2 * (i + 3) * istep];
+
+		a0 = a1 = a2 = a3 = _mm_setzero_ps();
+		b0 = b1 = b2 = b3 = _mm_setzero_ps();
+
+		for (j = 0; j < m; j += 4) {
+			h0 = _mm_loadu_ps(&h[2 * j + 0]);
+			h1 = _mm_loadu_ps(&h[2 * j + 4]);
+
+			POLY_SSE_MAC(a0, &x0[2 * j + 0], h0);
+			POLY_SSE_MAC(b0, &x0[2 * j + 4], h1);
+			POLY_SSE_MAC(a1, &x1[2 * j + 0], h0);
+			POLY_SSE_MAC(b1, &x1[2 * j + 4], h1);
+			POLY_SSE_MAC(a2, &x2[2 * j + 0], h0);
+			POLY_SSE_MAC(b2, &x2[2 * j + 4], h1);
+			POLY_SSE_MAC(a3, &x3[2 * j + 0], h0);
+			POLY_SSE_MAC(b3, &x3[2 * j + 4], h1);
+		}
+
+		y[(i + 0) * ostride] = poly_hsum_sse(_mm_add_ps(a0, b0)) +
+				       poly_tail(x0, h, m, n);
+		y[(i + 1) * ostride] = poly_hsum_sse(_mm_add_ps(a1, b1)) +
+				       poly_tail(x1, h, m, n);
+		y[(i + 2) * ostride] = poly_hsum_sse(_mm_add_ps(a2, b2)) +
+				       poly_tail(x2, h, m, n);
+		y[(i + 3) * ostride] = poly_hsum_sse(_mm_add_ps(a3, b3)) +
+				       poly_tail(x3, h, m, n);
+	}
+
+	poly_fir_generic(&x[2 * i * istep], h, n, istep,
+			 &y[i * ostride], ostride, len - i);
+}
+
+/*
+ * Reduce the accumulators of two outputs, each holding real and imaginary
+ * partial sums, into the two scaled complex outputs
+ */
+static inline __m128 poly_hsum2_si16_sse(__m128i a, __m128i b, __m128 scale)
+{
+	__m128i s = _mm_add_epi32(_mm_unpacklo_epi64(a, b),
+				  _mm_unpackhi_epi64(a, b));
+
+	return _mm_mul_ps(_mm_cvtepi32_ps(s), scale);
+}
+
+static inline void poly_store2_sse(float complex *y, int ostride, __m128 v)
+{
+	float t[4];
+
+	if (ostride == 1) {
+		_mm_storeu_ps((float *) y, v);
+	} else {
+		_mm_storeu_ps(t, v);
+		y[0] = t[0] + I * t[1];
+		y[ostride] = t[2] + I * t[3];
+	}
+}
+
+/* Reorder two complex samples per 64 bits into real and imaginary pairs */
+#define POLY_SSE_PAIRS(X) \
+	_mm_shufflehi_epi16(_mm_shufflelo_epi16(X, _MM_SHUFFLE(3, 1, 2, 0)), \
+			    _MM_SHUFFLE(3, 1, 2, 0))
+
+#define POLY_SSE_MADD(A,X,H) \
+	A = _mm_add_epi32(A, _mm_madd_epi16(POLY_SSE_PAIRS( \
+		_mm_loadu_si128((const __m128i *) (X))), H))
+
+/* 4 taps per step */
+static void poly_fir_si16_sse(const short *x, const short *h, int n,
+			      int istep, float complex *y, int ostride,
+			      int len, float scale)
+{
+	int i, j, m = n & ~3;
+	const short *x0, *x1, *x2, *x3;
+	__m128i h0, a0, a1, a2, a3;
+	__m128 s = _mm_set1_ps(scale);
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		x0 = &x[2 * (i + 0) * istep];
+		x1 = &x[2 * (i + 1) * istep];
+		x2 = &x[2 * (i + 2) * istep];
+		x3 = &x[2 * (i + 3) * istep];
+
+		a0 = a1 = a2 = a3 = _mm_setzero_si128();
+
+		for (j = 0; j < m; j += 4) {
+			h0 = _mm_loadu_si128((const __m128i *) &h[2 * j]);
+
+			POLY_SSE_MADD(a0, &x0[2 * j], h0);
+			POLY_SSE_MADD(a1, &x1[2 * j], h0);
+			POLY_SSE_MADD(a2, &x2[2 * j], h0);
+			POLY_SSE_MADD(a3, &x3[2 * j], h0);
+		}
+
+		poly_store2_sse(&y[(i + 0) * ostride], ostride,
+				poly_hsum2_si16_sse(a0, a1, s));
+		poly_store2_sse(&y[(i + 2) * ostride], ostride,
+				poly_hsum2_si16_sse(a2, a3, s));
+
+		if (m < n) {
+			y[(i + 0) * ostride] += poly_tail_si16(x0, h, m, n, scale);
+			y[(i + 1) * ostride] += poly_tail_si16(x1, h, m, n, scale);
+			y[(i + 2) * ostride] += poly_tail_si16(x2, h, m, n, scale);
+			y[(i + 3) * ostride] += poly_tail_si16(x3, h, m, n, scale);
+		}
+	}
+
+	poly_fir_si16_generic(&x[2 * i * istep], h, n, istep,
+			      &y[i * ostride], ostride, len - i, scale);
+}
+
+/*
+ * AVX2 and FMA are selected at runtime, so the kernel is built for those
+ * extensions regardless of the native target
+ */
+#define POLY_AVX2	__attribute__((target("avx2,fma")))
+
+POLY_AVX2 static inline float complex poly_hsum_avx2(__m256 v)
+{
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(v),
+			      _mm256_extractf128_ps(v, 1));
+
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+
+	return _mm_cvtss_f32(s) + I * _mm_cvtss_f32(_mm_movehdup_ps(s));
+}
+
+#define POLY_AVX2_MAC(A,X,H) \
+	A = _mm256_fmadd_ps(_mm256_loadu_ps(X), H, A)
+
+/* 8 taps per step */
+POLY_AVX2 static void poly_fir_avx2(const float *x, const float *h, int n,
+				    int istep, float complex *y,
+				    int ostride, int len)
+{
+	int i, j, m = n & ~7;
+	const float *x0, *x1, *x2, *x3;
+	__m256 h0, h1, a0, a1, a2, a3, b0, b1, b2, b3;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		x0 = &x[2 * (i + 0) * istep];
+		x1 = &x[2 * (i + 1) * istep];
+		x2 = &x[2 * (i + 2) * istep];
+		x3 = &x[2 * (i + 3) * istep];
+
+		a0 = a1 = a2 = a3 = _mm256_setzero_ps();
+		b0 = b1 = b2 = b3 = _mm256_setzero_ps();
+
+		for (j = 0; j < m; j += 8) {
+			h0 = _mm256_loadu_ps(&h[2 * j + 0]);
+			h1 = _mm256_loadu_ps(&h[2 * j + 8]);
+
+			POLY_AVX2_MAC(a0, &x0[2 * j + 0], h0);
+			POLY_AVX2_MAC(b0, &x0[2 * j + 8], h1);
+			POLY_AVX2_MAC(a1, &x1[2 * j + 0], h0);
+			POLY_AVX2_MAC(b1, &x1[2 * j + 8], h1);
+			POLY_AVX2_MAC(a2, &x2[2 * j + 0], h0);
+			POLY_AVX2_MAC(b2, &x2[2 * j + 8], h1);
+			POLY_AVX2_MAC(a3, &x3[2 * j + 0], h0);
+			POLY_AVX2_MAC(b3, &x3[2 * j + 8], h1);
+		}
+
+		y[(i + 0) * ostride] = poly_hsum_avx2(_mm256_add_ps(a0, b0)) +
+				       poly_tail(x0, h, m, n);
+		y[(i + 1) * ostride] = poly_hsum_avx2(_mm256_add_ps(a1, b1)) +
+				       poly_tail(x1, h, m, n);
+		y[(i + 2) * ostride] = poly_hsum_avx2(_mm256_add_ps(a2, b2)) +
+				       poly_tail(x2, h, m, n);
+		y[(i + 3) * ostride] = poly_hsum_avx2(_mm256_add_ps(a3, b3)) +
+				       poly_tail(x3, h, m, n);
+	}
+
+	poly_fir_generic(&x[2 * i * istep], h, n, istep,
+			 &y[i * ostride], ostride, len - i);
+}
+
+/* Real and imaginary pairs within each 128-bit lane */
+#define POLY_AVX2_PAIRS \
+	_mm256_setr_epi8(0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15, \
+			 0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15)
+
+#define POLY_AVX2_MADD(A,X,H,S) \
+	A = _mm256_add_epi32(A, _mm256_madd_epi16(_mm256_shuffle_epi8( \
+		_mm256_loadu_si256((const __m256i *) (X)), S), H))
+
+/* Reduce the accumulators of four outputs into the scaled outputs */
+POLY_AVX2 static inline __m256 poly_hsum4_si16_avx2(__m256i a, __m256i b,
+						    __m256i c, __m256i d,
+						    __m256 scale)
+{
+	__m256i ab = _mm256_add_epi32(_mm256_unpacklo_epi64(a, b),
+				      _mm256_unpackhi_epi64(a, b));
+	__m256i cd = _mm256_add_epi32(_mm256_unpacklo_epi64(c, d),
+				      _mm256_unpackhi_epi64(c, d));
+	__m256i s = _mm256_add_epi32(_mm256_permute2x128_si256(ab, cd, 0x20),
+				     _mm256_permute2x128_si256(ab, cd, 0x31));
+
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale);
+}
+
+/* 8 taps per step */
+POLY_AVX2 static void poly_fir_si16_avx2(const short *x, const short *h,
+					 int n, int istep, float complex *y,
+					 int ostride, int len, float scale)
+{
+	int i, j, m = n & ~7;
+	const short *x0, *x1, *x2, *x3;
+	__m256i s, h0, a0, a1, a2, a3;
+	__m256 v, sv = _mm256_set1_ps(scale);
+
+	s = POLY_AVX2_PAIRS;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		x0 = &x[2 * (i + 0) * istep];
+		x1 = &x[2 * (i + 1) * istep];
+		x2 = &x[2 * (i + 2) * istep];
+		x3 = &x[2 * (i + 3) * istep];
+
+		a0 = a1 = a2 = a3 = _mm256_setzero_si256();
+
+		for (j = 0; j < m; j += 8) {
+			h0 = _mm256_loadu_si256((const __m256i *) &h[2 * j]);
+
+			POLY_AVX2_MADD(a0, &x0[2 * j], h0, s);
+			POLY_AVX2_MADD(a1, &x1[2 * j], h0, s);
+			POLY_AVX2_MADD(a2, &x2[2 * j], h0, s);
+			POLY_AVX2_MADD(a3, &x3[2 * j], h0, s);
+		}
+
+		v = poly_hsum4_si16_avx2(a0, a1, a2, a3, sv);
+
+		if (ostride == 1) {
+			_mm256_storeu_ps((float *) &y[i], v);
+		} else {
+			poly_store2_sse(&y[(i + 0) * ostride], ostride,
+					_mm256_castps256_ps128(v));
+			poly_store2_sse(&y[(i + 2) * ostride], ostride,
+					_mm256_extractf128_ps(v, 1));
+		}
+
+		if (m < n) {
+			y[(i + 0) * ostride] += poly_tail_si16(x0, h, m, n, scale);
+			y[(i + 1) * ostride] += poly_tail_si16(x1, h, m, n, scale);
+			y[(i + 2) * ostride] += poly_tail_si16(x2, h, m, n, scale);
+			y[(i + 3) * ostride] += poly_tail_si16(x3, h, m, n, scale);
+		}
+	}
+
+	poly_fir_si16_generic(&x[2 * i * istep], h, n, istep,
+			      &y[i * ostride], ostride, len - i, scale);
+}
+#endif /* HAVE_SSE3 */
+
+static void poly_fir_select(struct poly_fir *fir)
+{
+#if defined(HAVE_SSE3)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		fir->kernel = poly_fir_avx2;
+		fir->kernel16 = poly_fir_si16_avx2;
+		fir->name = "avx2";
+	} else {
+		fir->kernel = poly_fir_sse3;
+		fir->kernel16 = poly_fir_si16_sse;
+		fir->name = "sse3";
+	}
+#else
+	fir->kernel = poly_fir_generic;
+	fir->kernel16 = poly_fir_si16_generic;
+	fir->name = "generic";
+#endif
+}
+
+/*
+ * Quantise taps with the most fractional bits for which every tap fits 16
+ * bits and full scale input cannot overflow the 32-bit accumulator
+ */
+static int poly_fir_quantise(struct poly_fir *fir, const float *taps)
+{
+	int i, j, shift;
+	float t, sum, peak = 0.0f, worst = 0.0f;
+
+	for (i = 0; i < fir->p; i++) {
+		sum = 0.0f;
+		for (j = 0; j < fir->n; j++) {
+			t = fabsf(taps[i * fir->n + j]);
+			sum += t;
+			peak = t > peak ? t : peak;
+		}
+		worst = sum > worst ? sum : worst;
+	}
+
+	for (shift = 30; shift > 0; shift--) {
+		if ((ldexpf(worst, shift) < 65535.0f) &&
+		    (ldexpf(peak, shift) < 32767.0f))
+			break;
+	}
+
+	fir->stride16 = 2 * ((fir->n + 1) & ~1);
+	fir->scale16 = ldexpf(1.0f, -shift);
+	fir->taps16 = (short *) calloc(fir->p * fir->stride16, sizeof(short));
+	if (!fir->taps16)
+		return -1;
+
+	for (i = 0; i < fir->p; i++) {
+		short *h = &fir->taps16[i * fir->stride16];
+
+		for (j = 0; j < fir->n; j++) {
+			t = ldexpf(taps[i * fir->n + j], shift);
+			h[POLY_SI16_RE(j)] = h[POLY_SI16_IM(j)] = lrintf(t);
+		}
+	}
+
+	return 0;
+}
+
+struct poly_fir *poly_fir_alloc(int p, int n, const float *taps)
+{
+	struct poly_fir *fir;
+
+	if ((p < 1) || (n < 1))
+		return NULL;
+
+	fir = (struct poly_fir *) malloc(sizeof(struct poly_fir));
+	if (!fir)
+		return NULL;
+
+	fir->p = p;
+	fir->n = n;
+	fir->taps = (float *) malloc(2 * p * n * sizeof(float));
+	if (!fir->taps) {
+		free(fir);
+		return NULL;
+	}
+
+	for (int i = 0; i < p * n; i++) {
+		fir->taps[2 * i + 0] = taps[i];
+		fir->taps[2 * i + 1] = taps[i];
+	}
+
+	if (poly_fir_quantise(fir, taps) < 0) {
+		free(fir->taps);
+		free(fir);
+		return NULL;
+	}
+
+	poly_fir_select(fir);
+
+	return fir;
+}
+
+void poly_fir_free(struct poly_fir *fir)
+{
+	if (!fir)
+		return;
+
+	free(fir->taps);
+	free(fir->taps16);
+	free(fir);
+}
+
+/*
+ * Outputs sharing a partition are 'p' outputs and 'q' inputs apart, so
+ * each of the first 'p' outputs starts one strided kernel run.
+ */
+int poly_fir_run(const struct poly_fir *fir, int q,
+		 const float *in, float *out, int len)
+{
+	int i, k, num;
+	const float complex *x;
+	float complex *y = (float complex *) out;
+
+	if ((q < 1) || (len < 0))
+		return -1;
+
+	for (i = 0; (i < fir->p) && (i < len); i++) {
+		k = (q * i) % fir->p;
+		num = (len - i + fir->p - 1) / fir->p;
+
+		x = (const float complex *) in;
+		x += (q * i) / fir->p - (fir->n - 1);
+
+		fir->kernel((const float *) x, &fir->taps[2 * k * fir->n],
+			    fir->n, q, &y[i], fir->p, num);
+	}
+
+	return len;
+}
+
+int poly_fir_run_si16(const struct poly_fir *fir, int q,
+		      const short *in, float *out, int len, float scale)
+{
+	int i, k, num;
+	const short *x;
+	float complex *y = (float complex *) out;
+
+	if ((q < 1) || (len < 0))
+		return -1;
+
+	scale *= fir->scale16;
+
+	for (i = 0; (i < fir->p) && (i < len); i++) {
+		k = (q * i) % fir->p;
+		num = (len - i + fir->p - 1) / fir->p;
+		x = &in[2 * ((q * i) / fir->p - (fir->n - 1))];
+
+		fir->kernel16(x, &fir->taps16[k * fir->stride16], fir->n,
+			      q, &y[i], fir->p, num, scale);
+	}
+
+	return len;
+}
+
+const char *poly_fir_kernel(const struct poly_fir *fir)
+{
+	return fir->name;
+}
@@ -0,0 +1,35 @@
+#ifndef _POLYPHASE_H_
+#define _POLYPHASE_H_
+
+struct poly_fir;
+
+/*
+ * Polyphase FIR with 'p' partitions of 'n' real taps each. Taps of
+ * partition 'k' start at taps[k * n] and are in convolution order, so the
+ * last tap weights the newest input sample.
+ */
+struct poly_fir *poly_fir_alloc(int p, int n, const float *taps);
+void poly_fir_free(struct poly_fir *fir);
+
+/*
+ * Resample by p/q
+ *
+ * Output 'i' applies partition (q * i) % p to the 'n' input samples ending
+ * at in[(q * i) / p]. Input must be preceded by n - 1 samples of history.
+ * Samples are interleaved complex values and lengths are in samples.
+ */
+int poly_fir_run(const struct poly_fir *fir, int q,
+		 const float *in, float *out, int len);
+
+/*
+ * Resample 16-bit interleaved complex input with taps quantised to 16 bits
+ * and 32-bit accumulation. Outputs are scaled by 'scale' relative to the
+ * float taps. Input requirements are those of poly_fir_run().
+ */
+int poly_fir_run_si16(const struct poly_fir *fir, int q,
+		      const short *in, float *out, int len, float scale);
+
+/* Name of the kernel selected for this processor */
+const char *poly_fir_kernel(const struct poly_fir *fir);
+
+#endif /* _POLYPHASE_H_ */
@@ -0,0 +1,211 @@
+/*
+ * Polyphase resampler benchmark
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <complex.h>
+
+#include "sigvec.h"
+#include "sigvec_internal.h"
+#include "convolve.h"
+#include "polyphase.h"
+
+/* Converter defaults */
+#define DEF_TAPS	384
+#define DEF_REPS	200
+
+/* Base sample rate subframe length and PSS and PBCH output lengths */
+#define SUBFRAME_LEN	30720
+#define PSS_LEN		960
+#define PBCH_LEN	1920
+
+/*
+ * Measures PSS and PBCH decimation of one subframe for each bandwidth with
+ * per-sample convolution and with the block polyphase filter on float and
+ * 16-bit input. Decimation factors follow the Converter rate map.
+ */
+struct bench_rate {
+	int rbs;
+	int decim;
+	int fft_1536;
+};
+
+static const struct bench_rate rates[] = {
+	{   6, 16, 0 },
+	{  15,  8, 0 },
+	{  25,  4, 1 },
+	{  50,  2, 1 },
+	{  75,  2, 0 },
+	{ 100,  1, 1 },
+};
+
+static double elapsed(struct timespec *t0, struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) + 1e-9 * (t1->tv_nsec - t0->tv_nsec);
+}
+
+/* Millions of output samples per second */
+static double run_single(const float *in, const float *h, int taps,
+			 float *out, int q, int len, int reps)
+{
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	for (int n = 0; n < reps; n++) {
+		for (int i = 0; i < len; i++)
+			single_convolve(&in[2 * q * i], h, taps, &out[2 * i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return (double) len * reps / elapsed(&t0, &t1) / 1e6;
+}
+
+static double run_block(const struct poly_fir *fir, const float *in,
+			float *out, int q, int len, int reps)
+{
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	for (int n = 0; n < reps; n++)
+		poly_fir_run(fir, q, in, out, len);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return (double) len * reps / elapsed(&t0, &t1) / 1e6;
+}
+
+static double run_si16(const struct poly_fir *fir, const short *in,
+		       float *out, int q, int len, int reps)
+{
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	for (int n = 0; n < reps; n++)
+		poly_fir_run_si16(fir, q, in, out, len, 1.0f);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return (double) len * reps / elapsed(&t0, &t1) / 1e6;
+}
+
+static void print_help()
+{
+	fprintf(stdout, "\nOptions:\n"
+		"  -h    This text\n"
+		"  -t    Filter taps (default = %i)\n"
+		"  -n    Subframes per measurement (default = %i)\n\n",
+		DEF_TAPS, DEF_REPS);
+}
+
+int main(int argc, char **argv)
+{
+	int option, taps = DEF_TAPS, reps = DEF_REPS;
+	int i, q, in_len, out_len;
+	float *buf, *in, *out, *h;
+	short *buf16, *in16;
+	struct cxvec *hc;
+	double single, block, si16;
+	struct poly_fir *fir;
+
+	while ((option = getopt(argc, argv, "ht:n:")) != -1) {
+		switch (option) {
+		case 't':
+			taps = atoi(optarg);
+			break;
+		case 'n':
+			reps = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			print_help();
+			return 0;
+		}
+	}
+
+	if ((taps < 1) || (reps < 1)) {
+		print_help();
+		return 1;
+	}
+
+	/* Real taps and the complex form used by single_convolve() */
+	h = malloc(taps * sizeof(float));
+	hc = cxvec_alloc_simple(taps);
+
+	for (i = 0; i < taps; i++) {
+		h[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+		hc->data[i] = h[i];
+	}
+
+	fir = poly_fir_alloc(1, taps, h);
+
+	fprintf(stdout, "Kernel %s, %i taps\n\n", poly_fir_kernel(fir), taps);
+	fprintf(stdout, "%4s %6s %6s %14s %14s %14s %8s\n", "rbs", "path",
+		"decim", "single Msps", "block Msps", "int16 Msps", "speedup");
+
+	for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+		in_len = SUBFRAME_LEN / rates[i].decim;
+		if (rates[i].fft_1536)
+			in_len = in_len * 3 / 4;
+
+		buf = malloc(2 * (in_len + taps) * sizeof(float));
+		buf16 = malloc(2 * (in_len + taps) * sizeof(short));
+		out = malloc(2 * PBCH_LEN * sizeof(float));
+
+		for (int n = 0; n < 2 * (in_len + taps); n++) {
+			buf16[n] = rand() % 4096 - 2048;
+			buf[n] = buf16[n];
+		}
+
+		in = &buf[2 * taps];
+		in16 = &buf16[2 * taps];
+
+		/* PSS at 0.96 Msps and PBCH at 1.92 Msps */
+		for (int pbch = 0; pbch < 2; pbch++) {
+			out_len = pbch ? PBCH_LEN : PSS_LEN;
+			q = in_len / out_len;
+
+			single = run_single(in, (float *) hc->data, taps,
+					    out, q, out_len, reps);
+			block = run_block(fir, in, out, q, out_len, reps);
+			si16 = run_si16(fir, in16, out, q, out_len, reps);
+
+			fprintf(stdout, "%4i %6s %6i %14.1f %14.1f %14.1f "
+				"%7.1fx\n", rates[i].rbs, pbch ? "PBCH" : "PSS",
+				q, single, block, si16, block / single);
+		}
+
+		free(buf);
+		free(buf16);
+		free(out);
+	}
+
+	poly_fir_free(fir);
+	free(h);
+	cxvec_free(hc);
+
+	return 0;
+}
@@ -0,0 +1,377 @@
+/*
+ * LTE channel estimation and equalization - Vector kernels
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LTE_CHAN_VEC_
+#define _LTE_CHAN_VEC_
+
+#include <complex.h>
+
+/*
+ * Vectors hold CV_CX interleaved complex values. Channel magnitudes are
+ * stored as complex values with zero imaginary part, so real valued
+ * operands are duplicated across both parts of each complex value. Pairs
+ * of adjacent complex values (SFBC subcarrier pairs) never straddle a
+ * 128-bit lane. Other targets, including NEON, use the scalar loops.
+ */
+#if defined(HAVE_AVX2)
+#include <immintrin.h>
+
+#define CV_CX			4
+
+typedef __m256 cv;
+
+#define CV_LOAD(P)		_mm256_loadu_ps((const float *) (P))
+#define CV_STORE(P,V)		_mm256_storeu_ps((float *) (P), V)
+#define CV_ZERO()		_mm256_setzero_ps()
+#define CV_SET1(X)		_mm256_set1_ps(X)
+#define CV_PATTERN(A,B,C,D)	_mm256_setr_ps(A, B, C, D, A, B, C, D)
+#define CV_ADD(A,B)		_mm256_add_ps(A, B)
+#define CV_MUL(A,B)		_mm256_mul_ps(A, B)
+#define CV_DIV(A,B)		_mm256_div_ps(A, B)
+#define CV_AND(A,B)		_mm256_and_ps(A, B)
+#define CV_XOR(A,B)		_mm256_xor_ps(A, B)
+#define CV_DUPRE(A)		_mm256_moveldup_ps(A)
+#define CV_DUPIM(A)		_mm256_movehdup_ps(A)
+#define CV_SWAPRI(A)		_mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1))
+#define CV_SWAPCX(A)		_mm256_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2))
+
+static inline cv cv_gather(const float complex *x, const int *idx)
+{
+	__m128i i = _mm_loadu_si128((const __m128i *) idx);
+
+	return _mm256_castpd_ps(_mm256_i32gather_pd((const double *) x, i, 8));
+}
+
+static inline void cv_scatter(float complex *x, const int *idx, cv v)
+{
+	__m128 lo = _mm256_castps256_ps128(v);
+	__m128 hi = _mm256_extractf128_ps(v, 1);
+
+	_mm_storel_pi((__m64 *) &x[idx[0]], lo);
+	_mm_storeh_pi((__m64 *) &x[idx[1]], lo);
+	_mm_storel_pi((__m64 *) &x[idx[2]], hi);
+	_mm_storeh_pi((__m64 *) &x[idx[3]], hi);
+}
+
+static inline float complex cv_hsum(cv v)
+{
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(v),
+			      _mm256_extractf128_ps(v, 1));
+
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+
+	return _mm_cvtss_f32(s) + I * _mm_cvtss_f32(_mm_movehdup_ps(s));
+}
+#elif defined(HAVE_SSE3)
+#include <immintrin.h>
+
+#define CV_CX			2
+
+typedef __m128 cv;
+
+#define CV_LOAD(P)		_mm_loadu_ps((const float *) (P))
+#define CV_STORE(P,V)		_mm_storeu_ps((float *) (P), V)
+#define CV_ZERO()		_mm_setzero_ps()
+#define CV_SET1(X)		_mm_set1_ps(X)
+#define CV_PATTERN(A,B,C,D)	_mm_setr_ps(A, B, C, D)
+#define CV_ADD(A,B)		_mm_add_ps(A, B)
+#define CV_MUL(A,B)		_mm_mul_ps(A, B)
+#define CV_DIV(A,B)		_mm_div_ps(A, B)
+#define CV_AND(A,B)		_mm_and_ps(A, B)
+#define CV_XOR(A,B)		_mm_xor_ps(A, B)
+#define CV_DUPRE(A)		_mm_moveldup_ps(A)
+#define CV_DUPIM(A)		_mm_movehdup_ps(A)
+#define CV_SWAPRI(A)		_mm_shuffle_ps(A, A, _MM_SHUFFLE(2, 3, 0, 1))
+#define CV_SWAPCX(A)		_mm_shuffle_ps(A, A, _MM_SHUFFLE(1, 0, 3, 2))
+
+static inline cv cv_gather(const float complex *x, const int *idx)
+{
+	__m128 v = _mm_loadl_pi(_mm_setzero_ps(),
+				(const __m64 *) &x[idx[0]]);
+
+	return _mm_loadh_pi(v, (const __m64 *) &x[idx[1]]);
+}
+
+static inline void cv_scatter(float complex *x, const int *idx, cv v)
+{
+	_mm_storel_pi((__m64 *) &x[idx[0]], v);
+	_mm_storeh_pi((__m64 *) &x[idx[1]], v);
+}
+
+static inline float complex cv_hsum(cv v)
+{
+	__m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+
+	return _mm_cvtss_f32(s) + I * _mm_cvtss_f32(_mm_movehdup_ps(s));
+}
+#else
+#define CV_CX			0
+#endif
+
+#if CV_CX
+/* Negate imaginary parts */
+#define CV_CONJ(A)		CV_XOR(A, CV_PATTERN(0.0f, -0.0f, 0.0f, -0.0f))
+
+/* a * conj(b) */
+static inline cv cv_mul_conj(cv a, cv b)
+{
+	cv t = CV_MUL(a, CV_DUPRE(b));
+	cv u = CV_MUL(CV_SWAPRI(a), CV_DUPIM(b));
+
+	return CV_ADD(t, CV_CONJ(u));
+}
+
+/* Squared magnitude in both parts */
+static inline cv cv_norm(cv a)
+{
+	cv t = CV_MUL(a, a);
+
+	return CV_ADD(t, CV_SWAPRI(t));
+}
+#endif
+
+/*
+ * Pilot division
+ *
+ * Divide the received values at positions 'idx' by the reference signal
+ * 'ref' and write to the same positions of 'out'. Reference values have
+ * unit magnitude, so division is a conjugate product scaled by the inverse
+ * squared magnitude.
+ */
+static inline void chan_vec_pilot_div(const float complex *in,
+				      const float complex *ref,
+				      const int *idx, float complex *out,
+				      int len)
+{
+	int i = 0;
+
+#if CV_CX
+	for (; i + CV_CX <= len; i += CV_CX) {
+		cv r = CV_LOAD(&ref[i]);
+		cv x = cv_mul_conj(cv_gather(in, &idx[i]), r);
+
+		cv_scatter(out, &idx[i], CV_DIV(x, cv_norm(r)));
+	}
+#endif
+	for (; i < len; i++) {
+		float complex r = ref[i];
+		float n = crealf(r) * crealf(r) + cimagf(r) * cimagf(r);
+
+		out[idx[i]] = in[idx[i]] * conjf(r) / n;
+	}
+}
+
+/* a = (a + b + c + d) / 2 */
+static inline void chan_vec_avg4(float complex *a, const float complex *b,
+				 const float complex *c,
+				 const float complex *d, int len)
+{
+	int i = 0;
+
+#if CV_CX
+	for (; i + CV_CX <= len; i += CV_CX) {
+		cv s = CV_ADD(CV_LOAD(&a[i]), CV_LOAD(&b[i]));
+
+		s = CV_ADD(s, CV_LOAD(&c[i]));
+		s = CV_ADD(s, CV_LOAD(&d[i]));
+		CV_STORE(&a[i], CV_MUL(s, CV_SET1(0.5f)));
+	}
+#endif
+	for (; i < len; i++)
+		a[i] = (a[i] + b[i] + c[i] + d[i]) * 0.5f;
+}
+
+/*
+ * Squared channel magnitude summed over one or two channels. Channel 'h1'
+ * may be NULL.
+ */
+static inline void chan_vec_mag(const float complex *h0,
+				const float complex *h1,
+				float complex *mag, int len)
+{
+	int i = 0;
+	float a, b;
+
+#if CV_CX
+	const cv re = CV_PATTERN(1.0f, 0.0f, 1.0f, 0.0f);
+
+	for (; i + CV_CX <= len; i += CV_CX) {
+		cv m = cv_norm(CV_LOAD(&h0[i]));
+
+		if (h1)
+			m = CV_ADD(m, cv_norm(CV_LOAD(&h1[i])));
+
+		CV_STORE(&mag[i], CV_MUL(m, re));
+	}
+#endif
+	for (; i < len; i++) {
+		a = crealf(h0[i]);
+		b = cimagf(h0[i]);
+		mag[i] = a * a + b * b;
+
+		if (h1) {
+			a = crealf(h1[i]);
+			b = cimagf(h1[i]);
+			mag[i] += a * a + b * b;
+		}
+	}
+}
+
+/* Accumulated conjugate product sum(b * conj(a)) */
+static inline float complex chan_vec_corr(const float complex *a,
+					  const float complex *b, int len)
+{
+	int i = 0;
+	float complex sum = 0.0f;
+
+#if CV_CX
+	cv s = CV_ZERO();
+
+	for (; i + CV_CX <= len; i += CV_CX)
+		s = CV_ADD(s, cv_mul_conj(CV_LOAD(&b[i]), CV_LOAD(&a[i])));
+
+	sum = cv_hsum(s);
+#endif
+	for (; i < len; i++)
+		sum += b[i] * conjf(a[i]);
+
+	return sum;
+}
+
+/*
+ * Zero-forcing combining for one transmit antenna
+ *
+ * out = (y0 * conj(h0) + y1 * conj(h1)) / (m0 + m1) with the second
+ * receive channel omitted if 'y1' is NULL.
+ */
+static inline void chan_vec_zf(const float complex *y0,
+			       const float complex *h0,
+			       const float complex *m0,
+			       const float complex *y1,
+			       const float complex *h1,
+			       const float complex *m1,
+			       float complex *out, int len)
+{
+	int i = 0;
+	float complex x;
+	float m;
+
+#if CV_CX
+	for (; i + CV_CX <= len; i += CV_CX) {
+		cv a = cv_mul_conj(CV_LOAD(&y0[i]), CV_LOAD(&h0[i]));
+		cv d = CV_DUPRE(CV_LOAD(&m0[i]));
+
+		if (y1) {
+			a = CV_ADD(a, cv_mul_conj(CV_LOAD(&y1[i]),
+						  CV_LOAD(&h1[i])));
+			d = CV_ADD(d, CV_DUPRE(CV_LOAD(&m1[i])));
+		}
+
+		CV_STORE(&out[i], CV_MUL(a, CV_DIV(CV_SET1(1.0f), d)));
+	}
+#endif
+	for (; i < len; i++) {
+		x = y0[i] * conjf(h0[i]);
+		m = crealf(m0[i]);
+
+		if (y1) {
+			x += y1[i] * conjf(h1[i]);
+			m += crealf(m1[i]);
+		}
+
+		out[i] = (1.0f / m) * x;
+	}
+}
+
+/*
+ * Alamouti (SFBC) combining for two transmit antennas
+ *
+ * Values are subcarrier pairs (k0, k1) with channels 'h0' and 'h1' of the
+ * two transmit antennas. With p(k) = y(k) * conj(h0(k)) and q(k) =
+ * conj(y(k)) * h1(k), each scaled by the inverse magnitude of its
+ * subcarrier and summed over receive channels,
+ *
+ *   x0 = p(k0) + q(k1)
+ *   x1 = p(k1) - q(k0)
+ *
+ * Receive channel 1 is omitted if 'y1' is NULL. Length is in pairs.
+ */
+static inline void chan_vec_sfbc(const float complex *y0,
+				 const float complex *h00,
+				 const float complex *h01,
+				 const float complex *m0,
+				 const float complex *y1,
+				 const float complex *h10,
+				 const float complex *h11,
+				 const float complex *m1,
+				 float complex *out, int len)
+{
+	int i = 0, k, n;
+	float complex p[2], q[2];
+	float s[2];
+
+#if CV_CX
+	const cv sign = CV_PATTERN(0.0f, 0.0f, -0.0f, -0.0f);
+	cv a, b, d;
+
+	for (; i + CV_CX / 2 <= len; i += CV_CX / 2) {
+		n = 2 * i;
+		a = cv_mul_conj(CV_LOAD(&y0[n]), CV_LOAD(&h00[n]));
+		b = cv_mul_conj(CV_LOAD(&y0[n]), CV_LOAD(&h01[n]));
+		d = CV_DUPRE(CV_LOAD(&m0[n]));
+
+		if (y1) {
+			a = CV_ADD(a, cv_mul_conj(CV_LOAD(&y1[n]),
+						  CV_LOAD(&h10[n])));
+			b = CV_ADD(b, cv_mul_conj(CV_LOAD(&y1[n]),
+						  CV_LOAD(&h11[n])));
+			d = CV_ADD(d, CV_DUPRE(CV_LOAD(&m1[n])));
+		}
+
+		d = CV_DIV(CV_SET1(1.0f), d);
+		a = CV_MUL(a, d);
+		b = CV_MUL(CV_CONJ(b), d);
+
+		CV_STORE(&out[n], CV_ADD(a, CV_XOR(CV_SWAPCX(b), sign)));
+	}
+#endif
+	for (; i < len; i++) {
+		for (k = 0; k < 2; k++) {
+			n = 2 * i + k;
+
+			p[k] = y0[n] * conjf(h00[n]);
+			q[k] = y0[n] * conjf(h01[n]);
+			s[k] = crealf(m0[n]);
+
+			if (y1) {
+				p[k] += y1[n] * conjf(h10[n]);
+				q[k] += y1[n] * conjf(h11[n]);
+				s[k] += crealf(m1[n]);
+			}
+
+			s[k] = 1.0f / s[k];
+			p[k] = s[k] * p[k];
+			q[k] = s[k] * conjf(q[k]);
+		}
+
+		out[2 * i + 0] = p[0] + q[1];
+		out[2 * i + 1] = p[1] - q[0];
+	}
+}
+#endif /* _LTE_CHAN_VEC_ */
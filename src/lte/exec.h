@@ -0,0 +1,29 @@
+#ifndef _LTE_EXEC_
+#define _LTE_EXEC_
+
+/*
+ * Parallel task hook
+ *
+ * Executes fn(arg, i) for each i in [0, n) and returns after all calls
+ * complete. Calls may run concurrently on other threads, so tasks must
+ * only write state owned by their index. A NULL executor, or one without
+ * a run callback, executes tasks serially on the calling thread.
+ */
+struct lte_exec {
+	void (*run)(void *ctx, void (*fn)(void *, int), void *arg, int n);
+	void *ctx;
+};
+
+static inline void lte_exec_run(const struct lte_exec *exec,
+				void (*fn)(void *, int), void *arg, int n)
+{
+	if (exec && exec->run && (n > 1)) {
+		exec->run(exec->ctx, fn, arg, n);
+		return;
+	}
+
+	for (int i = 0; i < n; i++)
+		fn(arg, i);
+}
+
+#endif /* _LTE_EXEC_ */
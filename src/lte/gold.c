@@ -20,6 +20,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 
 #include "ref.h"
@@ -30,28 +31,77 @@
 #define M_PI	3.14159265358979323846
 #endif
 
-static void gold_shift(unsigned *reg0, unsigned *reg1, int num)
+/*
+ * Word-parallel generation
+ *
+ * Registers hold 64 consecutive values of each m-sequence with x(n) in
+ * bit 0. Squaring the generator polynomials gives x1(n+62) = x1(n+6) +
+ * x1(n) and x2(n+62) = x2(n+6) + x2(n+4) + x2(n+2) + x2(n), so the next 32
+ * values follow from the register alone and each step outputs 32 bits.
+ *
+ * The Nc = 1600 fast-forward is linear in the initial register state. The
+ * x1 register after the jump is constant and the x2 register is the sum of
+ * the jump results of each set bit of the 31-bit initialization value.
+ */
+#define GOLD_X1_NC		0x6ac0a9a45e485840ULL
+
+static const uint64_t gold_x2_nc[31] = {
+	0x2d7ff07070889900ULL, 0x778010909199ab01ULL, 0xc27fd15153bbcf03ULL,
+	0xa98052d2d7ff0707ULL, 0x5300a5a5affe0e0eULL, 0xa6014b4b5ffc1c1cULL,
+	0x4c029696bff83838ULL, 0x98052d2d7ff07070ULL, 0x300a5a5affe0e0e1ULL,
+	0x6014b4b5ffc1c1c2ULL, 0xc029696bff838384ULL, 0x8052d2d7ff070708ULL,
+	0x00a5a5affe0e0e11ULL, 0x014b4b5ffc1c1c22ULL, 0x029696bff8383844ULL,
+	0x052d2d7ff0707088ULL, 0x0a5a5affe0e0e111ULL, 0x14b4b5ffc1c1c222ULL,
+	0x29696bff83838444ULL, 0x52d2d7ff07070889ULL, 0xa5a5affe0e0e1113ULL,
+	0x4b4b5ffc1c1c2226ULL, 0x9696bff83838444cULL, 0x2d2d7ff070708899ULL,
+	0x5a5affe0e0e11132ULL, 0xb4b5ffc1c1c22264ULL, 0x696bff83838444c8ULL,
+	0xd2d7ff0707088990ULL, 0xa5affe0e0e111320ULL, 0x4b5ffc1c1c222640ULL,
+	0x96bff83838444c80ULL,
+};
+
+static uint64_t gold_x2_init(unsigned init)
 {
-	for (int i = 0; i < num; i++) {
-		*reg0 = (((*reg0 >> 0 & 0x1) ^
-			  (*reg0 >> 3 & 0x1)) << 30) | (*reg0 >> 1);
-
-		*reg1 = (((*reg1 >> 0 & 0x1) ^
-			  (*reg1 >> 1 & 0x1) ^
-			  (*reg1 >> 2 & 0x1) ^
-			  (*reg1 >> 3 & 0x1)) << 30) | (*reg1 >> 1);
+	uint64_t reg = 0;
+
+	for (int i = 0; i < 31; i++) {
+		if (init & (1 << i))
+			reg ^= gold_x2_nc[i];
 	}
+
+	return reg;
+}
+
+static inline uint64_t gold_step_x1(uint64_t reg)
+{
+	uint64_t next = (reg >> 8) ^ (reg >> 2);
+
+	return (reg >> 32) | (next << 32);
 }
 
-/* Initialize registers and fast-forward 1600 places */
-static void init_regs(unsigned init, unsigned *reg0, unsigned *reg1)
+static inline uint64_t gold_step_x2(uint64_t reg)
 {
-	int Nc = 1600;
+	uint64_t next = (reg >> 8) ^ (reg >> 6) ^ (reg >> 4) ^ (reg >> 2);
 
-	*reg0 = 0x01;
-	*reg1 = init;
+	return (reg >> 32) | (next << 32);
+}
+
+/*
+ * 3GPP 36.211 Release 8: 7.2 Pseudo-random sequence generation
+ *
+ * Packed output with sequence value c(i) in bit (i % 32) of word (i / 32).
+ * Unused bits of the last word continue the sequence.
+ */
+void lte_gen_gold_packed(unsigned init, uint32_t *seq, int len)
+{
+	uint64_t reg0 = GOLD_X1_NC;
+	uint64_t reg1 = gold_x2_init(init);
+
+	for (int i = 0; i < (len + 31) / 32; i++) {
+		seq[i] = (uint32_t) (reg0 ^ reg1);
 
-	gold_shift(reg0, reg1, Nc);
+		reg0 = gold_step_x1(reg0);
+		reg1 = gold_step_x2(reg1);
+	}
 }
 
 /*
@@ -59,19 +109,21 @@ static void init_regs(unsigned init, unsigned *reg0, unsigned *reg1)
  */
 struct cxvec *lte_gen_gold_cxvec(unsigned init, int len)
 {
-	unsigned reg0;
-	unsigned reg1;
+	uint32_t word = 0;
+	uint64_t reg0 = GOLD_X1_NC;
+	uint64_t reg1 = gold_x2_init(init);
 
 	struct cxvec *seq;
 	seq = cxvec_alloc_simple(len);
 
-	init_regs(init, &reg0, &reg1);
-
 	for (int i = 0; i < len; i++) {
-		seq->data[i] = ((reg0 >> 0) & 0x1) ^
-			       ((reg1 >> 0) & 0x1);
+		if (!(i % 32)) {
+			word = (uint32_t) (reg0 ^ reg1);
+			reg0 = gold_step_x1(reg0);
+			reg1 = gold_step_x2(reg1);
+		}
 
-		gold_shift(&reg0, &reg1, 1);
+		seq->data[i] = (word >> (i % 32)) & 0x1;
 	}
 
 	return seq;
@@ -82,15 +134,17 @@ struct cxvec *lte_gen_gold_cxvec(unsigned init, int len)
  */
 void lte_gen_gold_seq(unsigned init, signed char *seq, int len)
 {
-	unsigned reg0;
-	unsigned reg1;
-
-	init_regs(init, &reg0, &reg1);
+	uint32_t word = 0;
+	uint64_t reg0 = GOLD_X1_NC;
+	uint64_t reg1 = gold_x2_init(init);
 
 	for (int i = 0; i < len; i++) {
-		seq[i] = ((reg0 >> 0) & 0x1) ^
-			 ((reg1 >> 0) & 0x1);
+		if (!(i % 32)) {
+			word = (uint32_t) (reg0 ^ reg1);
+			reg0 = gold_step_x1(reg0);
+			reg1 = gold_step_x2(reg1);
+		}
 
-		gold_shift(&reg0, &reg1, 1);
+		seq[i] = (word >> (i % 32)) & 0x1;
 	}
 }
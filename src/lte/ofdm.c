@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "ofdm.h"
 #include "log.h"
@@ -29,6 +30,7 @@
 #include "ref.h"
 #include "interpolate.h"
 #include "fft.h"
+#include "chan_vec.h"
 #include "sigvec_internal.h"
 
 #ifndef M_PI
@@ -37,6 +39,43 @@
 
 #define INTERP_TAPS		32
 
+/* Bandwidth and receive channel combinations */
+#define OFDM_MAX_PLANS		(6 * LTE_OFDM_MAX_CHANS)
+
+/*
+ * Receive channel group
+ *
+ * Subframes of all receive channels share sample and frequency domain
+ * buffers at fixed channel strides, so a single transform converts both
+ * slots of every channel.
+ */
+struct lte_ofdm_grp {
+	int chans;
+	int refs;
+	struct cxvec *samples;
+	struct cxvec *td;
+	struct cxvec *fd;
+	struct fft_hdl *fft;
+	struct lte_subframe *subframe[LTE_OFDM_MAX_CHANS];
+};
+
+/*
+ * Shared transform plans
+ *
+ * Plans depend only on the bandwidth and number of channels and are kept
+ * for the life of the process. Decoder threads and cell changes reuse
+ * plans instead of measuring identical transforms again.
+ */
+struct ofdm_plan {
+	int rbs;
+	int chans;
+	struct fft_hdl *fft;
+};
+
+static struct ofdm_plan ofdm_plans[OFDM_MAX_PLANS];
+static int ofdm_num_plans = 0;
+static pthread_mutex_t ofdm_plan_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Map center resource block that spans the Nyquist edge
  *
@@ -363,7 +402,9 @@ static int lte_slot_init(struct lte_subframe *subframe,
 	slot->rbs = rbs;
 	slot->subframe = subframe;
 	slot->td = cxvec_subvec(subframe->samples, start, 0, 0, slot_len);
-	slot->fd = cxvec_alloc(sym_len * 7, 0, 0, NULL, CXVEC_FLG_FFT_ALIGN);
+	slot->fd = cxvec_subvec(subframe->grp->fd,
+				(2 * subframe->chan + ns % 2) * 7 * sym_len,
+				0, 0, 7 * sym_len);
 
 	/* Initialize 7 symbols and 2 reference symbols */
 	for (int l = 0; l < 7; l++) {
@@ -397,51 +438,146 @@ static void lte_slot_free(struct lte_slot *slot)
 	cxvec_free(slot->fd);
 }
 
-static struct fft_hdl *create_fft(int rbs)
+/*
+ * Transform layout of channels, slots and symbols, outermost first. Slots
+ * are not a whole number of symbol periods apart due to the longer cyclic
+ * prefix of the first symbol.
+ */
+static void ofdm_plan_dims(int rbs, int *idist, int *odist)
 {
-	int ilen, olen;
-	struct cxvec *in = NULL, *out = NULL;
-	int slen = lte_sym_len(rbs);
-	int clen = lte_cp_len(rbs);
+	int sym_len = lte_sym_len(rbs);
+	int slot_len = lte_slot_len(rbs);
 
-	ilen = clen + slen;
-	olen = slen;
+	idist[0] = 2 * slot_len;
+	idist[1] = slot_len;
+	idist[2] = lte_cp_len(rbs) + sym_len;
 
-	in = cxvec_alloc(7 * ilen, 0 , 0, NULL, CXVEC_FLG_FFT_ALIGN);
-	out = cxvec_alloc(7 * olen, 0 , 0, NULL, CXVEC_FLG_FFT_ALIGN);
+	odist[0] = 14 * sym_len;
+	odist[1] = 7 * sym_len;
+	odist[2] = sym_len;
+}
 
-	return init_fft(0, slen, 7, ilen, olen, 1, 1, in, out, 0);
+/*
+ * Plan with scratch buffers that have the alignment of the first symbol of
+ * the group sample buffer, which the plan is then always run with
+ */
+static struct fft_hdl *ofdm_plan_create(int rbs, int chans)
+{
+	int many[3] = { chans, 2, 7 };
+	int idist[3], odist[3];
+	int pos = lte_sym_pos(rbs, 0);
+	int len = chans * lte_subframe_len(rbs);
+	int sym_len = lte_sym_len(rbs);
+	int flags = CXVEC_FLG_FFT_ALIGN;
+	struct cxvec *in, *td, *out;
+	struct fft_hdl *fft;
+
+	ofdm_plan_dims(rbs, idist, odist);
+
+	in = cxvec_alloc(len, 0, 0, NULL, flags);
+	out = cxvec_alloc(chans * 14 * sym_len, 0, 0, NULL, flags);
+	td = cxvec_subvec(in, pos, 0, 0, len - pos);
+
+	fft = init_fft_dims(0, sym_len, 3, many, idist, odist, td, out);
+
+	cxvec_free(td);
+	cxvec_free(in);
+	cxvec_free(out);
+
+	return fft;
 }
 
-struct lte_subframe *lte_subframe_alloc(int rbs, int cell_id, int tx_ants,
-					struct lte_ref_map **maps0,
-					struct lte_ref_map **maps1)
+static struct fft_hdl *ofdm_plan_get(int rbs, int chans)
 {
-	struct lte_subframe *subframe;
-	int subframe_len = lte_subframe_len(rbs);
+	int i;
+	struct fft_hdl *fft = NULL;
+
+	pthread_mutex_lock(&ofdm_plan_lock);
+
+	for (i = 0; i < ofdm_num_plans; i++) {
+		if ((ofdm_plans[i].rbs == rbs) &&
+		    (ofdm_plans[i].chans == chans)) {
+			fft = ofdm_plans[i].fft;
+			goto release;
+		}
+	}
+
+	if (ofdm_num_plans == OFDM_MAX_PLANS)
+		goto release;
+
+	fft = ofdm_plan_create(rbs, chans);
+	if (fft) {
+		ofdm_plans[ofdm_num_plans].rbs = rbs;
+		ofdm_plans[ofdm_num_plans].chans = chans;
+		ofdm_plans[ofdm_num_plans].fft = fft;
+		ofdm_num_plans++;
+	}
+
+release:
+	pthread_mutex_unlock(&ofdm_plan_lock);
+
+	return fft;
+}
+
+static void ofdm_grp_free(struct lte_ofdm_grp *grp)
+{
+	cxvec_free(grp->td);
+	cxvec_free(grp->samples);
+	cxvec_free(grp->fd);
+	free(grp);
+}
+
+static struct lte_ofdm_grp *ofdm_grp_alloc(int rbs, int chans)
+{
+	int pos = lte_sym_pos(rbs, 0);
+	int len = chans * lte_subframe_len(rbs);
 	int flags = CXVEC_FLG_FFT_ALIGN;
+	struct lte_ofdm_grp *grp;
 
-	if (subframe_len < 0)
+	grp = (struct lte_ofdm_grp *) calloc(1, sizeof(struct lte_ofdm_grp));
+	grp->chans = chans;
+	grp->samples = cxvec_alloc(len, 0, 0, NULL, flags);
+	grp->td = cxvec_subvec(grp->samples, pos, 0, 0, len - pos);
+	grp->fd = cxvec_alloc(chans * 14 * lte_sym_len(rbs),
+			      0, 0, NULL, flags);
+
+	grp->fft = ofdm_plan_get(rbs, chans);
+	if (!grp->fft) {
+		LOG_DSP_ERR("Internal FFT failure");
+		ofdm_grp_free(grp);
 		return NULL;
+	}
+
+	return grp;
+}
+
+static struct lte_subframe *subframe_alloc(struct lte_ofdm_grp *grp,
+					   int chan, int rbs, int cell_id,
+					   int tx_ants,
+					   struct lte_ref_map **maps0,
+					   struct lte_ref_map **maps1)
+{
+	struct lte_subframe *subframe;
+	int subframe_len = lte_subframe_len(rbs);
 
 	subframe = (struct lte_subframe *)
 		   calloc(1, sizeof(struct lte_subframe));
 	subframe->rbs = rbs;
 	subframe->assigned = 0;
-	subframe->samples = cxvec_alloc(subframe_len, 0, 0, NULL, flags);
+	subframe->samples = cxvec_subvec(grp->samples, chan * subframe_len,
+					 0, 0, subframe_len);
 	subframe->num_dci = 0;
 	subframe->cell_id = cell_id;
 	subframe->tx_ants = tx_ants;
+	subframe->chan = chan;
+	subframe->grp = grp;
+
+	grp->subframe[chan] = subframe;
+	grp->refs++;
 
 	lte_slot_init(subframe, maps0, 0);
 	lte_slot_init(subframe, maps1, 1);
 
-	subframe->fft = create_fft(rbs);
-	if (!subframe->fft) {
-		LOG_DSP_ERR("Internal FFT failure");
-		return NULL;
-	}
-
 	subframe->interp = init_interp(INTERP_TAPS, (float) INTERP_TAPS / 1.5f);
 
 	/* Bit reservevation table */
@@ -449,26 +585,95 @@ struct lte_subframe *lte_subframe_alloc(int rbs, int cell_id, int tx_ants,
 
 	if (init_ref_indices(subframe) < 0) {
 		LOG_DSP_ERR("Internal reference symbol failure");
-                return NULL;
+		lte_subframe_free(subframe);
+		return NULL;
 	}
 
 	return subframe;
 }
 
+/*
+ * Allocate subframes of 'chans' receive channels sharing one transform
+ */
+int lte_subframe_alloc_chans(struct lte_subframe **subframe, int chans,
+			     int rbs, int cell_id, int tx_ants,
+			     struct lte_ref_map **maps0,
+			     struct lte_ref_map **maps1)
+{
+	int i, j;
+	struct lte_ofdm_grp *grp;
+
+	for (i = 0; i < chans; i++)
+		subframe[i] = NULL;
+
+	if ((chans < 1) || (chans > LTE_OFDM_MAX_CHANS)) {
+		LOG_DSP_ARG("Invalid number of receive channels ", chans);
+		return -1;
+	}
+
+	if (lte_subframe_len(rbs) < 0)
+		return -1;
+
+	grp = ofdm_grp_alloc(rbs, chans);
+	if (!grp)
+		return -1;
+
+	for (i = 0; i < chans; i++) {
+		subframe[i] = subframe_alloc(grp, i, rbs, cell_id, tx_ants,
+					     maps0, maps1);
+		if (subframe[i])
+			continue;
+
+		/* Group is released with the last subframe */
+		for (j = 0; j < i; j++) {
+			lte_subframe_free(subframe[j]);
+			subframe[j] = NULL;
+		}
+
+		return -1;
+	}
+
+	return 0;
+}
+
+struct lte_subframe *lte_subframe_alloc(int rbs, int cell_id, int tx_ants,
+					struct lte_ref_map **maps0,
+					struct lte_ref_map **maps1)
+{
+	struct lte_subframe *subframe;
+
+	if (lte_subframe_alloc_chans(&subframe, 1, rbs, cell_id, tx_ants,
+				     maps0, maps1) < 0)
+		return NULL;
+
+	return subframe;
+}
+
+/*
+ * Release a subframe and its channel group after the last subframe of the
+ * group is released
+ */
 void lte_subframe_free(struct lte_subframe *subframe)
 {
+	struct lte_ofdm_grp *grp;
+
 	if (!subframe)
 		return;
 
+	grp = subframe->grp;
+	grp->subframe[subframe->chan] = NULL;
+
 	lte_slot_free(&subframe->slot[0]);
 	lte_slot_free(&subframe->slot[1]);
 	cxvec_free(subframe->samples);
 
 	free_interp(subframe->interp);
-	fft_free_hdl(subframe->fft);
 
 	free(subframe->reserve);
 	free(subframe);
+
+	if (!--grp->refs)
+		ofdm_grp_free(grp);
 }
 
 static void ref_reset(struct lte_ref *ref)
@@ -491,6 +696,7 @@ int lte_subframe_reset(struct lte_subframe *subframe,
 {
 	/* Set new values */
 	subframe->assigned = 0;
+	subframe->transformed = 0;
 	subframe->num_dci = 0;
 
 	slot_reset(&subframe->slot[0], map0);
@@ -510,28 +716,27 @@ int lte_subframe_reset(struct lte_subframe *subframe,
  */
 static int lte_extract_pilots(struct lte_ref *ref, int p)
 {
-	int idx;
+	int i, idx;
 	int rbs = ref->sym->slot->rbs;
 	int res = rbs * LTE_RB_LEN;
 	int sym_len = lte_sym_len(rbs);
 
 	struct lte_ref_map *map = ref->map[p];
 	struct cxvec *refs = ref->refs[p];
-	float complex first = 0.0;
-	float complex last = 0.0;
+	float complex first, last;
+	int pos[map->len];
 
-	for (int i = 0; i < map->len; i++) {
-		idx = map->k[i] + lte_rb_pos(rbs, 0);
-		if (idx >= sym_len)
-			idx = map->k[i] - res / 2 + lte_rb_pos_mid(rbs);
+	for (i = 0; i < map->len; i++) {
+		pos[i] = map->k[i] + lte_rb_pos(rbs, 0);
+		if (pos[i] >= sym_len)
+			pos[i] = map->k[i] - res / 2 + lte_rb_pos_mid(rbs);
+	}
 
-		refs->data[idx] = ref->sym->fd->data[idx] / map->a->data[i];
+	chan_vec_pilot_div(ref->sym->fd->data, map->a->data,
+			   pos, refs->data, map->len);
 
-		if (i == 0)
-			first = refs->data[idx];
-		else if (i == map->len - 1)
-			last = refs->data[idx];
-	}
+	first = refs->data[pos[0]];
+	last = refs->data[pos[map->len - 1]];
 
 	/* Create lower virtual reference signals */
 	idx = map->k[0] + lte_rb_pos(rbs, 0);
@@ -557,30 +762,11 @@ static int lte_extract_pilots(struct lte_ref *ref, int p)
  */
 static int lte_combine_chan(struct lte_ref *ref, int ant)
 {
-	struct cxvec *chan_p0 = ref->chan[0];
+	struct cxvec *chan_p1 = ant == 2 ? ref->chan[1] : NULL;
 	struct cxvec *chan_mag = ref->chan[2];
 
-	for (int i = 0; i < chan_mag->len; i++) {
-		float a, b;
-
-		a = crealf(chan_p0->data[i]);
-		b = cimagf(chan_p0->data[i]);
-		chan_mag->data[i] = a * a + b * b;
-	}
-
-	if (ant != 2)
-		return 0;
-
-	struct cxvec *chan_p1 = ref->chan[1];
-
-	for (int i = 0; i < chan_mag->len; i++) {
-		float c, d;
-
-		c = crealf(chan_p1->data[i]);
-		d = cimagf(chan_p1->data[i]);
-		chan_mag->data[i] += c * c + d * d;
-	}
-
+	chan_vec_mag(ref->chan[0]->data, chan_p1 ? chan_p1->data : NULL,
+		     chan_mag->data, chan_mag->len);
 
 	return 0;
 }
@@ -590,6 +776,10 @@ static int lte_combine_chan(struct lte_ref *ref, int ant)
  *
  * Second stage frequency offset correction used after successful PBCH decoding.
  * Prior to PBCH decode, PSS/SSS based correction is used for wider offset range.
+ *
+ * Phase rotation between slots is the angle of the conjugate product of
+ * matching reference signals accumulated over the subframe. Unassigned
+ * positions are zero and do not contribute.
  */
 float lte_ofdm_offset(struct lte_subframe *subframe)
 {
@@ -602,49 +792,20 @@ float lte_ofdm_offset(struct lte_subframe *subframe)
 	struct lte_ref *ref3 = &subframe->slot[1].refs[1];
 
 	int len = ref0->refs[0]->len;
+	float complex sum0 = 0.0f, sum1 = 0.0f;
 
-	int a_cnt = 0, b_cnt= 0;
-
-	double ang0 = 0.0f;
-	double ang1 = 0.0f;
-
-	for (int i = 0; i < len; i++) {
-		for (int n = 0; n < 2; n++) {
-			float complex a = ref0->refs[n]->data[i];
-			float complex b = ref1->refs[n]->data[i];
-			float complex c = ref2->refs[n]->data[i];
-			float complex d = ref3->refs[n]->data[i];
-
-			if ((cabsf(a) > 0.0f) && (cabsf(c) > 0.0f)) {
-				float x = cargf(c) - cargf(a);
-				if (x > M_PI)
-					x = x - 2.0f * M_PI;
-				else if (x < -M_PI)
-					x = 2.0f * M_PI + x;
-
-				ang0 += x;
-				a_cnt++;
-			}
-
-			if ((cabsf(b) > 0.0f) && (cabsf(d) > 0.0f)) {
-				float x = cargf(d) - cargf(b);
-				if (x > M_PI)
-					x = x - 2.0f * M_PI;
-				else if (x < -M_PI)
-					x = 2.0f * M_PI + x;
-
-				ang1 += x;
-				b_cnt++;
-			}
-		}
+	for (int n = 0; n < 2; n++) {
+		sum0 += chan_vec_corr(ref0->refs[n]->data,
+				      ref2->refs[n]->data, len);
+		sum1 += chan_vec_corr(ref1->refs[n]->data,
+				      ref3->refs[n]->data, len);
 	}
 
-	if (!a_cnt || !b_cnt)
+	if ((sum0 == 0.0f) || (sum1 == 0.0f))
 		return 0.0;
 
 	/* 1000 Hz based on reference symbol spacing of one slot */
-	return ((ang1 / (float) b_cnt) +
-	        (ang0 / (float) a_cnt)) / 2.0f / M_PI * 1000.0f;
+	return cargf(sum0 + sum1) / M_PI * 1000.0f;
 }
 
 static int avg_pilots(struct lte_subframe *subframe)
@@ -654,26 +815,18 @@ static int avg_pilots(struct lte_subframe *subframe)
 	struct lte_ref *ref2 = &subframe->slot[1].refs[0];
 	struct lte_ref *ref3 = &subframe->slot[1].refs[1];
 
-	int i, len = ref0->refs[0]->len;
+	int len = ref0->refs[0]->len;
 
 	/* Antenna 0 */
-	for (i = 0; i < len; i++) {
-		ref0->refs[0]->data[i] += ref1->refs[0]->data[i];
-		ref0->refs[0]->data[i] += ref2->refs[0]->data[i];
-		ref0->refs[0]->data[i] += ref3->refs[0]->data[i];
-		ref0->refs[0]->data[i] /= 2.0f;
-	}
+	chan_vec_avg4(ref0->refs[0]->data, ref1->refs[0]->data,
+		      ref2->refs[0]->data, ref3->refs[0]->data, len);
 
 	if (subframe->tx_ants != 2)
 		return 0;
 
 	/* Antenna 1 */
-	for (i = 0; i < len; i++) {
-		ref0->refs[1]->data[i] += ref1->refs[1]->data[i];
-		ref0->refs[1]->data[i] += ref2->refs[1]->data[i];
-		ref0->refs[1]->data[i] += ref3->refs[1]->data[i];
-		ref0->refs[1]->data[i] /= 2.0f;
-	}
+	chan_vec_avg4(ref0->refs[1]->data, ref1->refs[1]->data,
+		      ref2->refs[1]->data, ref3->refs[1]->data, len);
 
 	return 0;
 }
@@ -699,17 +852,28 @@ static int lte_slot_chan_recov(struct lte_slot *slot)
 /*
  * Run the FFT
  *
- * Compute frequency domain symbols for all 7 time domain symbols. For resource
- * block combinations with split center resource blocks, re-map the center block
- * to be consistent with converted samples.
+ * Compute frequency domain symbols for all 14 time domain symbols of every
+ * receive channel in the group with a single transform.
+ */
+static void ofdm_grp_convert(struct lte_ofdm_grp *grp)
+{
+	cxvec_fft(grp->fft, grp->td, grp->fd);
+
+	for (int i = 0; i < grp->chans; i++) {
+		if (grp->subframe[i])
+			grp->subframe[i]->transformed = 1;
+	}
+}
+
+/*
+ * For resource block combinations with split center resource blocks, re-map
+ * the center block to be consistent with converted samples.
  */
 static int lte_slot_convert(struct lte_subframe *subframe, int ns)
 {
 	int edge_rb;
 	struct lte_slot *slot = &subframe->slot[ns];
 
-	cxvec_fft(subframe->fft, slot->syms[0].td, slot->fd);
-
 	switch (slot->rbs) {
 	case 15:
 		edge_rb = 7;
@@ -737,6 +901,9 @@ static int lte_subframe_convert_refs(struct lte_subframe *subframe)
 	int i, p, edge_rb;
 	struct lte_ref *ref0 = &subframe->slot[0].refs[0];
 
+	if (!subframe->transformed)
+		ofdm_grp_convert(subframe->grp);
+
 	for (i = 0; i < 2; i++) {
 		lte_slot_convert(subframe, i);
 		lte_slot_chan_recov(&subframe->slot[i]);
@@ -16,6 +16,9 @@
 
 #define LTE_REF_MASK		(LTE_SYM0_MASK | LTE_SYM4_MASK)
 
+/* Receive channels of a subframe group */
+#define LTE_OFDM_MAX_CHANS	2
+
 struct cxvec;
 struct lte_slot;
 struct lte_subframe;
@@ -24,6 +27,10 @@ struct lte_ref_map;
 struct lte_subframe *lte_subframe_alloc(int rbs, int cell_id, int ant,
 					struct lte_ref_map **maps0,
 					struct lte_ref_map **maps1);
+int lte_subframe_alloc_chans(struct lte_subframe **subframe, int chans,
+			     int rbs, int cell_id, int ant,
+			     struct lte_ref_map **maps0,
+			     struct lte_ref_map **maps1);
 void lte_subframe_free(struct lte_subframe *slot);
 
 int lte_subframe_reset(struct lte_subframe *subframe,
@@ -34,6 +34,17 @@
 #define MAX_E		1920
 #define PBCH_D		PBCH_K
 
+/* 3GPP TS 36.212 Release 8: 5.1.3.1 "Tail biting convolutional coding" */
+static const struct lte_conv_code pbch_code = {
+	.n = 3,
+	.k = 7,
+	.len = PBCH_K,
+	.gen = { 0133, 0171, 0165 },
+	.rgen = 0,
+	.punc = NULL,
+	.term = CONV_TERM_TAIL_BITING,
+};
+
 /* 3GPP TS 36.212 Release 8: 5.3.1 "Broadcast channel" */
 struct lte_pbch_blk {
 	uint8_t *a;
@@ -44,6 +55,7 @@ struct lte_pbch_blk {
 	int E;
 
 	struct lte_rate_matcher *match;
+	struct vdecoder *vdec;
 };
 
 /* Allocate transport block processing chain */
@@ -53,6 +65,7 @@ struct lte_pbch_blk *lte_pbch_blk_alloc()
 
 	cblk = (struct lte_pbch_blk *) calloc(1, sizeof(struct lte_pbch_blk));
 	cblk->match = lte_rate_matcher_alloc();
+	cblk->vdec = alloc_vdec(&pbch_code);
 
 	return cblk;
 }
@@ -64,7 +77,8 @@ void lte_pbch_blk_free(struct lte_pbch_blk *cblk)
 		return;
 
 	lte_rate_matcher_free(cblk->match);
-	cblk = NULL;
+	free_vdec(cblk->vdec);
+	free(cblk);
 }
 
 /* 3GPP TS 36.212 Release 8: 5.3.1 "Broadcast channel" */
@@ -84,16 +98,6 @@ int lte_pbch_blk_init(struct lte_pbch_blk *cblk, int E)
 /* 3GPP TS 36.212 Release 8: 5.3.1.2 "Channel coding" */
 static int lte_pbch_blk_chan_decode(struct lte_pbch_blk *cblk)
 {
-	struct lte_conv_code code = {
-		.n = 3,
-		.k = 7,
-		.len = PBCH_K,
-		.gen = { 0133, 0171, 0165 },
-		.rgen = 0,
-		.punc = NULL,
-		.term = CONV_TERM_TAIL_BITING,
-        };
-
 	int8_t d[PBCH_D * 3];
 
 	for (int i = 0; i < PBCH_D; i++) {
@@ -102,7 +106,7 @@ static int lte_pbch_blk_chan_decode(struct lte_pbch_blk *cblk)
 		d[3 * i + 2] = cblk->d[2][i];
         }
 
-	lte_conv_decode(&code, d, cblk->c);
+	lte_conv_decode_vdec(cblk->vdec, &pbch_code, d, cblk->c);
 
 	return 0;
 }
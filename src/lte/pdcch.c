@@ -37,7 +37,9 @@
 #include "precode.h"
 #include "si.h"
 #include "log.h"
+#include "pdcch.h"
 #include "pdcch_block.h"
+#include "exec.h"
 #include "sigvec_internal.h"
 
 #define LTE_MAX_NUM_PDCCH		3
@@ -53,8 +55,15 @@
 /* Common search space spans two blocks at aggregation level 8 */
 #define LTE_PDCCH_COMMON_LEN		LTE_DCI_A8_LEN * 2
 
+/* Upper bound on aggregation level 8 search blocks (11 at 20 MHz) */
+#define LTE_PDCCH_MAX_BLKS		16
+
 #define LTE_SI_RNTI	0xffff
 
+/* 3GPP TS 36.321 Release 8: Table 7.1-1 "RNTI values" */
+#define LTE_C_RNTI_MIN	0x003d
+#define LTE_C_RNTI_MAX	0xfff3
+
 //#define PDCCH_DEBUG 1
 
 struct pdcch_res_map {
@@ -63,92 +72,131 @@ struct pdcch_res_map {
 	int l;
 };
 
-struct pdcch_sym {
-	struct lte_sym *sym;
-	struct cxvec *data;
-};
-
 struct pdcch_slot {
 	int cfi;
 	int len;
 	int tx_ants;
 	struct lte_slot *slot;
-	struct pdcch_sym syms[LTE_MAX_NUM_PDCCH];
-	struct cxvec *pdcch;
 	struct cxvec *pdcch_deinterlv;
 	signed char *bits;
-	int *reserve;
 
 	int num_dci;
 	struct lte_dci dci[LTE_DCI_MAX];
 };
 
-static int pdcch_sym_init(struct pdcch_sym *sym,
-			  struct lte_sym *lsym, struct cxvec *data)
-{
-	if (lsym->l >= LTE_MAX_NUM_PDCCH) {
-		fprintf(stderr, "PDCCH: Invalid symbol number %i\n", lsym->l);
-		return -1;
-	}
-
-	sym->sym = lsym;
-	sym->data = cxvec_alias(data);
-
-	return 0;
-}
-
-static void pdcch_sym_free(struct pdcch_sym *sym)
-{
-	cxvec_free(sym->data);
-}
+/* Symbol, resource block and subcarriers of one resource element group */
+struct pdcch_reg {
+	int l;
+	int rb;
+	int sc[4];
+};
 
-static struct pdcch_slot *pdcch_slot_alloc(struct lte_slot *slot,
-					   int cfi, int phich_groups, int *res)
-{
-	int pcfich_len = LTE_PCFICH_LEN;
-	int len = slot->rbs * 8 - pcfich_len -
-		  12 * phich_groups + (cfi - 1) * (slot->rbs * LTE_RB_LEN);
-	struct pdcch_slot *pdcch;
+/*
+ * Control region map for one CFI value
+ *
+ * Resource element groups are listed in deinterleaved order and limited
+ * to whole CCEs, so extraction writes unprecoded symbols directly in
+ * search order.
+ */
+struct pdcch_map {
+	int len;
+	int nregs;
+	struct pdcch_reg *regs;
+	struct cxvec *data;
+	signed char *bits;
+};
 
-	if ((cfi > 3) || (cfi < 0)) {
-		fprintf(stderr, "PDCCH: Invalid CFI value %i\n", cfi);
-		return NULL;
-	}
+/*
+ * Control region maps by CFI value
+ *
+ * PCFICH and PHICH reservations and the REG interleaver depend only on
+ * cell ID, bandwidth and PHICH resource, which are the cache key.
+ */
+struct pdcch_cache {
+	int rbs;
+	int n_cell_id;
+	int ng;
+	int phich_groups;
+	int *reserve;
+	struct pdcch_map maps[LTE_MAX_NUM_PDCCH];
+};
 
-	pdcch = malloc(sizeof *pdcch);
-	pdcch->cfi = cfi;
-	pdcch->len = len;
-	pdcch->tx_ants = slot->subframe->tx_ants;
-	pdcch->slot = slot;
-	pdcch->pdcch = cxvec_alloc_simple(len);
-	pdcch->pdcch_deinterlv = cxvec_alloc_simple(len);
-	pdcch->bits = malloc(len * 2 * sizeof *pdcch->bits);
-	pdcch->num_dci = 0;
-	pdcch->reserve = res;
+/* DCI messages found within one aggregation level 8 search block */
+struct pdcch_dci_list {
+	int num;
+	struct lte_dci dci[LTE_DCI_MAX];
+};
 
-	/* Up to 3 PDCCH symbols */
-	for (int i = 0; i < cfi; i++)
-		pdcch_sym_init(&pdcch->syms[i],
-			       &pdcch->slot->syms[i],
-			       pdcch->pdcch);
+/* Candidate positions in one aggregation level 8 search block */
+#define PDCCH_BLK_CANDS		15
+#define PDCCH_MAX_TYPES		4
 
-	/* Clear all the data bits until we handle blind search correctly */
-	//memset(pdcch->data.pdcch, 0, LTE_PDCCH_COMMON_LEN * sizeof(char));
+/* DCI formats searched in order for system information and UE RNTIs */
+static const int pdcch_si_types[] = {
+	LTE_DCI_FORMAT1A, LTE_DCI_FORMAT1C,
+};
 
-	return pdcch;
-}
+static const int pdcch_ue_types[] = {
+	LTE_DCI_FORMAT1, LTE_DCI_FORMAT1A, LTE_DCI_FORMAT1B, LTE_DCI_FORMAT1C,
+};
 
-static void free_pdcch_slot(struct pdcch_slot *pdcch)
-{
-	free(pdcch->bits);
-	cxvec_free(pdcch->pdcch);
-	cxvec_free(pdcch->pdcch_deinterlv);
+/*
+ * Decoded candidates of one search block
+ *
+ * types - Decoded DCI formats
+ * pos   - Decoded candidate positions
+ * fail  - Formats that failed to decode
+ * rnti  - RNTI passing the CRC check by format and position
+ * a     - Decoded payload bits by format and position
+ * match - Monitored RNTIs passing the CRC check of any candidate, ascending
+ * found - Verified C-RNTI candidates in discovery mode
+ * cce   - CCEs of the search block spanned by each verified candidate
+ */
+struct pdcch_cands {
+	const int *types;
+	int num_types;
+	unsigned pos;
+	unsigned fail;
+	uint16_t rnti[PDCCH_MAX_TYPES][PDCCH_BLK_CANDS];
+	uint8_t a[PDCCH_MAX_TYPES][PDCCH_BLK_CANDS][LTE_PDCCH_MAX_A];
+	int num_match;
+	uint16_t match[PDCCH_MAX_TYPES * PDCCH_BLK_CANDS];
+	int num_found;
+	struct lte_pdcch_rnti found[PDCCH_MAX_TYPES * PDCCH_BLK_CANDS];
+	unsigned cce[PDCCH_MAX_TYPES * PDCCH_BLK_CANDS];
+};
 
-	for (int i = 0; i < pdcch->cfi; i++)
-		pdcch_sym_free(&pdcch->syms[i]);
+/*
+ * Persistent blind search state
+ *
+ * Each search task owns one block decoder, candidate table and DCI list,
+ * so repeated searches do not allocate once every task slot has been used.
+ * Control region maps are kept until the cell configuration changes.
+ */
+struct lte_pdcch_dec {
+	struct lte_pdcch_blk *blks[LTE_PDCCH_MAX_BLKS];
+	struct pdcch_cands cands[LTE_PDCCH_MAX_BLKS];
+	struct pdcch_dci_list lists[LTE_PDCCH_MAX_BLKS];
+
+	struct pdcch_cache cache;
+	struct pdcch_slot slot;
+
+	int discover;
+	int num_found;
+	struct lte_pdcch_rnti found[LTE_PDCCH_MAX_BLKS *
+				    PDCCH_MAX_TYPES * PDCCH_BLK_CANDS];
+};
 
-	free(pdcch);
-}
+/* Search blocks are independent and dispatched as separate tasks */
+struct pdcch_search {
+	struct pdcch_slot *pdcch;
+	struct lte_pdcch_dec *dec;
+	const struct lte_rnti_set *rntis;
+	int si_only;
+	int discover;
+	int ncce;
+	int rc[LTE_PDCCH_MAX_BLKS];
+};
 
 static int next_element(int rbs, struct pdcch_res_map *map, int *x, int num)
 {
@@ -201,10 +249,8 @@ static int next_element(int rbs, struct pdcch_res_map *map, int *x, int num)
 	return 1;
 }
 
-static int chk_ref_pos(struct pdcch_slot *pdcch, int rb, int sc)
+static int chk_ref_pos(const int *pos, int sc)
 {
-	int *pos = pdcch->slot->subframe->ref_indices;
-
 	if ((sc == pos[0]) || (sc == pos[1]) ||
 	    (sc == pos[2]) || (sc == pos[3]))
 		return 1;
@@ -212,43 +258,27 @@ static int chk_ref_pos(struct pdcch_slot *pdcch, int rb, int sc)
 	return 0;
 }
 
-static int chk_reserved(struct pdcch_slot *pdcch, int rb, int sc)
+static int chk_reserved(const int *reserve, int rb, int sc)
 {
-	if (pdcch->reserve[rb * 12 + sc])
+	if (reserve[rb * 12 + sc])
 		return 1;
 
 	return 0;
 }
 
 /*
- * Unmap from reference interleaved resource blocks to continuous
- * data symbols and perform two antenna processing. Other antenna
- * combinations are not supported at this time.
+ * Locate resource element groups in mapping order, skipping reference
+ * symbols and PCFICH and PHICH reservations of the first symbol.
  */
-static int pdcch_extract_syms(struct pdcch_slot **pdcch, int chans)
+static int pdcch_map_regs(struct pdcch_reg *regs, int len, int rbs, int cfi,
+			  const int *reserve, const int *ref_pos)
 {
-	int l, rb, sc;
-	int sc0, sc1, sc2, sc3;
-	int cnt = 0, phich_cnt = 0;
-	int cfi = pdcch[0]->cfi;
+	int l, rb, sc, cnt = 0;
 	int sc_cnt[3] = { 0, 0, 0 };
-
 	struct pdcch_res_map map;
-	struct pdcch_sym *syms[chans][cfi];
-
-	if ((chans < 0) || (chans > 2)) {
-		fprintf(stderr, "PDCCH: Invalid channels %i\n", chans);
-		exit(-1);
-	}
-
-	for (int i = 0; i < cfi; i++) {
-		for (int n = 0; n < chans; n++)
-			syms[n][i] = &pdcch[n]->syms[i];
+	struct pdcch_reg reg;
 
-		sc_cnt[i] = 0;
-	}
-
-	while (next_element(pdcch[0]->slot->rbs, &map, sc_cnt, cfi) > 0) {
+	while (next_element(rbs, &map, sc_cnt, cfi) > 0) {
 		l = map.l;
 		rb = map.rb;
 		sc = map.sc;
@@ -260,29 +290,29 @@ static int pdcch_extract_syms(struct pdcch_slot **pdcch, int chans)
 				continue;
 			}
 
-			if ((chk_reserved(pdcch[0], rb, sc)) ||
-			    (chk_reserved(pdcch[0], rb, sc + 1))) {
+			if ((chk_reserved(reserve, rb, sc)) ||
+			    (chk_reserved(reserve, rb, sc + 1))) {
 				sc_cnt[0]++;
 				continue;
 			}
 
-			if (chk_ref_pos(pdcch[0], rb, sc)) {
-				sc0 = sc + 1;
-				sc1 = sc + 2;
-				sc2 = sc + 4;
-				sc3 = sc + 5;
+			if (chk_ref_pos(ref_pos, sc)) {
+				reg.sc[0] = sc + 1;
+				reg.sc[1] = sc + 2;
+				reg.sc[2] = sc + 4;
+				reg.sc[3] = sc + 5;
 				sc_cnt[0] += 6;
-			} else if (chk_ref_pos(pdcch[0], rb, sc + 1)) {
-				sc0 = sc + 0;
-				sc1 = sc + 2;
-				sc2 = sc + 3;
-				sc3 = sc + 5;
+			} else if (chk_ref_pos(ref_pos, sc + 1)) {
+				reg.sc[0] = sc + 0;
+				reg.sc[1] = sc + 2;
+				reg.sc[2] = sc + 3;
+				reg.sc[3] = sc + 5;
 				sc_cnt[0] += 6;
-			} else if (chk_ref_pos(pdcch[0], rb, sc + 2)) {
-				sc0 = sc + 0;
-				sc1 = sc + 1;
-				sc2 = sc + 3;
-				sc3 = sc + 4;
+			} else if (chk_ref_pos(ref_pos, sc + 2)) {
+				reg.sc[0] = sc + 0;
+				reg.sc[1] = sc + 1;
+				reg.sc[2] = sc + 3;
+				reg.sc[3] = sc + 4;
 				sc_cnt[0] += 6;
 			} else {
 				fprintf(stderr,
@@ -292,49 +322,182 @@ static int pdcch_extract_syms(struct pdcch_slot **pdcch, int chans)
 			break;
 		case 1:
 		case 2:
-			sc0 = sc + 0;
-			sc1 = sc + 1;
-			sc2 = sc + 2;
-			sc3 = sc + 3;
+			reg.sc[0] = sc + 0;
+			reg.sc[1] = sc + 1;
+			reg.sc[2] = sc + 2;
+			reg.sc[3] = sc + 3;
+			sc_cnt[l] += 4;
 			break;
 		default:
 			fprintf(stderr, "PDCCH: Invalid symbol %i\n", l);
 			return -1;
 		}
 #if PDCCH_DEBUG
-		printf("rb %i, l %i, sc0 %i\n", rb, l, sc0);
-		printf("rb %i, l %i, sc1 %i\n", rb, l, sc1);
-		printf("rb %i, l %i, sc2 %i\n", rb, l, sc2);
-		printf("rb %i, l %i, sc3 %i\n", rb, l, sc3);
+		for (int i = 0; i < 4; i++)
+			printf("rb %i, l %i, sc%i %i\n", rb, l, i, reg.sc[i]);
 #endif
-		struct lte_sym *sym0, *sym1;
+		if (cnt >= len / 4) {
+			fprintf(stderr, "PDCCH: Too many resource groups\n");
+			return -1;
+		}
 
-		sym0 = syms[0][l]->sym;
-		if (chans == 2)
-			sym1 = syms[1][l]->sym;
-		else
-			sym1 = NULL;
+		reg.l = l;
+		reg.rb = rb;
+		regs[cnt++] = reg;
+	}
+
+	if (cnt * 4 != len) {
+		fprintf(stderr, "PDCCH: Extracted %i symbols but expected %i\n",
+			cnt * 4, len);
+		return -1;
+	}
+
+	return cnt;
+}
+
+static void pdcch_map_free(struct pdcch_map *map)
+{
+	free(map->regs);
+	free(map->bits);
+	if (map->data)
+		cxvec_free(map->data);
+
+	memset(map, 0, sizeof(*map));
+}
+
+/*
+ * Compose the REG mapping with the sub-block deinterleaver so that entry
+ * 'i' of the gather table is the source of deinterleaved REG 'i'.
+ */
+static int pdcch_map_init(struct pdcch_map *map, struct pdcch_cache *cache,
+			  struct lte_subframe *subframe, int cfi)
+{
+	int rbs = cache->rbs;
+	int len = rbs * 8 - LTE_PCFICH_LEN - 12 * cache->phich_groups +
+		  (cfi - 1) * (rbs * LTE_RB_LEN);
+	struct pdcch_reg regs[len / 4];
+	struct lte_pdcch_deinterlv *d;
+
+	if (pdcch_map_regs(regs, len, rbs, cfi,
+			   cache->reserve, subframe->ref_indices) < 0)
+		return -1;
+
+	map->len = len;
+	map->nregs = len / 4 / 9 * 9;
+	map->regs = malloc(map->nregs * sizeof(struct pdcch_reg));
+	map->data = cxvec_alloc_simple(len);
+	map->bits = malloc(len * 2 * sizeof(signed char));
+	if (!map->regs || !map->data || !map->bits)
+		return -1;
+
+	d = lte_alloc_pdcch_deinterlv(len / 4, cache->n_cell_id);
+	for (int i = 0; i < d->len; i++) {
+		if (d->seq[i] < map->nregs)
+			map->regs[d->seq[i]] = regs[i];
+	}
+	lte_free_pdcch_deinterlv(d);
+
+	return 0;
+}
+
+static void pdcch_cache_free(struct pdcch_cache *cache)
+{
+	for (int i = 0; i < LTE_MAX_NUM_PDCCH; i++)
+		pdcch_map_free(&cache->maps[i]);
+
+	free(cache->reserve);
+	cache->reserve = NULL;
+}
 
-		if (pdcch[0]->tx_ants > 2) {
-			printf("too many ants\n");
-			exit(1);
+/*
+ * Return the control region map for the configuration, rebuilding the
+ * PHICH reservation table on change of cell and maps on first use of
+ * each CFI value. PCFICH reservations are taken from the subframe.
+ */
+static struct pdcch_map *pdcch_cache_map(struct pdcch_cache *cache,
+					 struct lte_subframe *subframe,
+					 int cfi, int n_cell_id, int ng)
+{
+	int rbs = subframe->rbs;
+	struct pdcch_map *map;
+
+	if ((cfi < 1) || (cfi > LTE_MAX_NUM_PDCCH)) {
+		fprintf(stderr, "PDCCH: Invalid CFI value %i\n", cfi);
+		return NULL;
+	}
+
+	if (!cache->reserve || (cache->rbs != rbs) ||
+	    (cache->n_cell_id != n_cell_id) || (cache->ng != ng)) {
+		pdcch_cache_free(cache);
+
+		cache->phich_groups = lte_phich_num_groups(rbs, ng,
+							   LTE_PHICH_DUR_NORMAL);
+		if (cache->phich_groups < 0) {
+			fprintf(stderr, "PDCCH: Invalid PHICH group\n");
+			return NULL;
 		}
 
-		lte_unprecode(sym0, sym1, pdcch[0]->tx_ants, chans,
-			      rb, sc0, sc1, syms[0][l]->data, cnt + 0);
-		lte_unprecode(sym0, sym1, pdcch[0]->tx_ants, chans,
-			      rb, sc2, sc3, syms[0][l]->data, cnt + 2);
-		cnt += 4;
-		if (!l)
-			phich_cnt += 4;
-		else
-			sc_cnt[l] += 4;
+		cache->reserve = malloc(rbs * LTE_RB_LEN * sizeof(int));
+		if (!cache->reserve)
+			return NULL;
+
+		for (int i = 0; i < rbs * LTE_RB_LEN; i++)
+			cache->reserve[i] = subframe->reserve[i] == 1;
+
+		if (lte_gen_phich_indices(cache->reserve, rbs, n_cell_id,
+					  ng, LTE_PHICH_DUR_NORMAL) < 0) {
+			fprintf(stderr,
+				"PDCCH: Failed to set PHICH symbol indices\n");
+			pdcch_cache_free(cache);
+			return NULL;
+		}
+
+		cache->rbs = rbs;
+		cache->n_cell_id = n_cell_id;
+		cache->ng = ng;
 	}
 
-	if (cnt != pdcch[0]->len) {
-		fprintf(stderr, "PDCCH: Extracted %i symbols but expected %i\n",
-			cnt, pdcch[0]->len);
-		exit(-1);
+	map = &cache->maps[cfi - 1];
+	if (!map->regs && (pdcch_map_init(map, cache, subframe, cfi) < 0)) {
+		pdcch_map_free(map);
+		return NULL;
+	}
+
+	return map;
+}
+
+/*
+ * Gather deinterleaved symbols from reference interleaved resource blocks
+ * and perform antenna processing. Up to two transmit antennas supported.
+ */
+static int pdcch_extract_syms(struct pdcch_map *map,
+			      struct lte_subframe **subframe, int chans)
+{
+	int tx_ants = subframe[0]->tx_ants;
+	struct lte_sym *sym0, *sym1 = NULL;
+	struct pdcch_reg *reg;
+
+	if ((chans < 1) || (chans > 2)) {
+		fprintf(stderr, "PDCCH: Invalid channels %i\n", chans);
+		return -1;
+	}
+
+	if (tx_ants > 2) {
+		fprintf(stderr, "PDCCH: Invalid antennas %i\n", tx_ants);
+		return -1;
+	}
+
+	for (int i = 0; i < map->nregs; i++) {
+		reg = &map->regs[i];
+
+		sym0 = &subframe[0]->slot[0].syms[reg->l];
+		if (chans == 2)
+			sym1 = &subframe[1]->slot[0].syms[reg->l];
+
+		lte_unprecode(sym0, sym1, tx_ants, chans, reg->rb,
+			      reg->sc[0], reg->sc[1], map->data, 4 * i + 0);
+		lte_unprecode(sym0, sym1, tx_ants, chans, reg->rb,
+			      reg->sc[2], reg->sc[3], map->data, 4 * i + 2);
 	}
 
 	return 0;
@@ -360,123 +523,366 @@ static void log_cce_info(int cfi, int regs, int cces, int nbits)
 }
 #endif
 
-static int pdcch_decode_bits(struct pdcch_slot *pdcch,
-			     int lev, int blk, int type, uint16_t rnti)
+/* Rate matched length of one candidate at aggregation level 'lev' */
+static int pdcch_cand_len(int lev)
 {
-	int A, E, found = 0;
-	int rbs = pdcch->slot->rbs;
-	int8_t *e;
-	uint8_t *a;
-	struct lte_pdcch_blk *dblk;
-
 	switch (lev) {
 	case 1:
-		E = LTE_DCI_A1_LEN;
-		break;
+		return LTE_DCI_A1_LEN;
 	case 2:
-		E = LTE_DCI_A2_LEN;
-		break;
+		return LTE_DCI_A2_LEN;
 	case 4:
-		E = LTE_DCI_A4_LEN;
-		break;
+		return LTE_DCI_A4_LEN;
 	case 8:
-		E = LTE_DCI_A8_LEN;
-		break;
-	default:
+		return LTE_DCI_A8_LEN;
+	}
+
+	return -1;
+}
+
+/*
+ * Candidate positions within an aggregation level 8 search block are
+ * numbered by level: 0 for level 8, 1-2 for level 4, 3-6 for level 2 and
+ * 7-14 for level 1.
+ */
+static int pdcch_cand_pos(int lev, int blk)
+{
+	return 8 / lev - 1 + blk % (8 / lev);
+}
+
+static int pdcch_pos_lev(int pos)
+{
+	if (pos < 1)
+		return 8;
+	if (pos < 3)
+		return 4;
+	if (pos < 7)
+		return 2;
+
+	return 1;
+}
+
+/* CCEs of the search block spanned by candidate position 'pos' */
+static unsigned pdcch_pos_cce(int pos)
+{
+	int lev = pdcch_pos_lev(pos);
+	int i = pos - (8 / lev - 1);
+
+	return ((1 << lev) - 1) << (i * lev);
+}
+
+/* Candidate positions whose CCEs all pass the power check */
+static unsigned pdcch_cand_mask(int ncce, unsigned agg1_mask, int si_only)
+{
+	unsigned cce, pos = 0;
+	int lev, n;
+
+	for (lev = 8; lev >= 1; lev /= 2) {
+		if (si_only && (lev < 4))
+			break;
+
+		n = 8 / lev;
+		for (int i = 0; (i < n) && ((i + 1) * lev <= ncce); i++) {
+			cce = ((1 << lev) - 1) << (i * lev);
+			if ((agg1_mask & cce) == cce)
+				pos |= 1 << (n - 1 + i);
+		}
+	}
+
+	return pos;
+}
+
+/* Record a monitored RNTI keeping the match list sorted and unique */
+static void pdcch_add_match(struct pdcch_cands *cands, uint16_t rnti)
+{
+	int i, n = cands->num_match;
+
+	for (i = 0; i < n; i++) {
+		if (cands->match[i] == rnti)
+			return;
+		if (cands->match[i] > rnti)
+			break;
+	}
+
+	memmove(&cands->match[i + 1], &cands->match[i],
+		(n - i) * sizeof(uint16_t));
+	cands->match[i] = rnti;
+	cands->num_match++;
+}
+
+/*
+ * Minimum re-encoded correlation of a discovered candidate. Viterbi decoded
+ * noise fits short, lightly coded candidates closely, so lower aggregation
+ * levels need a higher score. Values are roughly the 99.9th percentile of
+ * decoded noise.
+ */
+static float pdcch_verify_score(int lev)
+{
+	switch (lev) {
+	case 1:
+		return 0.98f;
+	case 2:
+		return 0.85f;
+	case 4:
+		return 0.70f;
+	}
+
+	return 0.50f;
+}
+
+/* Keep C-RNTI candidates whose re-encoded codeword matches the input */
+static void pdcch_verify_cand(struct lte_pdcch_blk *dblk,
+			      struct pdcch_cands *cands, int f, int A, int pos,
+			      const uint8_t *a, uint16_t rnti,
+			      const int8_t *e, int E)
+{
+	struct lte_pdcch_rnti *found;
+	int lev = pdcch_pos_lev(pos);
+	float score;
+
+	if ((rnti < LTE_C_RNTI_MIN) || (rnti > LTE_C_RNTI_MAX))
+		return;
+
+	score = lte_pdcch_blk_verify(dblk, A, a, rnti, e, E);
+	if (score < pdcch_verify_score(lev))
+		return;
+
+	cands->cce[cands->num_found] = pdcch_pos_cce(pos);
+	found = &cands->found[cands->num_found++];
+	found->rnti = rnti;
+	found->type = cands->types[f];
+	found->lev = lev;
+	found->score = score;
+}
+
+/* Verified candidate 'j' takes precedence over overlapping candidate 'i' */
+static int pdcch_found_wins(const struct pdcch_cands *cands, int j, int i)
+{
+	const struct lte_pdcch_rnti *a = &cands->found[i];
+	const struct lte_pdcch_rnti *b = &cands->found[j];
+
+	if (b->lev != a->lev)
+		return b->lev > a->lev;
+	if (b->score != a->score)
+		return b->score > a->score;
+
+	return j < i;
+}
+
+/*
+ * A DCI read at another aggregation level or format verifies surprisingly
+ * often, and for a repeating DCI it yields the same remainder every time,
+ * so only the highest aggregation level of each CCE span is kept. Spans
+ * that also carry a monitored or non C-RNTI remainder belong to a known
+ * DCI and are dropped.
+ */
+static void pdcch_prune_found(struct pdcch_cands *cands, unsigned known)
+{
+	int i, j, n = 0;
+	int keep[PDCCH_MAX_TYPES * PDCCH_BLK_CANDS];
+
+	for (i = 0; i < cands->num_found; i++) {
+		keep[i] = 0;
+		if (cands->cce[i] & known)
+			continue;
+
+		for (j = 0; j < cands->num_found; j++) {
+			if ((j != i) && (cands->cce[j] & cands->cce[i]) &&
+			    !(cands->cce[j] & known) &&
+			    pdcch_found_wins(cands, j, i))
+				break;
+		}
+		keep[i] = j == cands->num_found;
+	}
+
+	for (i = 0; i < cands->num_found; i++) {
+		if (!keep[i])
+			continue;
+
+		cands->cce[n] = cands->cce[i];
+		cands->found[n++] = cands->found[i];
+	}
+
+	cands->num_found = n;
+}
+
+/*
+ * Decode all candidate positions in 'pos' for each DCI format
+ *
+ * Candidates of one format share a payload size and are decoded as a
+ * single batch. Instead of checking the CRC against a single RNTI, the
+ * CRC remainder of each candidate is looked up in the monitored set. The
+ * search decision tree then runs once per matching RNTI and looks up
+ * results in the same order as a serial search, so speculative decodes of
+ * candidates the tree would skip do not change the outcome.
+ */
+static void pdcch_decode_cands(struct pdcch_slot *pdcch,
+			       struct lte_pdcch_blk *dblk,
+			       struct pdcch_cands *cands, unsigned pos,
+			       int agg8_blk, const struct lte_rnti_set *rntis,
+			       int discover)
+{
+	int A, lev, blk, n;
+	int E[PDCCH_BLK_CANDS], idx[PDCCH_BLK_CANDS];
+	int8_t *e[PDCCH_BLK_CANDS];
+	uint8_t *a[PDCCH_BLK_CANDS];
+	uint16_t rnti[PDCCH_BLK_CANDS];
+	unsigned known = 0;
+
+	cands->pos = pos;
+	cands->fail = 0;
+	cands->num_match = 0;
+	cands->num_found = 0;
+
+	for (int f = 0; f < cands->num_types; f++) {
+		A = lte_dci_format_size(pdcch->slot->rbs,
+					LTE_MODE_FDD, cands->types[f]);
+		if (A < 0)
+			continue;
+
+		n = 0;
+		for (int p = 0; p < PDCCH_BLK_CANDS; p++) {
+			if (!(pos & (1 << p)))
+				continue;
+
+			lev = pdcch_pos_lev(p);
+			blk = agg8_blk * (8 / lev) + p - (8 / lev - 1);
+
+			E[n] = pdcch_cand_len(lev);
+			e[n] = (int8_t *) &pdcch->bits[E[n] * blk];
+			a[n] = cands->a[f][p];
+			idx[n++] = p;
+		}
+
+		if (lte_pdcch_blk_decode_batch(dblk, A, n, e, E, a, rnti) < 0) {
+			cands->fail |= 1 << f;
+			continue;
+		}
+
+		for (int i = 0; i < n; i++) {
+			cands->rnti[f][idx[i]] = rnti[i];
+
+			if (lte_rnti_set_has(rntis, rnti[i])) {
+				pdcch_add_match(cands, rnti[i]);
+				known |= pdcch_pos_cce(idx[i]);
+			} else if (rnti[i] > LTE_C_RNTI_MAX) {
+				known |= pdcch_pos_cce(idx[i]);
+			}
+			if (discover)
+				pdcch_verify_cand(dblk, cands, f, A, idx[i],
+						  a[i], rnti[i], e[i], E[i]);
+		}
+	}
+
+	if (discover)
+		pdcch_prune_found(cands, known);
+}
+
+static int pdcch_type_idx(struct pdcch_cands *cands, int type)
+{
+	for (int f = 0; f < cands->num_types; f++) {
+		if (cands->types[f] == type)
+			return f;
+	}
+
+	return -1;
+}
+
+static int pdcch_decode_bits(struct pdcch_slot *pdcch,
+			     struct pdcch_cands *cands,
+			     struct pdcch_dci_list *list,
+			     int lev, int blk, int type, uint16_t rnti)
+{
+	int A, pos, found = 0;
+	int rbs = pdcch->slot->rbs;
+	int f = pdcch_type_idx(cands, type);
+
+	if (pdcch_cand_len(lev) < 0) {
 		LOG_PDCCH_ERR("Invalid aggregation level");
 		return -1;
 	}
 
-	if (pdcch->num_dci >= LTE_DCI_MAX) {
+	if (list->num >= LTE_DCI_MAX) {
 		LOG_PDCCH_ERR("Maximum number of DCI values reached");
 		return 0;
 	}
 
 	A = lte_dci_format_size(rbs, LTE_MODE_FDD, type);
-	if (A < 0) {
+	if ((A < 0) || (f < 0)) {
 		LOG_PDCCH_ERR("Could not find valid DCI format");
 		return -1;
 	}
 
-	dblk = lte_pdcch_blk_alloc();
-	if (lte_pdcch_blk_init(dblk, A, E) < 0) {
+	if (cands->fail & (1 << f)) {
 		LOG_PDCCH_ERR("Downlink control block failed");
 		return -1;
 	}
 
-	a = lte_pdcch_blk_abuf(dblk, A);
-	e = lte_pdcch_blk_ebuf(dblk, E);
+	pos = pdcch_cand_pos(lev, blk);
 
-	memcpy(e, &pdcch->bits[E * blk], E * sizeof(char));
-
-	if (lte_pdcch_blk_decode(dblk, rnti)) {
-		struct lte_dci *dci = &pdcch->dci[pdcch->num_dci];
-		lte_dci_decode(dci, rbs, LTE_MODE_FDD, a, A, rnti);
+	if ((cands->pos & (1 << pos)) && (cands->rnti[f][pos] == rnti)) {
+		struct lte_dci *dci = &list->dci[list->num];
+		lte_dci_decode(dci, rbs, LTE_MODE_FDD, cands->a[f][pos], A, rnti);
 
 		if (dci->type != LTE_DCI_FORMAT0) {
 			log_dci_info(dci, A, rnti, lev, blk);
-			pdcch->num_dci++;
+			list->num++;
 			found = 1;
 		}
 	}
 
-	lte_pdcch_blk_free(dblk);
-
 	return found;
 }
 
+/* Formats are tried in order until one is found */
 static int pdcch_decode_blk(struct pdcch_slot *pdcch,
+			    struct pdcch_cands *cands,
+			    struct pdcch_dci_list *list,
 			    int lev, int blk, uint16_t rnti)
 {
+	const int *types = pdcch_ue_types;
+	int num = sizeof(pdcch_ue_types) / sizeof(int);
+
 	if (rnti == LTE_SI_RNTI) {
-		return (pdcch_decode_bits(pdcch, lev, blk,
-					  LTE_DCI_FORMAT1A, rnti) ||
-			pdcch_decode_bits(pdcch, lev, blk,
-					  LTE_DCI_FORMAT1C, rnti));
+		types = pdcch_si_types;
+		num = sizeof(pdcch_si_types) / sizeof(int);
 	}
 
-	return (pdcch_decode_bits(pdcch, lev, blk,
-				  LTE_DCI_FORMAT1, rnti) ||
-		pdcch_decode_bits(pdcch, lev, blk,
-				  LTE_DCI_FORMAT1A, rnti) ||
-		pdcch_decode_bits(pdcch, lev, blk,
-				  LTE_DCI_FORMAT1B, rnti) ||
-		pdcch_decode_bits(pdcch, lev, blk,
-				  LTE_DCI_FORMAT1C, rnti));
+	for (int i = 0; i < num; i++) {
+		if (pdcch_decode_bits(pdcch, cands, list,
+				      lev, blk, types[i], rnti))
+			return 1;
+	}
 
+	return 0;
 }
 
-static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
-				     int agg8_blk, uint16_t rnti)
+/* Average magnitude of one CCE of deinterleaved symbols */
+static float pdcch_cce_pow(struct pdcch_slot *pdcch, int start)
 {
-	struct cxvec *agg1;
-	int shift, blk, success = 0;
-	unsigned agg4_mask = 0, agg2_mask = 0, agg1_mask = 0;
-
-	if (ncce == 8) {
-		if (agg8_blk && (pdcch->len * 2 < 2 * LTE_DCI_A8_LEN)) {
-			return -1;
-		} else if (pdcch->len * 2 < LTE_DCI_A8_LEN) {
-			return -1;
-		}
-	}
+	float sum = 0.0f;
+	float complex *data = pdcch->pdcch_deinterlv->data;
 
-	shift = agg8_blk * LTE_DCI_A8_LEN / 2;
-	for (int i = 0; i < ncce; i++) {
-		agg1 = cxvec_subvec(pdcch->pdcch_deinterlv,
-				    shift + 36 * i, 0, 0, 36);
+	for (int i = start; i < start + 36; i++)
+		sum += cabsf(data[i]);
 
-                if ((cxvec_avgpow(agg1) > 0.5f))
-			agg1_mask |= 1 << i;
+	return sum / 36;
+}
 
-		cxvec_free(agg1);
-	}
+static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch,
+				     struct pdcch_cands *cands,
+				     struct pdcch_dci_list *list, int ncce,
+				     int agg8_blk, unsigned agg1_mask,
+				     uint16_t rnti)
+{
+	int blk, success = 0;
+	unsigned agg4_mask = 0, agg2_mask = 0;
 
 	/* Aggregation level 8 */
 	if (ncce == 8) {
 		if ((agg1_mask & 0xff) == 0xff) {
 			blk = agg8_blk;
-			if (pdcch_decode_blk(pdcch, 8, blk, rnti))
+			if (pdcch_decode_blk(pdcch, cands, list, 8, blk, rnti))
 				return 1;
 		}
 	}
@@ -485,7 +891,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if (ncce >= 4) {
 		if ((agg1_mask & 0x0f) == 0x0f) {
 			blk = 2 * agg8_blk;
-			if (pdcch_decode_blk(pdcch, 4, blk, rnti)) {
+			if (pdcch_decode_blk(pdcch, cands, list, 4, blk, rnti)) {
 				agg4_mask = 1 << 0;
 				success = 1;
 			}
@@ -494,7 +900,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if (ncce == 8) {
 		if ((agg1_mask & 0xf0) == 0xf0) {
 			blk = 2 * agg8_blk + 1;
-			if (pdcch_decode_blk(pdcch, 4, blk, rnti)) {
+			if (pdcch_decode_blk(pdcch, cands, list, 4, blk, rnti)) {
 				agg4_mask |= 1 << 1;
 				success = 1;
 			}
@@ -508,7 +914,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if (ncce >= 2) {
 		if (((agg1_mask & 0x03) == 0x03) && (!(agg4_mask & 0x01))) {
 			blk = 4 * agg8_blk;
-			if (pdcch_decode_blk(pdcch, 2, blk, rnti)) {
+			if (pdcch_decode_blk(pdcch, cands, list, 2, blk, rnti)) {
 				agg2_mask = 1 << 0;
 				success = 1;
 			}
@@ -517,7 +923,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if (ncce >= 4) {
 		if (((agg1_mask & 0x0c) == 0x0c) && (!(agg4_mask & 0x01))) {
 			blk = 4 * agg8_blk + 1;
-			if (pdcch_decode_blk(pdcch, 2, blk, rnti)) {
+			if (pdcch_decode_blk(pdcch, cands, list, 2, blk, rnti)) {
 				agg2_mask |= 1 << 1;
 				success = 1;
 			}
@@ -526,7 +932,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if (ncce >= 6) {
 		if (((agg1_mask & 0x30) == 0x30) && (!(agg4_mask & 0x02))) {
 			blk = 4 * agg8_blk + 2;
-			if (pdcch_decode_blk(pdcch, 2, blk, rnti)) {
+			if (pdcch_decode_blk(pdcch, cands, list, 2, blk, rnti)) {
 				agg2_mask |= 1 << 2;
 				success = 1;
 			}
@@ -535,7 +941,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if (ncce == 8) {
 		if (((agg1_mask & 0xc0) == 0xc0) && (!(agg4_mask & 0x02))) {
 			blk = 4 * agg8_blk + 3;
-			if (pdcch_decode_blk(pdcch, 2, blk, rnti)) {
+			if (pdcch_decode_blk(pdcch, cands, list, 2, blk, rnti)) {
 				agg2_mask |= 1 << 3;
 				success = 1;
 			}
@@ -546,7 +952,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x01) &&
 	    (!(agg4_mask & 0x01)) && (!(agg2_mask & 0x01))) {
 		blk = 8 * agg8_blk;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 	if (ncce == 1)
@@ -554,7 +960,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x02) &&
 	    (!(agg4_mask & 0x01)) && (!(agg2_mask & 0x01))) {
 		blk = 8 * agg8_blk  + 1;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 
@@ -563,7 +969,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x04) &&
 	    (!(agg4_mask & 0x01)) && (!(agg2_mask & 0x02))) {
 		blk = 8 * agg8_blk + 2;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 	if (ncce == 3)
@@ -571,7 +977,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x08) &&
 	    (!(agg4_mask & 0x01)) && (!(agg2_mask & 0x02))) {
 		blk = 8 * agg8_blk + 3;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 	if (ncce == 4)
@@ -579,7 +985,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x10) &&
 	    (!(agg4_mask & 0x02)) && (!(agg2_mask & 0x04))) {
 		blk = 8 * agg8_blk + 4;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 	if (ncce == 5)
@@ -587,7 +993,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x20) &&
 	    (!(agg4_mask & 0x02)) && (!(agg2_mask & 0x04))) {
 		blk = 8 * agg8_blk + 5;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 	if (ncce == 6)
@@ -595,7 +1001,7 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x40) &&
 	    (!(agg4_mask & 0x02)) && (!(agg2_mask & 0x08))) {
 		blk = 8 * agg8_blk + 6;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
 			success = 1;
 	}
 	if (ncce == 7)
@@ -603,7 +1009,59 @@ static int pdcch_dci_power_search_si(struct pdcch_slot *pdcch, int ncce,
 	if ((agg1_mask & 0x80) &&
 	    (!(agg4_mask & 0x02)) && (!(agg2_mask & 0x08))) {
 		blk = 8 * agg8_blk + 7;
-		if (pdcch_decode_blk(pdcch, 1, blk, rnti))
+		if (pdcch_decode_blk(pdcch, cands, list, 1, blk, rnti))
+			success = 1;
+	}
+
+	return success;
+}
+
+/*
+ * Decode all candidates of one aggregation level 8 search block once, then
+ * run the search for each monitored RNTI matching a candidate. Only the
+ * SI-RNTI search formats and levels are decoded if no UE RNTI is monitored
+ * and discovery is off.
+ */
+static int pdcch_search_blk(struct pdcch_slot *pdcch,
+			    struct lte_pdcch_blk *dblk,
+			    struct pdcch_cands *cands,
+			    struct pdcch_dci_list *list, int ncce,
+			    int agg8_blk, const struct lte_rnti_set *rntis,
+			    int si_only, int discover)
+{
+	int shift, success = 0;
+	unsigned agg1_mask = 0;
+
+	if (ncce == 8) {
+		if (agg8_blk && (pdcch->len * 2 < 2 * LTE_DCI_A8_LEN)) {
+			return -1;
+		} else if (pdcch->len * 2 < LTE_DCI_A8_LEN) {
+			return -1;
+		}
+	}
+
+	shift = agg8_blk * LTE_DCI_A8_LEN / 2;
+	for (int i = 0; i < ncce; i++) {
+		if (pdcch_cce_pow(pdcch, shift + 36 * i) > 0.5f)
+			agg1_mask |= 1 << i;
+	}
+
+	if (si_only) {
+		cands->types = pdcch_si_types;
+		cands->num_types = sizeof(pdcch_si_types) / sizeof(int);
+	} else {
+		cands->types = pdcch_ue_types;
+		cands->num_types = sizeof(pdcch_ue_types) / sizeof(int);
+	}
+
+	pdcch_decode_cands(pdcch, dblk, cands,
+			   pdcch_cand_mask(ncce, agg1_mask, si_only),
+			   agg8_blk, rntis, discover);
+
+	for (int i = 0; i < cands->num_match; i++) {
+		if (pdcch_dci_power_search_si(pdcch, cands, list, ncce,
+					      agg8_blk, agg1_mask,
+					      cands->match[i]))
 			success = 1;
 	}
 
@@ -627,106 +1085,234 @@ static int pdcch_num_cce_bits(struct pdcch_slot *pdcch)
 	return pdcch->len / 4 / 9 * 72;
 }
 
-static int pdcch_si_search(struct pdcch_slot *pdcch, uint16_t rnti,
-			   signed char *seq, int n_cell_id)
+static void pdcch_search_task(void *arg, int i)
 {
-	int i, nbits;
-	struct lte_pdcch_deinterlv *d;
+	struct pdcch_search *search = (struct pdcch_search *) arg;
+	int ncce = search->ncce - 8 * i;
+
+	search->dec->lists[i].num = 0;
+	search->rc[i] = pdcch_search_blk(search->pdcch,
+					 search->dec->blks[i],
+					 &search->dec->cands[i],
+					 &search->dec->lists[i],
+					 ncce < 8 ? ncce : 8,
+					 i, search->rntis, search->si_only,
+					 search->discover);
+}
+
+/* Lowest RNTI above 'rnti' matched in any search block */
+static int pdcch_next_match(struct lte_pdcch_dec *dec, int nblks, int rnti)
+{
+	int next = -1;
+
+	for (int i = 0; i < nblks; i++) {
+		struct pdcch_cands *cands = &dec->cands[i];
+
+		for (int n = 0; n < cands->num_match; n++) {
+			if (cands->match[n] <= rnti)
+				continue;
+			if ((next < 0) || (cands->match[n] < next))
+				next = cands->match[n];
+			break;
+		}
+	}
+
+	return next;
+}
+
+static int pdcch_si_search(struct pdcch_slot *pdcch,
+			   struct lte_pdcch_dec *dec,
+			   const struct lte_rnti_set *rntis,
+			   signed char *seq, const struct lte_exec *exec)
+{
+	int i, n, nbits, nblks, rnti = -1;
+	struct pdcch_search search;
 
 #ifdef LOG_CCE_INFO
 	log_cce_info(pdcch->cfi, pdcch->len / 4,
 		     pdcch_num_cce(pdcch), pdcch_num_bits(pdcch));
 #endif
-	/* Make the deinterleaver persistent */
-	d = lte_alloc_pdcch_deinterlv(pdcch->len / 4, n_cell_id);
-	pdcch_deinterlv(d, (cquadf *) pdcch->pdcch->data,
-		(cquadf *) pdcch->pdcch_deinterlv->data);
-	lte_free_pdcch_deinterlv(d);
-
 	nbits = pdcch_num_cce_bits(pdcch);
 
-	lte_qpsk_decode2(pdcch->pdcch_deinterlv, pdcch->bits, nbits);
-	lte_scramble2(pdcch->bits, seq, nbits);
+	lte_qam_demap(pdcch->pdcch_deinterlv, NULL, seq,
+		      pdcch->bits, nbits, 2);
 
-	if (pdcch_num_cce(pdcch) < 8) {
-		pdcch_dci_power_search_si(pdcch, pdcch_num_cce(pdcch), 0, rnti);
-		return pdcch->num_dci;
+	/* One task per aggregation level 8 block including any remainder */
+	nblks = (pdcch_num_cce(pdcch) + 7) / 8;
+	if (!nblks)
+		return 0;
+	if (nblks > LTE_PDCCH_MAX_BLKS) {
+		LOG_PDCCH_ERR("Too many search blocks");
+		return -1;
 	}
 
-	for (i = 0; i < pdcch_num_cce(pdcch) / 8; i++) {
-		if (pdcch_dci_power_search_si(pdcch, 8, i, rnti) < 0)
+	/* Block decoders are created on first use and kept */
+	for (i = 0; i < nblks; i++) {
+		if (!dec->blks[i])
+			dec->blks[i] = lte_pdcch_blk_alloc();
+	}
+
+	search.pdcch = pdcch;
+	search.dec = dec;
+	search.rntis = rntis;
+	search.si_only = rntis->num == lte_rnti_set_has(rntis, LTE_SI_RNTI);
+	search.si_only &= !dec->discover;
+	search.discover = dec->discover;
+	search.ncce = pdcch_num_cce(pdcch);
+
+	lte_exec_run(exec, pdcch_search_task, &search, nblks);
+
+	for (i = 0; i < nblks; i++) {
+		if ((search.rc[i] < 0) && (search.ncce - 8 * i >= 8)) {
+			pdcch->num_dci = -1;
 			return -1;
+		}
 	}
 
-	int leftover_cces = pdcch_num_cce(pdcch) % 8;
+	for (i = 0; i < nblks; i++) {
+		struct pdcch_cands *cands = &dec->cands[i];
 
-	pdcch_dci_power_search_si(pdcch, leftover_cces, i, rnti);
+		memcpy(&dec->found[dec->num_found], cands->found,
+		       cands->num_found * sizeof(struct lte_pdcch_rnti));
+		dec->num_found += cands->num_found;
+	}
+
+	/* Merge by RNTI and then block order to match serial search results */
+	while ((rnti = pdcch_next_match(dec, nblks, rnti)) >= 0) {
+		for (i = 0; i < nblks; i++) {
+			for (n = 0; n < dec->lists[i].num; n++) {
+				if (dec->lists[i].dci[n].rnti != rnti)
+					continue;
+				if (pdcch->num_dci >= LTE_DCI_MAX)
+					break;
+				pdcch->dci[pdcch->num_dci++] =
+					dec->lists[i].dci[n];
+			}
+		}
+	}
 
 	return pdcch->num_dci;
 }
 
+void lte_rnti_set_clear(struct lte_rnti_set *set)
+{
+	memset(set, 0, sizeof(*set));
+}
+
+int lte_rnti_set_has(const struct lte_rnti_set *set, uint16_t rnti)
+{
+	return (set->map[rnti / 64] >> (rnti % 64)) & 1;
+}
+
+int lte_rnti_set_add(struct lte_rnti_set *set, uint16_t rnti)
+{
+	if (lte_rnti_set_has(set, rnti))
+		return 0;
+
+	set->map[rnti / 64] |= (uint64_t) 1 << (rnti % 64);
+	set->num++;
+
+	return 1;
+}
+
+int lte_rnti_set_del(struct lte_rnti_set *set, uint16_t rnti)
+{
+	if (!lte_rnti_set_has(set, rnti))
+		return 0;
+
+	set->map[rnti / 64] &= ~((uint64_t) 1 << (rnti % 64));
+	set->num--;
+
+	return 1;
+}
+
+struct lte_pdcch_dec *lte_pdcch_dec_alloc()
+{
+	return (struct lte_pdcch_dec *) calloc(1, sizeof(struct lte_pdcch_dec));
+}
+
+void lte_pdcch_dec_discover(struct lte_pdcch_dec *dec, int enable)
+{
+	dec->discover = enable;
+}
+
+int lte_pdcch_dec_found(const struct lte_pdcch_dec *dec,
+			const struct lte_pdcch_rnti **found)
+{
+	*found = dec->found;
+	return dec->num_found;
+}
+
+void lte_pdcch_dec_free(struct lte_pdcch_dec *dec)
+{
+	if (!dec)
+		return;
+
+	for (int i = 0; i < LTE_PDCCH_MAX_BLKS; i++)
+		lte_pdcch_blk_free(dec->blks[i]);
+
+	pdcch_cache_free(&dec->cache);
+	free(dec);
+}
+
 /* Decode one slot of sample data using specified reference signal map */
 int lte_decode_pdcch(struct lte_subframe **subframe, int chans,
-		     int cfi, int n_cell_id, int ng, uint16_t rnti,
-		     signed char *seq)
+		     struct lte_pdcch_dec *dec,
+		     int cfi, int n_cell_id, int ng,
+		     const struct lte_rnti_set *rntis,
+		     signed char *seq, const struct lte_exec *exec)
 {
-	int num = 0, phich_groups;
-	struct pdcch_slot *pdcch[chans];
+	int num = 0;
+	struct pdcch_slot *pdcch;
+	struct pdcch_map *map;
+	struct lte_pdcch_dec *tmp = NULL;
+
+	if (dec)
+		dec->num_found = 0;
+
+	if (!rntis->num && !(dec && dec->discover))
+		return 0;
 
 	if (!subframe[0]->assigned) {
 		fprintf(stderr, "PDCCH: Subframe not assigned\n");
 		return -1;
 	}
 
-	phich_groups = lte_phich_num_groups(subframe[0]->rbs, ng,
-					    LTE_PHICH_DUR_NORMAL);
-	if (phich_groups < 0) {
-		fprintf(stderr, "PDCCH: Invalid PHICH group\n");
-		return -1;
-	}
-
 	if (subframe[0]->rbs <= 10)
 		cfi++;
 
-	int *res = subframe[0]->reserve;
-	for (int i = 0; i < chans; i++) {
-		pdcch[i] = pdcch_slot_alloc(&subframe[i]->slot[0],
-					    cfi, phich_groups, res);
-		if (!pdcch[i]) {
-			fprintf(stderr, "PDCCH: Allocation failed\n");
-			exit(-1);
-		}
-	}
+	if (!dec)
+		dec = tmp = lte_pdcch_dec_alloc();
 
-	if (lte_gen_phich_indices(res, subframe[0]->rbs,
-				  n_cell_id, ng, LTE_PHICH_DUR_NORMAL) < 0) {
-		fprintf(stderr, "PDCCH: Failed to set PHICH symbol indices\n");
+	map = pdcch_cache_map(&dec->cache, subframe[0], cfi, n_cell_id, ng);
+	if (!map) {
+		fprintf(stderr, "PDCCH: Control region mapping failed\n");
 		goto release;
 	}
 
-#if PDCCH_DEBUGxxx
-	printf("PHICH: Reservation table\n");
-	for (int i = 0; i < 600; i++)
-		printf("%2i   %i   %i\n",
-			i, subframe[0]->reserve[i],
-			chk_reserved(pdcch[0], i / 12, i % 12));
-#endif
-
-	if (pdcch_extract_syms(pdcch, chans) < 0) {
+	if (pdcch_extract_syms(map, subframe, chans) < 0) {
 		fprintf(stderr, "PDCCH: Symbol extraction failed\n");
 		goto release;
 	}
 
-	if (pdcch_si_search(pdcch[0], rnti, seq, n_cell_id) > 0) {
-		num = pdcch[0]->num_dci;
+	pdcch = &dec->slot;
+	pdcch->cfi = cfi;
+	pdcch->len = map->len;
+	pdcch->tx_ants = subframe[0]->tx_ants;
+	pdcch->slot = &subframe[0]->slot[0];
+	pdcch->pdcch_deinterlv = map->data;
+	pdcch->bits = map->bits;
+	pdcch->num_dci = 0;
+
+	if (pdcch_si_search(pdcch, dec, rntis, seq, exec) > 0) {
+		num = pdcch->num_dci;
 		memcpy(subframe[0]->dci,
-		       pdcch[0]->dci, num * sizeof(struct lte_dci));
+		       pdcch->dci, num * sizeof(struct lte_dci));
 		subframe[0]->num_dci = num;
 	}
 
 release:
-	for (int i = 0; i < chans; i++)
-		free_pdcch_slot(pdcch[i]);
+	lte_pdcch_dec_free(tmp);
 
 	return num;
 }
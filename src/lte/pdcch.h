@@ -5,9 +5,66 @@
 
 struct lte_subframe;
 struct lte_dci;
+struct lte_exec;
+struct lte_pdcch_dec;
 
+/*
+ * Monitored RNTI set
+ *
+ * RNTI values are 16 bits wide, so membership is a direct indexed bitmap
+ * and lookup of a candidate CRC remainder is a single bit test.
+ */
+struct lte_rnti_set {
+	int num;
+	uint64_t map[(1 << 16) / 64];
+};
+
+void lte_rnti_set_clear(struct lte_rnti_set *set);
+int lte_rnti_set_add(struct lte_rnti_set *set, uint16_t rnti);
+int lte_rnti_set_del(struct lte_rnti_set *set, uint16_t rnti);
+int lte_rnti_set_has(const struct lte_rnti_set *set, uint16_t rnti);
+
+/*
+ * Persistent blind search state reused across subframes. Not shared
+ * between concurrent lte_decode_pdcch() calls. Control region gather
+ * tables are cached per CFI value until cell ID, bandwidth or PHICH
+ * resource change.
+ */
+struct lte_pdcch_dec *lte_pdcch_dec_alloc();
+void lte_pdcch_dec_free(struct lte_pdcch_dec *dec);
+
+/*
+ * Blind RNTI discovery
+ *
+ * When enabled, every candidate of the control region is decoded at all
+ * aggregation levels regardless of the monitored set. Candidates whose CRC
+ * remainder is a C-RNTI value and whose re-encoded codeword matches the
+ * received bits are reported after each search with the DCI format,
+ * aggregation level and correlation score.
+ */
+struct lte_pdcch_rnti {
+	uint16_t rnti;
+	int type;
+	int lev;
+	float score;
+};
+
+void lte_pdcch_dec_discover(struct lte_pdcch_dec *dec, int enable);
+int lte_pdcch_dec_found(const struct lte_pdcch_dec *dec,
+			const struct lte_pdcch_rnti **found);
+
+/*
+ * Search for DCI messages addressed to any RNTI in 'rntis'. Each candidate
+ * is decoded once regardless of the number of monitored RNTIs. DCI
+ * messages are ordered by RNTI and carry the matching RNTI value.
+ *
+ * Search blocks are dispatched on executor (NULL for serial search). A NULL
+ * search state allocates temporary state for the call.
+ */
 int lte_decode_pdcch(struct lte_subframe **subframe, int chans,
-		     int cfi, int n_cell_id, int ng, uint32_t rnti,
-		     signed char *pdcch_seq);
+		     struct lte_pdcch_dec *dec,
+		     int cfi, int n_cell_id, int ng,
+		     const struct lte_rnti_set *rntis,
+		     signed char *pdcch_seq, const struct lte_exec *exec);
 
 #endif /* _LTE_PDCCH_ */
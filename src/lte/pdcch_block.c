@@ -32,11 +32,22 @@
 #include "log.h"
 
 #define L_CRC16		16
-#define MAX_A		51
+#define MAX_A		LTE_PDCCH_MAX_A
 #define MAX_K		(MAX_A + L_CRC16)
 #define MAX_D		MAX_K
 #define MAX_E		576
 
+/* 3GPP TS 36.212 Release 8: 5.1.3.1 "Tail biting convolutional coding" */
+static const struct lte_conv_code pdcch_code = {
+	.n = 3,
+	.k = 7,
+	.len = MAX_K,
+	.gen = { 0133, 0171, 0165 },
+	.rgen = 0,
+	.punc = NULL,
+	.term = CONV_TERM_TAIL_BITING,
+};
+
 /* 3GPP TS 36.212 Release 8: 5.3.3 "Downlink control information" */
 struct lte_pdcch_blk {
 	uint8_t *a;
@@ -52,15 +63,26 @@ struct lte_pdcch_blk {
 	int E;
 
 	struct lte_rate_matcher *match;
+	struct vdecoder *vdec;
+
+	/* Coded and decoded candidates of a batch */
+	int8_t seq[LTE_PDCCH_BLK_BATCH][3 * MAX_D];
+	uint8_t cand[LTE_PDCCH_BLK_BATCH][MAX_K];
 };
 
-/* Allocate block processing chain */
+/*
+ * Allocate block processing chain
+ *
+ * The decoder is sized for the largest DCI payload so that a single block
+ * object serves every candidate format and aggregation level.
+ */
 struct lte_pdcch_blk *lte_pdcch_blk_alloc()
 {
 	struct lte_pdcch_blk *dblk;
 
 	dblk = (struct lte_pdcch_blk *) calloc(1, sizeof(struct lte_pdcch_blk));
 	dblk->match = lte_rate_matcher_alloc();
+	dblk->vdec = alloc_vdec(&pdcch_code);
 
 	return dblk;
 }
@@ -72,6 +94,7 @@ void lte_pdcch_blk_free(struct lte_pdcch_blk *dblk)
 		return;
 
 	lte_rate_matcher_free(dblk->match);
+	free_vdec(dblk->vdec);
 	free(dblk);
 
 	dblk = NULL;
@@ -95,28 +118,26 @@ int lte_pdcch_blk_init(struct lte_pdcch_blk *dblk, int A, int E)
 	return 0;
 }
 
-/* 3GPP TS 36.212 Release 8: 5.3.3.3 "Channel coding" */
-static int lte_pdcch_blk_chan_decode(struct lte_pdcch_blk *dblk)
+/* Interleave the three coded streams into decoder input order */
+static void lte_pdcch_blk_pack(struct lte_pdcch_blk *dblk, int8_t *d)
 {
-	struct lte_conv_code code = {
-		.n = 3,
-		.k = 7,
-		.len = dblk->K,
-		.gen = { 0133, 0171, 0165 },
-		.rgen = 0,
-		.punc = NULL,
-		.term = CONV_TERM_TAIL_BITING,
-        };
-
-	int8_t d[dblk->D * 3];
-
 	for (int i = 0; i < dblk->D; i++) {
 		d[3 * i + 0] = dblk->d[0][i];
 		d[3 * i + 1] = dblk->d[1][i];
 		d[3 * i + 2] = dblk->d[2][i];
-        }
+	}
+}
+
+/* 3GPP TS 36.212 Release 8: 5.3.3.3 "Channel coding" */
+static int lte_pdcch_blk_chan_decode(struct lte_pdcch_blk *dblk)
+{
+	struct lte_conv_code code = pdcch_code;
+	int8_t d[dblk->D * 3];
+
+	code.len = dblk->K;
 
-	lte_conv_decode(&code, d, dblk->c);
+	lte_pdcch_blk_pack(dblk, d);
+	lte_conv_decode_vdec(dblk->vdec, &code, d, dblk->c);
 
 	return 0;
 }
@@ -139,16 +160,28 @@ static int lte_pdcch_blk_rate_unmatch(struct lte_pdcch_blk *dblk)
 	return 0;
 }
 
-/* 3GPP TS 36.212 Release 8: 5.3.3.2 "CRC attachment" */
-static int lte_pdcch_blk_crc(struct lte_pdcch_blk *dblk, uint16_t rnti)
+/*
+ * 3GPP TS 36.212 Release 8: 5.3.3.2 "CRC attachment"
+ *
+ * The attached CRC is scrambled with the RNTI, so the remainder of the
+ * received block is the only RNTI for which the CRC check passes.
+ */
+static uint16_t lte_pdcch_crc_rnti(const uint8_t *c, int A)
 {
-	uint16_t reg0 = lte_crc16_gen(dblk->c, dblk->A);
-	uint16_t reg1 = lte_crc16_pack(&dblk->c[dblk->A], L_CRC16);
+	uint16_t reg0 = lte_crc16_gen(c, A);
+	uint16_t reg1 = lte_crc16_pack(&c[A], L_CRC16);
 
-	if (reg0 == (reg1 ^ rnti))
-		return 1;
+	return reg0 ^ reg1;
+}
 
-	return 0;
+static int lte_pdcch_crc_check(const uint8_t *c, int A, uint16_t rnti)
+{
+	return lte_pdcch_crc_rnti(c, A) == rnti;
+}
+
+static int lte_pdcch_blk_crc(struct lte_pdcch_blk *dblk, uint16_t rnti)
+{
+	return lte_pdcch_crc_check(dblk->c, dblk->A, rnti);
 }
 
 /*
@@ -166,6 +199,101 @@ int lte_pdcch_blk_decode(struct lte_pdcch_blk *dblk, uint16_t rnti)
 	return lte_pdcch_blk_crc(dblk, rnti);
 }
 
+/*
+ * Rate recovery runs per candidate, after which all candidates share one
+ * lock-step Viterbi pass since the payload size, and therefore the trellis
+ * length, is common to the batch.
+ */
+int lte_pdcch_blk_decode_batch(struct lte_pdcch_blk *dblk, int A, int n,
+			       int8_t **e, const int *E,
+			       uint8_t **a, uint16_t *rnti)
+{
+	struct lte_conv_code code = pdcch_code;
+	const int8_t *seq[LTE_PDCCH_BLK_BATCH];
+	uint8_t *cand[LTE_PDCCH_BLK_BATCH];
+	int i;
+
+	if ((n < 0) || (n > LTE_PDCCH_BLK_BATCH))
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		if (lte_pdcch_blk_init(dblk, A, E[i]) < 0)
+			return -1;
+
+		memcpy(dblk->e, e[i], E[i] * sizeof(int8_t));
+
+		if (lte_pdcch_blk_rate_unmatch(dblk))
+			return -1;
+
+		lte_pdcch_blk_pack(dblk, dblk->seq[i]);
+		seq[i] = dblk->seq[i];
+		cand[i] = dblk->cand[i];
+	}
+
+	code.len = A + L_CRC16;
+	if (lte_conv_decode_batch(dblk->vdec, &code, n, seq, cand, NULL) < 0)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		rnti[i] = lte_pdcch_crc_rnti(cand[i], A);
+		memcpy(a[i], cand[i], A * sizeof(uint8_t));
+	}
+
+	return 0;
+}
+
+/*
+ * Re-encode and rate match the candidate, then correlate with the received
+ * soft bits. Hard decisions of a Viterbi decoded noise block still agree
+ * with a majority of the received bits, so the score is soft weighted.
+ */
+float lte_pdcch_blk_verify(struct lte_pdcch_blk *dblk, int A,
+			   const uint8_t *a, uint16_t rnti,
+			   const int8_t *e, int E)
+{
+	struct lte_conv_code code = pdcch_code;
+	uint8_t d[3 * MAX_D];
+	int8_t r[MAX_E];
+	uint16_t crc;
+	int i, sum = 0, mag = 0;
+
+	if (lte_pdcch_blk_init(dblk, A, E) < 0)
+		return -1.0f;
+
+	memcpy(dblk->c, a, A * sizeof(uint8_t));
+
+	crc = lte_crc16_gen(a, A) ^ rnti;
+	for (i = 0; i < L_CRC16; i++)
+		dblk->c[A + i] = (crc >> (L_CRC16 - 1 - i)) & 0x01;
+
+	code.len = dblk->K;
+	if (lte_conv_encode(&code, dblk->c, d) < 0)
+		return -1.0f;
+
+	for (i = 0; i < dblk->D; i++) {
+		dblk->d[0][i] = d[3 * i + 0] ? 1 : -1;
+		dblk->d[1][i] = d[3 * i + 1] ? 1 : -1;
+		dblk->d[2][i] = d[3 * i + 2] ? 1 : -1;
+	}
+
+	struct lte_rate_matcher_io io = {
+		.D = dblk->D,
+		.E = E,
+		.d = { dblk->d[0], dblk->d[1], dblk->d[2] },
+		.e = r,
+	};
+
+	if (lte_conv_rate_match_fw(dblk->match, &io))
+		return -1.0f;
+
+	for (i = 0; i < E; i++) {
+		sum += r[i] * e[i];
+		mag += abs(e[i]);
+	}
+
+	return mag ? (float) sum / mag : 0.0f;
+}
+
 /*
  * 3GPP TS 36.212 Release 8: 5.3.2.5 "Code block concatentation"
  *
@@ -5,6 +5,10 @@
 
 struct lte_pdcch_blk;
 
+/* Largest DCI payload and number of candidates decoded in one batch */
+#define LTE_PDCCH_MAX_A		51
+#define LTE_PDCCH_BLK_BATCH	16
+
 /*
  * Allocate and initialize PDCCH block object
  *     A   - Raw transport block size
@@ -17,6 +21,26 @@ void lte_pdcch_blk_free(struct lte_pdcch_blk *dblk);
 /* Decode 'e' block of soft bits into 'a' block of bits */
 int lte_pdcch_blk_decode(struct lte_pdcch_blk *dblk, uint16_t rnti);
 
+/*
+ * Decode 'n' candidates of equal payload size 'A' in one pass. Candidate
+ * 'i' is read from 'e[i]' with rate matched length 'E[i]' and its bits
+ * without CRC attachment are written to 'a[i]'. The RNTI that passes the
+ * CRC check of each candidate is written to 'rnti[i]'. Returns a negative
+ * value on error.
+ */
+int lte_pdcch_blk_decode_batch(struct lte_pdcch_blk *dblk, int A, int n,
+			       int8_t **e, const int *E,
+			       uint8_t **a, uint16_t *rnti);
+
+/*
+ * Re-encode 'A' payload bits 'a' with the CRC attachment masked by 'rnti'
+ * and return the soft correlation with the 'E' received bits 'e', between
+ * -1 and 1 where a noise free match scores 1.
+ */
+float lte_pdcch_blk_verify(struct lte_pdcch_blk *dblk, int A,
+			   const uint8_t *a, uint16_t rnti,
+			   const int8_t *e, int E);
+
 /* Request 'e' buffer - Post code block concatenation */
 int8_t *lte_pdcch_blk_ebuf(struct lte_pdcch_blk *dblk, int len);
 
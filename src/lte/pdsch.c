@@ -41,87 +41,43 @@
 
 #define LTE_RB_LEN		12
 
-struct pdsch_slot {
+/* Symbols of one subframe and subframe classes 0, 5 and all others */
+#define PDSCH_NUM_SYMS		14
+#define PDSCH_NUM_CLASSES	3
+
+/* Data subcarrier pairs of one resource block within one symbol */
+struct pdsch_rb_map {
 	int num;
-	int cfi;
-	struct lte_slot *slot;
-	struct lte_sym *syms[7];
+	int sc[LTE_RB_LEN / 2][2];
+};
+
+/*
+ * Persistent demapping state
+ *
+ * Data subcarrier pairs exclude reference, PBCH and synchronization signal
+ * positions, which depend only on cell ID, bandwidth, antennas and the
+ * subframe class. Maps cover every symbol and resource block of the
+ * subframe so that the control region is skipped by CFI at extraction.
+ * Extracted symbols and their channel weights are written to buffers sized
+ * for the full bandwidth. Scrambling sequences are cached across subframes.
+ */
+struct lte_pdsch_dec {
+	int rbs;
+	int cell_id;
+	int tx_ants;
+	struct pdsch_rb_map *maps[PDSCH_NUM_CLASSES];
+	struct cxvec *data;
+	float *weights;
+	struct lte_scram_cache *scram;
 };
 
 struct pdsch_sym_blk {
 	struct cxvec *vec;
+	float *w;
 	int idx;
 	int len;
 };
 
-static struct pdsch_sym_blk *pdsch_sym_blk_alloc(int ant, int n_vrb, int cfi)
-{
-	int len;
-	struct pdsch_sym_blk *sym_blk;
-
-	if ((ant < 0) || (ant > 2) || (n_vrb < 0) || (cfi < 0))
-		return NULL;
-
-	if (ant == 2)
-		len = n_vrb * (12 * (14 - cfi) - 12);
-	else
-		len = n_vrb * (12 * (14 - cfi) - 6);
-
-	sym_blk = malloc(sizeof *sym_blk);
-	sym_blk->idx = 0;
-	sym_blk->len = len;
-	sym_blk->vec = cxvec_alloc_simple(len);
-
-	return sym_blk;
-}
-
-static void pdsch_sym_blk_free(struct pdsch_sym_blk *sym_blk)
-{
-	if (!sym_blk)
-		return;
-
-	cxvec_free(sym_blk->vec);
-	free(sym_blk);
-}
-
-static struct pdsch_slot *pdsch_slot_alloc(struct lte_slot *slot,
-					   int num, int cfi)
-{
-	struct pdsch_slot *pdsch;
-
-	pdsch = malloc(sizeof *pdsch);
-	pdsch->num = num;
-	pdsch->cfi = !num ? cfi : 0;
-	pdsch->slot = slot;
-
-	for (int i = 0; i < 7; i++)
-		pdsch->syms[i] = &slot->syms[i];
-
-	return pdsch;
-}
-
-static void pdsch_slot_free(struct pdsch_slot *pdsch)
-{
-	free(pdsch);
-}
-
-enum pdsch_res_type {
-	PDSCH_NORM,
-	PDSCH_REF,
-	PDSCH_SPECIAL,
-};
-
-static int chk_reserved(struct pdsch_slot *pdsch, int sc)
-{
-	int *pos = pdsch->slot->subframe->ref_indices;
-
-	if ((sc == pos[0]) || (sc == pos[1]) ||
-	    (sc == pos[2]) || (sc == pos[3]))
-		return 1;
-
-	return 0;
-}
-
 static int reserved_rb(int rbs, int rb, int slot, int l, int subframe)
 {
 	int start, end;
@@ -184,61 +140,78 @@ static int reserved_rb(int rbs, int rb, int slot, int l, int subframe)
 	return 0;
 }
 
-static int pdsch_extract_norm(struct pdsch_slot **pdsch,
-			      int rx_antennas, int tx_antennas,
-			      struct pdsch_sym_blk *sym_blk,
-			      int l, int sf, int rb)
+static int chk_reserved(const int *pos, int sc)
 {
-	int n, end;
+	if ((sc == pos[0]) || (sc == pos[1]) ||
+	    (sc == pos[2]) || (sc == pos[3]))
+		return 1;
 
-        switch (reserved_rb((*pdsch)->slot->rbs, rb,
-			    (*pdsch)->num, l, sf)) {
-	case 1:
-//		printf("PDSCH: Skipping RB %i, %i\n", rb, l);
-		return 0;
-	case 2:
-		n = 0;
-		end = 6;
-		break;
-	case 3:
-		n = 6;
-		end = 12;
-		break;
-	default:
-		n = 0;
-		end = 12;
-	}
+	return 0;
+}
 
-	for (; n < end; n += 2) {
-//		printf("l %i, rb %i, sc %i, idx %i\n",
-//		       l, rb, 2 * n, sym_blk->idx);
+static void pdsch_map_pair(struct pdsch_rb_map *map, int sc0, int sc1)
+{
+	map->sc[map->num][0] = sc0;
+	map->sc[map->num][1] = sc1;
+	map->num++;
+}
 
-		struct lte_sym *s0, *s1 = NULL;
+static void pdsch_map_norm(struct pdsch_rb_map *map, int n, int end)
+{
+	for (; n < end; n += 2)
+		pdsch_map_pair(map, n, n + 1);
+}
 
-		s0 = (*pdsch)->syms[l];
-		if (rx_antennas == 2)
-			s1 = pdsch[1]->syms[l];
+static void pdsch_map_ref1(struct pdsch_rb_map *map,
+			   struct lte_subframe *subframe,
+			   int slot, int l, int n, int end)
+{
+	while (n + 1 < end) {
+		if (lte_chk_ref(subframe, slot, l, n, 1)) {
+			pdsch_map_pair(map, n + 1, n + 2);
+			n += 3;
+		} else if (lte_chk_ref(subframe, slot, l, n + 1, 1)) {
+			pdsch_map_pair(map, n + 0, n + 2);
+			n += 3;
+		} else {
+			pdsch_map_pair(map, n + 0, n + 1);
+			n += 2;
+		}
+	}
+}
 
-		lte_unprecode(s0, s1,
-                              tx_antennas, rx_antennas, rb,
-			      n, n + 1,
-                              sym_blk->vec, sym_blk->idx);
-		sym_blk->idx += 2;
+static int pdsch_map_ref2(struct pdsch_rb_map *map,
+			  const int *pos, int n, int end)
+{
+	for (; n < end; n += 6) {
+		if (chk_reserved(pos, n)) {
+			pdsch_map_pair(map, n + 1, n + 2);
+			pdsch_map_pair(map, n + 4, n + 5);
+		} else if (chk_reserved(pos, n + 1)) {
+			pdsch_map_pair(map, n + 0, n + 2);
+			pdsch_map_pair(map, n + 3, n + 5);
+		} else if (chk_reserved(pos, n + 2)) {
+			pdsch_map_pair(map, n + 0, n + 1);
+			pdsch_map_pair(map, n + 3, n + 4);
+		} else {
+			LOG_PDSCH_ERR("PBCH: Reference map fault");
+			return -1;
+		}
 	}
 
 	return 0;
 }
 
-static int pdsch_extract_ref1(struct pdsch_slot **pdsch, int rx_antennas,
-			      struct pdsch_sym_blk *sym_blk,
-			      int l, int subframe, int rb)
+static int pdsch_map_rb(struct pdsch_rb_map *map,
+			struct lte_subframe *subframe,
+			int slot, int l, int sf, int rb)
 {
 	int n, end;
 
-        switch (reserved_rb((*pdsch)->slot->rbs, rb,
-			    (*pdsch)->num, l, subframe)) {
+	map->num = 0;
+
+	switch (reserved_rb(subframe->rbs, rb, slot, l, sf)) {
 	case 1:
-//		printf("PDSCH: Skipping RB %i, %i\n", rb, l);
 		return 0;
 	case 2:
 		n = 0;
@@ -253,144 +226,183 @@ static int pdsch_extract_ref1(struct pdsch_slot **pdsch, int rx_antennas,
 		end = 12;
 	}
 
-	while (n+1 < end) {
-		int sc0, sc1;
+	switch (l) {
+	case 0:
+	case 4:
+		if (subframe->tx_ants == 2)
+			return pdsch_map_ref2(map, subframe->ref_indices,
+					      n, end);
+		else if (subframe->tx_ants == 1)
+			pdsch_map_ref1(map, subframe, slot, l, n, end);
+		break;
+	case 1:
+	case 2:
+	case 3:
+	case 5:
+	case 6:
+		pdsch_map_norm(map, n, end);
+		break;
+	default:
+		return -1;
+	}
 
-		if (lte_chk_ref((*pdsch)->slot->subframe,
-				(*pdsch)->num, l, n, 1)) {
-			sc0 = n + 1;
-			sc1 = n + 2;
-			n += 3;
-		} else if (lte_chk_ref((*pdsch)->slot->subframe,
-				       (*pdsch)->num, l, n + 1, 1)) {
-			sc0 = n + 0;
-			sc1 = n + 2;
-			n += 3;
-		} else {
-			sc0 = n + 0;
-			sc1 = n + 1;
-			n += 2;
+	return 0;
+}
+
+static int pdsch_sf_class(int sf)
+{
+	if (!sf)
+		return 0;
+	else if (sf == 5)
+		return 1;
+
+	return 2;
+}
+
+static void pdsch_dec_reset(struct lte_pdsch_dec *dec)
+{
+	for (int i = 0; i < PDSCH_NUM_CLASSES; i++) {
+		free(dec->maps[i]);
+		dec->maps[i] = NULL;
+	}
+
+	if (dec->data)
+		cxvec_free(dec->data);
+	dec->data = NULL;
+
+	free(dec->weights);
+	dec->weights = NULL;
+}
+
+/*
+ * Return the resource element map of the subframe, rebuilding all maps on
+ * change of cell and each subframe class map on first use
+ */
+static struct pdsch_rb_map *pdsch_dec_map(struct lte_pdsch_dec *dec,
+					  struct lte_subframe *subframe,
+					  int sf)
+{
+	int rbs = subframe->rbs;
+	int class = pdsch_sf_class(sf);
+	struct pdsch_rb_map *map;
+
+	if (!dec->data || (dec->rbs != rbs) ||
+	    (dec->cell_id != subframe->cell_id) ||
+	    (dec->tx_ants != subframe->tx_ants)) {
+		pdsch_dec_reset(dec);
+
+		dec->rbs = rbs;
+		dec->cell_id = subframe->cell_id;
+		dec->tx_ants = subframe->tx_ants;
+		dec->data = cxvec_alloc_simple(rbs * LTE_RB_LEN *
+					       PDSCH_NUM_SYMS);
+		if (!dec->data)
+			return NULL;
+
+		dec->weights = malloc(rbs * LTE_RB_LEN * PDSCH_NUM_SYMS *
+				      sizeof(float));
+		if (!dec->weights) {
+			pdsch_dec_reset(dec);
+			return NULL;
 		}
+	}
 
-		struct lte_sym *s0, *s1 = NULL;
+	if (dec->maps[class])
+		return dec->maps[class];
 
-		s0 = pdsch[0]->syms[l];
-		if (rx_antennas == 2)
-			s1 = pdsch[1]->syms[l];
+	map = malloc(PDSCH_NUM_SYMS * rbs * sizeof(struct pdsch_rb_map));
+	if (!map)
+		return NULL;
 
-		lte_unprecode(s0, s1, 1, rx_antennas, rb,
-			      sc0, sc1, sym_blk->vec, sym_blk->idx);
-		sym_blk->idx += 2;
+	for (int i = 0; i < PDSCH_NUM_SYMS; i++) {
+		for (int rb = 0; rb < rbs; rb++) {
+			if (pdsch_map_rb(&map[i * rbs + rb], subframe,
+					 i / 7, i % 7, sf, rb) < 0) {
+				free(map);
+				return NULL;
+			}
+		}
 	}
 
-	return 0;
+	dec->maps[class] = map;
+
+	return map;
 }
 
-static int pdsch_extract_ref2(struct pdsch_slot **pdsch, int rx_antennas,
-			      struct pdsch_sym_blk *sym_blk,
-			      int l, int subframe, int rb)
+/*
+ * Gather data symbols of allocated resource blocks in symbol order from
+ * both slots and perform antenna processing along with the channel power
+ * of each symbol
+ */
+static int pdsch_extract_symbols(struct lte_subframe **subframe, int chans,
+				 struct pdsch_rb_map *map, int cfi,
+				 struct lte_riv *riv,
+				 struct pdsch_sym_blk *sym_blk)
 {
-	int n = 0, end = 12;
+	int i, l, n, rb;
+	int rbs = subframe[0]->rbs;
+	int tx_ants = subframe[0]->tx_ants;
+	int *prbs_indices;
+	struct lte_sym *s0, *s1 = NULL;
+	struct pdsch_rb_map *m;
 
-        switch (reserved_rb((*pdsch)->slot->rbs, rb,
-			    (*pdsch)->num, l, subframe)) {
-	case 1:
-//		printf("PDSCH: Skipping RB %i, %i\n", rb, l);
-		return 0;
-	case 2:
-		n = 0;
-		end = 6;
-		break;
-	case 3:
-		n = 6;
-		end = 12;
-		break;
+	if (riv->n_vrb >= 110) {
+		LOG_PDSCH_ERR("Invalid RIV number");
+		return -1;
 	}
 
-	for (; n < end; n += 6) {
-		int sc0, sc1, sc2, sc3;
-
-		if (chk_reserved(*pdsch, n)) {
-			sc0 = n + 1;
-			sc1 = n + 2;
-			sc2 = n + 4;
-			sc3 = n + 5;
-		} else if (chk_reserved(*pdsch, n + 1)) {
-			sc0 = n + 0;
-			sc1 = n + 2;
-			sc2 = n + 3;
-			sc3 = n + 5;
-		} else if (chk_reserved(*pdsch, n + 2)) {
-			sc0 = n + 0;
-			sc1 = n + 1;
-			sc2 = n + 3;
-			sc3 = n + 4;
-		} else {
-			LOG_PDSCH_ERR("PBCH: Reference map fault");
-			return -1;
-		}
+	for (n = 0; n < 2; n++) {
+		prbs_indices = n ? riv->prbs1 : riv->prbs0;
 
-//		printf("l %i, rb %i, sc %i, idx %i\n",
-//			l, rb, 2 * n, sym_blk->idx);
+		for (l = n ? 0 : cfi; l < 7; l++) {
+			s0 = &subframe[0]->slot[n].syms[l];
+			if (chans == 2)
+				s1 = &subframe[1]->slot[n].syms[l];
 
-		struct lte_sym *s1, *s0;
+			for (i = 0; i < riv->n_vrb; i++) {
+				rb = prbs_indices[i];
+				m = &map[(7 * n + l) * rbs + rb];
 
-		s0 = pdsch[0]->syms[l];
-		if (rx_antennas == 2)
-			s1 = pdsch[1]->syms[l];
-		else
-			s1 = NULL;
+				if (lte_unprecode_rb(s0, s1, tx_ants, chans, rb,
+						     m->sc, m->num,
+						     sym_blk->vec, sym_blk->w,
+						     sym_blk->idx) < 0)
+					return -1;
 
-		lte_unprecode(s0, s1, 2, rx_antennas, rb,
-			      sc0, sc1, sym_blk->vec, sym_blk->idx);
-		sym_blk->idx += 2;
-		lte_unprecode(s0, s1, 2, rx_antennas, rb,
-			      sc2, sc3, sym_blk->vec, sym_blk->idx);
-		sym_blk->idx += 2;
+				sym_blk->idx += 2 * m->num;
+			}
+		}
 	}
 
 	return 0;
 }
 
-static int pdsch_extract_rb(struct pdsch_slot **slot, int rx_antennas,
-			    int tx_antennas,
-			    int l, int subframe,
-			    struct pdsch_sym_blk *sym_blk, int rb)
+/* Scale channel weights to unit mean */
+static void pdsch_norm_weights(float *w, int len)
 {
-	switch (l) {
-	case 0:
-	case 4:
-		if (tx_antennas == 2)
-			pdsch_extract_ref2(slot, rx_antennas,
-					   sym_blk, l, subframe, rb);
-		else if (tx_antennas == 1)
-			pdsch_extract_ref1(slot, rx_antennas,
-					   sym_blk, l, subframe, rb);
-		break;
-	case 1:
-	case 2:
-	case 3:
-	case 5:
-	case 6:
-		pdsch_extract_norm(slot, rx_antennas, tx_antennas,
-				   sym_blk, l, subframe, rb);
-		break;
-	default:
-		return -1;
+	int i;
+	float sum = 0.0f;
+
+	for (i = 0; i < len; i++)
+		sum += w[i];
+
+	if (!(sum > 0.0f)) {
+		for (i = 0; i < len; i++)
+			w[i] = 1.0f;
+		return;
 	}
 
-	return 0;
+	sum = (float) len / sum;
+	for (i = 0; i < len; i++)
+		w[i] *= sum;
 }
 
-static void gen_scram_seq(int8_t *seq, int len, int sf,
-			  int n_id_cell, unsigned rnti)
+static unsigned pdsch_scram_init(int sf, int n_id_cell, unsigned rnti)
 {
-	unsigned c_init, q = 0;
-
-	c_init = rnti * (1 << 14) + q * (1 << 13) +
-		 (2 * sf / 2) * (1 << 9) + n_id_cell;
+	unsigned q = 0;
 
-	lte_pbch_gen_scrambler(c_init, seq, len);
+	return rnti * (1 << 14) + q * (1 << 13) +
+	       (2 * sf / 2) * (1 << 9) + n_id_cell;
 }
 
 static void pdsch_log_blk_info0(int tbs, int G)
@@ -440,12 +452,14 @@ static int pdsch_get_rv(struct lte_dci *dci, struct lte_time *ltime)
 
 #define SI_RNTI		0xffff
 
-static int pdsch_decode_blk(struct pdsch_sym_blk *pblk, int n_id_cell,
+static int pdsch_decode_blk(struct pdsch_sym_blk *pblk,
+			    struct lte_scram_cache *scram, int n_id_cell,
 			    struct lte_dci *dci, int vrb,
 			    struct lte_pdsch_blk *tblk, struct lte_time *ltime)
 {
 	int i, G, rv;
 	signed char *f;
+	const uint32_t *seq;
 
 	int mod = lte_tbs_get_mod_order(dci);
 	if (mod < 0)
@@ -483,28 +497,21 @@ static int pdsch_decode_blk(struct pdsch_sym_blk *pblk, int n_id_cell,
 		LOG_PDSCH_ERR("Physical bits size mismatch");
 	}
 
-	switch (mod) {
-	case 2:
-		lte_qpsk_decode2(pblk->vec, f, G);
-		break;
-	case 4:
-		lte_qam16_decode(pblk->vec, f, G);
-		break;
-	case 6:
-		lte_qam64_decode(pblk->vec, f, G);
-		break;
-	case 8:
-		lte_qam256_decode(pblk->vec, f, G);
-		break;
-	default:
-		LOG_PDSCH_ERR("Invalid modulation format");
+	/* Channel weighted soft demapping and descrambling */
+	seq = lte_scram_cache_get(scram, pdsch_scram_init(ltime->subframe,
+							  n_id_cell,
+							  dci->rnti), G);
+	if (!seq) {
+		LOG_PDSCH_ERR("Scrambling sequence allocation failed");
 		return -1;
 	}
 
-	/* Descramble */
-	int8_t seq[G];
-	gen_scram_seq(seq, G, ltime->subframe, n_id_cell, dci->rnti);
-	lte_scramble2(f, seq, G);
+	pdsch_norm_weights(pblk->w, pblk->idx);
+
+	if (lte_qam_demap_mask(pblk->vec, pblk->w, seq, f, G, mod) < 0) {
+		LOG_PDSCH_ERR("Invalid modulation format");
+		return -1;
+	}
 
 	/* Decode the transport block */
 	if (!lte_pdsch_blk_decode(tblk, rv))
@@ -525,49 +532,40 @@ static int pdsch_decode_blk(struct pdsch_sym_blk *pblk, int n_id_cell,
 	return 0;
 }
 
-static int pdsch_extract_symbols(struct pdsch_slot **slot,
-				 int rx_antennas, int tx_antennas,
-				 int sf, struct lte_riv *riv,
-				 struct pdsch_sym_blk *sym_blk)
+struct lte_pdsch_dec *lte_pdsch_dec_alloc()
 {
-	int i, l, cfi = 0;
-	int *prbs_indices;
+	struct lte_pdsch_dec *dec;
 
-	if (riv->n_vrb >= 110) {
-		LOG_PDSCH_ERR("Invalid RIV number");
-		return -1;
-	}
+	dec = (struct lte_pdsch_dec *) calloc(1, sizeof(struct lte_pdsch_dec));
+	if (!dec)
+		return NULL;
 
-	if (!slot[0]->num) {
-		prbs_indices = riv->prbs0;
-		cfi = slot[0]->cfi;
-	} else {
-		prbs_indices = riv->prbs1;
-	}
+	dec->scram = lte_scram_cache_alloc();
 
-	/* Extract symbols slot 0 */
-	for (l = cfi; l < 7; l++) {
-		for (i = 0; i < riv->n_vrb; i++) {
-			pdsch_extract_rb(slot, rx_antennas, tx_antennas,
-					 l, sf, sym_blk, prbs_indices[i]);
-		}
-	}
+	return dec;
+}
 
-	return 0;
+void lte_pdsch_dec_free(struct lte_pdsch_dec *dec)
+{
+	if (!dec)
+		return;
+
+	pdsch_dec_reset(dec);
+	lte_scram_cache_free(dec->scram);
+	free(dec);
 }
 
 /* Decode one slot of sample data using specified reference signal map */
 int lte_decode_pdsch(struct lte_subframe **subframe,
-		     int chans,
+		     int chans, struct lte_pdsch_dec *dec,
 		     struct lte_pdsch_blk *tblk,
 		     int cfi, int dci_index,
 		     struct lte_time *ltime)
 {
-	int i, rc, sf = ltime->subframe;
-	int tx_ants = subframe[0]->tx_ants;
-	struct pdsch_slot *slot0[chans];
-	struct pdsch_slot *slot1[chans];
-	struct pdsch_sym_blk *sym_blk;
+	int rc = -1;
+	struct pdsch_rb_map *map;
+	struct pdsch_sym_blk sym_blk;
+	struct lte_pdsch_dec *tmp = NULL;
 
 	struct lte_riv riv = {
 		.offset = 0,
@@ -585,6 +583,11 @@ int lte_decode_pdsch(struct lte_subframe **subframe,
 		return -1;
 	}
 
+	if ((chans < 1) || (chans > 2)) {
+		LOG_PDSCH_ERR("Invalid channels");
+		return -1;
+	}
+
 	rc = lte_decode_riv(subframe[0]->rbs,
 			    &subframe[0]->dci[dci_index], &riv);
 	if (rc < 0) {
@@ -595,33 +598,30 @@ int lte_decode_pdsch(struct lte_subframe **subframe,
 	if (subframe[0]->rbs <= 10)
 		cfi++;
 
-	for (int i = 0; i < chans; i++) {
-		slot0[i] = pdsch_slot_alloc(&subframe[i]->slot[0], 0, cfi);
-		slot1[i] = pdsch_slot_alloc(&subframe[i]->slot[1], 1, 0);
+	if (!dec)
+		dec = tmp = lte_pdsch_dec_alloc();
 
-		if (!slot0[i] || !slot1[i]) {
-			LOG_PDSCH_ERR("PDSCH: Failed to allocate slot");
-			return -1;
-		}
+	map = pdsch_dec_map(dec, subframe[0], ltime->subframe);
+	if (!map) {
+		LOG_PDSCH_ERR("Resource element mapping failed");
+		rc = -1;
+		goto release;
 	}
 
-	sym_blk = pdsch_sym_blk_alloc(tx_ants, riv.n_vrb, cfi);
+	sym_blk.vec = dec->data;
+	sym_blk.w = dec->weights;
+	sym_blk.idx = 0;
+	sym_blk.len = cxvec_len(dec->data);
 
-	pdsch_extract_symbols(slot0, chans, tx_ants, sf, &riv, sym_blk);
-	pdsch_extract_symbols(slot1, chans, tx_ants, sf, &riv, sym_blk);
+	rc = pdsch_extract_symbols(subframe, chans, map, cfi, &riv, &sym_blk);
+	if (rc < 0)
+		goto release;
 
-	rc = pdsch_decode_blk(sym_blk, subframe[0]->cell_id,
+	rc = pdsch_decode_blk(&sym_blk, dec->scram, subframe[0]->cell_id,
 			      &subframe[0]->dci[dci_index],
 			      riv.n_vrb, tblk, ltime);
-	if (rc < 0)
-		goto release;
 release:
-	for (i = 0; i < chans; i++) {
-		pdsch_slot_free(slot0[i]);
-		pdsch_slot_free(slot1[i]);
-	}
-
-	pdsch_sym_blk_free(sym_blk);
+	lte_pdsch_dec_free(tmp);
 
 	return rc;
 }
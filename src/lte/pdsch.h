@@ -3,10 +3,21 @@
 
 struct lte_subframe;
 struct lte_pdsch_blk;
+struct lte_pdsch_dec;
 struct lte_time;
 
+/*
+ * Persistent demapping state reused across subframes. Resource element
+ * maps are kept until cell ID, bandwidth or antenna count change. Not
+ * shared between concurrent lte_decode_pdsch() calls.
+ */
+struct lte_pdsch_dec *lte_pdsch_dec_alloc();
+void lte_pdsch_dec_free(struct lte_pdsch_dec *dec);
+
+/* A NULL demapping state allocates temporary state for the call */
 int lte_decode_pdsch(struct lte_subframe **subframe,
-		     int chans, struct lte_pdsch_blk *blk,
+		     int chans, struct lte_pdsch_dec *dec,
+		     struct lte_pdsch_blk *blk,
 		     int cfi, int dci_index,
 		     struct lte_time *time);
 
@@ -29,6 +29,7 @@
 #include "pdsch_block.h"
 #include "crc.h"
 #include "log.h"
+#include "exec.h"
 
 #define MAX_I		188
 
@@ -85,6 +86,20 @@ static int lte_interlv_k[MAX_I] = {
 #define MAX_E		28800
 #define MAX_G		86400
 
+/*
+ * Per code block decode state. Each segment carries its own turbo decoder
+ * and rate matcher so that segments can be decoded concurrently.
+ */
+struct lte_pdsch_seg {
+	uint8_t c[MAX_K / 8];
+	int8_t d[3][MAX_D];
+	int rc;
+	int iter;
+
+	struct tdecoder *tdec;
+	struct lte_rate_matcher *match;
+};
+
 /* 3GPP TS 36.212 Release 8: 5.3.2 "Downlink shared channel" */
 struct lte_pdsch_blk {
 	uint8_t *a;
@@ -93,12 +108,10 @@ struct lte_pdsch_blk {
 	uint8_t *b;
 	int B;
 
-	uint8_t c[MAX_K / 8];
 	int K[MAX_C];
 	int C;
 	int F;
 
-	int8_t d[3][MAX_D];
 	int D[MAX_C];
 
 	int8_t *e[MAX_C];
@@ -109,24 +122,56 @@ struct lte_pdsch_blk {
 	int8_t *f;
 	int G;
 
-	struct tdecoder *tdec;
-	struct lte_rate_matcher *match;
+	int rv;
+	struct lte_pdsch_seg *seg[MAX_C];
+	const struct lte_exec *exec;
+	int batches;
+
+	int max_iter;
+	int stop;
+	int window;
+	int train;
+	int iters[MAX_C];
+	struct lte_pdsch_iter_stats stats;
 };
 
+static struct lte_pdsch_seg *lte_pdsch_seg_alloc()
+{
+	struct lte_pdsch_seg *seg;
+
+	seg = (struct lte_pdsch_seg *) calloc(1, sizeof(struct lte_pdsch_seg));
+	seg->match = lte_rate_matcher_alloc();
+	seg->tdec = alloc_tdec();
+
+	return seg;
+}
+
+static void lte_pdsch_seg_free(struct lte_pdsch_seg *seg)
+{
+	if (!seg)
+		return;
+
+	free_tdec(seg->tdec);
+	lte_rate_matcher_free(seg->match);
+	free(seg);
+}
+
 /*
  * Allocate transport block processing chain
  *
- * Maintain a single turbo decoder instance throughout the lifecycle of the
- * PDSCH block. Constituent buffers are allocated and released upon
- * initialization and reinitialization.
+ * Segment decoders are created on first use and kept throughout the
+ * lifecycle of the PDSCH block. Transport block and concatenated soft bit
+ * buffers are allocated once at maximum size.
  */
 struct lte_pdsch_blk *lte_pdsch_blk_alloc()
 {
 	struct lte_pdsch_blk *tblk;
 
 	tblk = (struct lte_pdsch_blk *) calloc(1, sizeof(struct lte_pdsch_blk));
-	tblk->match = lte_rate_matcher_alloc();
-	tblk->tdec = alloc_tdec();
+	tblk->b = malloc(MAX_B / 8 * sizeof *tblk->b);
+	tblk->f = malloc(MAX_G * sizeof *tblk->f);
+	tblk->max_iter = LTE_PDSCH_DEF_ITER;
+	tblk->stop = LTE_PDSCH_STOP_CRC;
 
 	return tblk;
 }
@@ -137,8 +182,9 @@ void lte_pdsch_blk_free(struct lte_pdsch_blk *tblk)
 	if (!tblk)
 		return;
 
-	free_tdec(tblk->tdec);
-	lte_rate_matcher_free(tblk->match);
+	for (int r = 0; r < MAX_C; r++)
+		lte_pdsch_seg_free(tblk->seg[r]);
+
 	free(tblk->b);
 	free(tblk->f);
 	free(tblk);
@@ -173,8 +219,6 @@ static int lte_pdsch_blk_init_b(struct lte_pdsch_blk *tblk)
 	if (tblk->B % 8)
 		return -1;
 
-	free(tblk->b);
-	tblk->b = malloc(tblk->B / 8 * sizeof *tblk->b);
 	tblk->a = tblk->b;
 
 	return 0;
@@ -259,8 +303,11 @@ static int lte_pdsch_blk_init_d(struct lte_pdsch_blk *tblk)
 {
 	int r;
 
-	for (r = 0; r < tblk->C; r++)
+	for (r = 0; r < tblk->C; r++) {
 		tblk->D[r] = tblk->K[r] + 4;
+		if (!tblk->seg[r])
+			tblk->seg[r] = lte_pdsch_seg_alloc();
+	}
 
 	return 0;
 }
@@ -277,8 +324,6 @@ static int lte_pdsch_blk_init_f(struct lte_pdsch_blk *tblk, int G)
 	if ((G < 1) || (G > MAX_G))
 		return -1;
 
-	free(tblk->f);
-	tblk->f = malloc(G * sizeof *tblk->f);
 	tblk->G = G;
 
 	return 0;
@@ -363,20 +408,64 @@ int lte_pdsch_blk_init(struct lte_pdsch_blk *tblk,
 	return 0;
 }
 
-/* 3GPP TS 36.212 Release 8: 5.3.2.3 "Channel coding" */
-static int lte_pdsch_blk_chan_decode(struct lte_pdsch_blk *tblk, int r)
+/*
+ * Early termination CRC. Segmented blocks carry CRC24B on each code block
+ * while a single code block is checked with the transport block CRC24A.
+ */
+static int lte_pdsch_blk_stop_crc(void *arg, const uint8_t *c, int K)
 {
-	int iter = 8;
+	struct lte_pdsch_blk *tblk = (struct lte_pdsch_blk *) arg;
+	int bytes = (K - L_CRC) / 8;
 
-	if (r >= tblk->C) {
-		fprintf(stderr, "Block: Invalid segment %i\n", r);
-		return -1;
+	if (tblk->C == 1)
+		return lte_crc24a_chk(c, bytes, &c[bytes], L_CRC / 8) == 1;
+
+	return lte_crc24b_chk(c, bytes, &c[bytes], L_CRC / 8) == 1;
+}
+
+/*
+ * 3GPP TS 36.212 Release 8: 5.3.2.3 "Channel coding"
+ *
+ * Batched turbo decode of segments 'r'. Decoder state comes from the
+ * first segment of the batch.
+ */
+static int lte_pdsch_blk_chan_decode(struct lte_pdsch_blk *tblk,
+				     const int *r, int n)
+{
+	int i, K[MAX_C], iters[MAX_C];
+	uint8_t *c[MAX_C];
+	const int8_t *d0[MAX_C], *d1[MAX_C], *d2[MAX_C];
+	struct tdecoder *tdec = tblk->seg[r[0]]->tdec;
+
+	for (i = 0; i < n; i++) {
+		struct lte_pdsch_seg *seg = tblk->seg[r[i]];
+
+		LOG_PDSCH_ARG("    Turbo decode length K=", tblk->K[r[i]]);
+
+		K[i] = tblk->K[r[i]];
+		c[i] = seg->c;
+		d0[i] = seg->d[0];
+		d1[i] = seg->d[1];
+		d2[i] = seg->d[2];
 	}
 
-	LOG_PDSCH_ARG("    Turbo decode length K=", tblk->K[r]);
+	struct lte_turbo_stop stop = {
+		.crc = tblk->stop & LTE_PDSCH_STOP_CRC ?
+		       lte_pdsch_blk_stop_crc : NULL,
+		.arg = tblk,
+		.stable = tblk->stop & LTE_PDSCH_STOP_STABLE,
+	};
+
+	lte_turbo_set_window(tdec, tblk->window, tblk->train);
+
+	if (lte_turbo_decode_batch(tdec, n, K, tblk->max_iter, c, d0, d1, d2,
+				   tblk->stop ? &stop : NULL, iters) < 0)
+		return -1;
 
-	lte_turbo_decode(tblk->tdec, tblk->K[r], iter, tblk->c,
-			 tblk->d[0], tblk->d[1], tblk->d[2]);
+	for (i = 0; i < n; i++) {
+		tblk->seg[r[i]]->iter = iters[i];
+		LOG_PDSCH_ARG("    Turbo iterations ", iters[i]);
+	}
 
 	return 0;
 }
@@ -389,16 +478,17 @@ static int lte_pdsch_blk_rate_unmatch(struct lte_pdsch_blk *tblk, int r, int rv)
 		return -1;
 	}
 
+	struct lte_pdsch_seg *seg = tblk->seg[r];
 	struct lte_rate_matcher_io io = {
 		.D = tblk->D[r],
 		.E = tblk->E[r],
-		.d = { tblk->d[0], tblk->d[1], tblk->d[2] },
+		.d = { seg->d[0], seg->d[1], seg->d[2] },
 		.e = tblk->e[r],
 	};
 
 	LOG_PDSCH_ARG("    Rate match length D=", io.D);
 
-	if (lte_rate_match_rv(tblk->match, &io, rv)) {
+	if (lte_rate_match_rv(seg->match, &io, rv)) {
 		fprintf(stderr, "Block: Rate matcher failed to initialize\n");
 		return -1;
 	}
@@ -422,9 +512,10 @@ static int lte_pdsch_blk_segment_crc(struct lte_pdsch_blk *tblk, int r)
 	if (tblk->C == 1)
 		return 0;
 
+	uint8_t *c = tblk->seg[r]->c;
 	bytes = (tblk->K[r] - L_CRC) / 8;
 
-	if (lte_crc24b_chk(tblk->c, bytes, &tblk->c[bytes], L_CRC / 8) != 1) {
+	if (lte_crc24b_chk(c, bytes, &c[bytes], L_CRC / 8) != 1) {
 		LOG_PDSCH_ERR("Transport block segment failed CRC");
 		return -1;
 	}
@@ -458,9 +549,11 @@ static int lte_pdsch_blk_combine(struct lte_pdsch_blk *tblk, int r)
 		return -1;
 	}
 
+	uint8_t *c = tblk->seg[r]->c;
+
 	if (tblk->C == 1) {
 		bytes = tblk->K[r] / 8;
-		memcpy(tblk->b, tblk->c, bytes);
+		memcpy(tblk->b, c, bytes);
 		return 0;
 	}
 
@@ -473,7 +566,7 @@ static int lte_pdsch_blk_combine(struct lte_pdsch_blk *tblk, int r)
 	}
 
 	bytes = (tblk->K[r] - L_CRC) / 8;
-	memcpy(&tblk->b[wr], tblk->c, bytes);
+	memcpy(&tblk->b[wr], c, bytes);
 
 	return 0;
 }
@@ -493,33 +586,86 @@ static int log_tblk(struct lte_pdsch_blk *tblk)
 	return 0;
 }
 
+/*
+ * Code block batch processing. Batch 'b' covers a contiguous range of
+ * segments, which keeps equal length segments together for the turbo
+ * decoder. Batches write disjoint regions of the 'b' buffer and may
+ * execute in parallel.
+ */
+static void lte_pdsch_blk_decode_batch(void *arg, int b)
+{
+	struct lte_pdsch_blk *tblk = (struct lte_pdsch_blk *) arg;
+	int i, n = 0, r[MAX_C];
+
+	for (i = b * tblk->C / tblk->batches;
+	     i < (b + 1) * tblk->C / tblk->batches; i++) {
+		LOG_PDSCH_ARG("CRC Segmentation block r=", i);
+		LOG_PDSCH_ARG("    Rate match length E=", tblk->E[i]);
+
+		tblk->seg[i]->rc = -1;
+		if (!lte_pdsch_blk_rate_unmatch(tblk, i, tblk->rv))
+			r[n++] = i;
+	}
+
+	if (!n || lte_pdsch_blk_chan_decode(tblk, r, n))
+		return;
+
+	for (i = 0; i < n; i++) {
+		if (lte_pdsch_blk_segment_crc(tblk, r[i]))
+			continue;
+		if (lte_pdsch_blk_combine(tblk, r[i]))
+			continue;
+
+		tblk->seg[r[i]]->rc = 0;
+	}
+}
+
 /*
  * 3GPP TS 36.212 Release 8: 5.3.2 "Downlink shared channel"
  *
  * Execute block decode processing chain consisting of rate unmatch, turbo
- * decode, segmentation combining, and segment/block CRC checks.
+ * decode, segmentation combining, and segment/block CRC checks. Code
+ * blocks are turbo decoded in batches across SIMD lanes and batches are
+ * dispatched through the attached executor, if any.
  */
 int lte_pdsch_blk_decode(struct lte_pdsch_blk *tblk, int rv)
 {
 	int r;
 
+	tblk->rv = rv;
+	for (r = 0; r < tblk->C; r++)
+		tblk->seg[r]->iter = 0;
+
+	/*
+	 * One batch per set of SIMD lanes when running on the executor, or
+	 * per block with a sliding window since those decode one at a time
+	 */
+	if (tblk->exec) {
+		int lanes = tblk->window ? 1 : lte_turbo_lanes();
+		tblk->batches = (tblk->C + lanes - 1) / lanes;
+	} else {
+		tblk->batches = 1;
+	}
+
+	lte_exec_run(tblk->exec, lte_pdsch_blk_decode_batch,
+		     tblk, tblk->batches);
+
 	for (r = 0; r < tblk->C; r++) {
-		LOG_PDSCH_ARG("CRC Segmentation block r=", r);
-		LOG_PDSCH_ARG("    Rate match length E=", tblk->E[r]);
+		int iter = tblk->seg[r]->iter;
 
-		if (lte_pdsch_blk_rate_unmatch(tblk, r, rv))
-			break;
-		if (lte_pdsch_blk_chan_decode(tblk, r))
-			break;
-		if (lte_pdsch_blk_segment_crc(tblk, r))
-			break;
-		if (lte_pdsch_blk_combine(tblk, r))
-			break;
+		tblk->iters[r] = iter;
+		if (iter > 0) {
+			tblk->stats.blocks++;
+			tblk->stats.iters += iter;
+			tblk->stats.hist[iter]++;
+		}
 	}
 
-	if (r < tblk->C) {
-		LOG_PDSCH_ERR("Block: Failed to decode");
-		return -1;
+	for (r = 0; r < tblk->C; r++) {
+		if (tblk->seg[r]->rc) {
+			LOG_PDSCH_ERR("Block: Failed to decode");
+			return -1;
+		}
 	}
 
 	/* Final block CRC check */
@@ -531,6 +677,49 @@ int lte_pdsch_blk_decode(struct lte_pdsch_blk *tblk, int rv)
 	return 0;
 }
 
+void lte_pdsch_blk_set_exec(struct lte_pdsch_blk *tblk,
+			    const struct lte_exec *exec)
+{
+	tblk->exec = exec;
+}
+
+int lte_pdsch_blk_set_iter(struct lte_pdsch_blk *tblk, int max_iter, int stop)
+{
+	if ((max_iter < 1) || (max_iter > LTE_PDSCH_MAX_ITER))
+		return -1;
+
+	tblk->max_iter = max_iter;
+	tblk->stop = stop;
+
+	return 0;
+}
+
+int lte_pdsch_blk_set_window(struct lte_pdsch_blk *tblk,
+			     int window, int train)
+{
+	if (lte_turbo_check_window(window, train))
+		return -1;
+
+	tblk->window = window;
+	tblk->train = train;
+
+	return 0;
+}
+
+int lte_pdsch_blk_iters(struct lte_pdsch_blk *tblk, const int **iters)
+{
+	if (iters)
+		*iters = tblk->iters;
+
+	return tblk->C;
+}
+
+const struct lte_pdsch_iter_stats *
+lte_pdsch_blk_stats(struct lte_pdsch_blk *tblk)
+{
+	return &tblk->stats;
+}
+
 /*
  * 3GPP TS 36.212 Release 8: 5.3.2.5 "Code block concatentation"
  * Return concatenated 'f' buffer of length 'G'
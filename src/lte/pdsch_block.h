@@ -4,6 +4,23 @@
 #include <stdint.h>
 
 struct lte_pdsch_blk;
+struct lte_exec;
+
+/* Turbo decoder iteration limits */
+#define LTE_PDSCH_DEF_ITER	8
+#define LTE_PDSCH_MAX_ITER	16
+
+/* Early termination criteria, may be combined */
+#define LTE_PDSCH_STOP_NONE	0
+#define LTE_PDSCH_STOP_CRC	1
+#define LTE_PDSCH_STOP_STABLE	2
+
+/* Cumulative code block turbo iteration counts */
+struct lte_pdsch_iter_stats {
+	unsigned long blocks;
+	unsigned long iters;
+	unsigned long hist[LTE_PDSCH_MAX_ITER + 1];
+};
 
 /*
  * Allocate and initialize PDSCH transport block object
@@ -17,6 +34,28 @@ int lte_pdsch_blk_init(struct lte_pdsch_blk *tblk,
 		       int A, int G, int N_l, int Q_m);
 void lte_pdsch_blk_free(struct lte_pdsch_blk *tblk);
 
+/* Run code block decodes on executor (NULL for serial decoding) */
+void lte_pdsch_blk_set_exec(struct lte_pdsch_blk *tblk,
+			    const struct lte_exec *exec);
+
+/*
+ * Maximum turbo iterations and early termination criteria. Defaults are
+ * LTE_PDSCH_DEF_ITER iterations with CRC termination.
+ */
+int lte_pdsch_blk_set_iter(struct lte_pdsch_blk *tblk, int max_iter, int stop);
+
+/*
+ * Sliding window turbo decoding with 'train' step window edge estimation,
+ * zero window for full block decoding (default)
+ */
+int lte_pdsch_blk_set_window(struct lte_pdsch_blk *tblk,
+			     int window, int train);
+
+/* Iterations of each code block in the last decode, returns block count */
+int lte_pdsch_blk_iters(struct lte_pdsch_blk *tblk, const int **iters);
+const struct lte_pdsch_iter_stats *
+lte_pdsch_blk_stats(struct lte_pdsch_blk *tblk);
+
 /* Decode 'f' block of soft bits into 'a' block of bits */
 int lte_pdsch_blk_decode(struct lte_pdsch_blk *tblk, int rv);
 
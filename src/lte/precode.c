@@ -21,83 +21,142 @@
 #include <stdio.h>
 #include <complex.h>
 
+#include "slot.h"
 #include "subframe.h"
 #include "precode.h"
 #include "sigproc.h"
 #include "ofdm.h"
+#include "chan_vec.h"
 #include "log.h"
 #include "sigvec_internal.h"
 
-int lte_unprecode(struct lte_sym *sym0, struct lte_sym *sym1,
-		  int tx_ants, int rx_ants, int rb, int k0, int k1,
-		  struct cxvec *data, int index)
+/*
+ * Subcarrier values of one resource block gathered in output order for
+ * each receive channel, with channels of both transmit antennas and the
+ * combined squared channel magnitude
+ */
+struct precode_rb {
+	float complex y[2][LTE_RB_LEN];
+	float complex h[2][2][LTE_RB_LEN];
+	float complex m[2][LTE_RB_LEN];
+};
+
+static void precode_gather(struct precode_rb *g,
+			   struct lte_sym *sym0, struct lte_sym *sym1,
+			   int tx_ants, int rx_ants, int rb,
+			   int (*sc)[2], int num)
 {
-	if ((rx_ants < 1) || (rx_ants > 2))  {
-		LOG_DSP_ERR("Invalid Rx antenna combination");
-		return -1;
-	}
+	int i, j, n, k, p, r;
+	struct lte_sym *sym[2] = { sym0, sym1 };
+	struct lte_ref *ref;
 
-	switch (tx_ants) {
-	case 1:
-		if (rx_ants == 1)
-			return lte_unprecode_1x1(sym0, rb,
-						 k0, k1, data, index);
-		else
-			return lte_unprecode_1x2(sym0, sym1, rb,
-						 k0, k1, data, index);
-		break;
-	case 2:
-		if (rx_ants == 1)
-			return lte_unprecode_2x1(sym0, rb,
-						 k0, k1, data, index);
-		else
-			return lte_unprecode_2x2(sym0, sym1, rb,
-						 k0, k1, data, index);
-		break;
-	default:
-		break;
-	}
+	for (r = 0; r < rx_ants; r++) {
+		ref = sym[r]->ref;
 
-	printf("Antennas %i\n", tx_ants);
-	LOG_DSP_ERR("Invalid Tx antenna combination");
-	return -1;
+		for (i = 0; i < num; i++) {
+			for (j = 0; j < 2; j++) {
+				n = 2 * i + j;
+				k = sc[i][j];
+
+				g->y[r][n] = sym[r]->rb[rb]->data[k];
+				g->m[r][n] = ref->rb[2][rb]->data[k];
+
+				for (p = 0; p < tx_ants; p++)
+					g->h[r][p][n] = ref->rb[p][rb]->data[k];
+			}
+		}
+	}
 }
 
 /*
- * 1 Tx - 1 Rx
+ * Unprecode subcarrier pairs of one resource block
+ *
+ * Single antenna transmission is zero-forcing equalized with maximum ratio
+ * combining of receive channels. Transmit diversity is Alamouti combined
+ * over each pair. With 'w' set, the squared channel magnitude of each
+ * output symbol is also stored, which is the inverse of the noise scaling
+ * applied by equalization. Transmit diversity combines both subcarriers of
+ * the pair into each symbol, so the pair shares the mean.
  */
-int lte_unprecode_1x1(struct lte_sym *sym0,
-		      int rb, int k0, int k1,
-		      struct cxvec *data, int idx)
+int lte_unprecode_rb(struct lte_sym *sym0, struct lte_sym *sym1,
+		     int tx_ants, int rx_ants, int rb,
+		     int (*sc)[2], int num,
+		     struct cxvec *data, float *w, int idx)
 {
-	float scale[2];
-	complex float a, b, c, d;
+	int i, two = rx_ants == 2;
+	float a, b;
+	struct precode_rb g;
 
-	struct lte_ref *ref = sym0->ref;
+	if ((rx_ants < 1) || (rx_ants > 2))  {
+		LOG_DSP_ERR("Invalid Rx antenna combination");
+		return -1;
+	}
+
+	if ((tx_ants < 1) || (tx_ants > 2)) {
+		LOG_DSP_ERR("Invalid Tx antenna combination");
+		return -1;
+	}
 
-	if (idx + 1 >= data->len) {
+	if ((num < 0) || (num > LTE_RB_LEN / 2) ||
+	    (idx + 2 * num > data->len)) {
 		LOG_DSP_ERR("No room left in precoding output buffer");
 		return -1;
 	}
 
-	/* Channel squared amplitude */
-	a = ref->rb[2][rb]->data[k0];
-	b = ref->rb[2][rb]->data[k1];
+	precode_gather(&g, sym0, sym1, tx_ants, rx_ants, rb, sc, num);
 
-	scale[0] = 1.0f / a;
-	scale[1] = 1.0f / b;
+	if (tx_ants == 1) {
+		chan_vec_zf(g.y[0], g.h[0][0], g.m[0],
+			    two ? g.y[1] : NULL, g.h[1][0], g.m[1],
+			    &data->data[idx], 2 * num);
+	} else {
+		chan_vec_sfbc(g.y[0], g.h[0][0], g.h[0][1], g.m[0],
+			      two ? g.y[1] : NULL, g.h[1][0], g.h[1][1], g.m[1],
+			      &data->data[idx], num);
+	}
+
+	if (!w)
+		return 0;
+
+	for (i = 0; i < num; i++) {
+		a = crealf(g.m[0][2 * i + 0]);
+		b = crealf(g.m[0][2 * i + 1]);
 
-	a = sym0->rb[rb]->data[k0];
-	b = sym0->rb[rb]->data[k1];
-	c = ref->rb[0][rb]->data[k0];
-	d = ref->rb[0][rb]->data[k1];
+		if (two) {
+			a += crealf(g.m[1][2 * i + 0]);
+			b += crealf(g.m[1][2 * i + 1]);
+		}
 
-	data->data[idx + 0] = scale[0] * (a * conjf(c));
-	data->data[idx + 1] = scale[1] * (b * conjf(d));
+		if (tx_ants == 2)
+			a = b = 0.5f * (a + b);
+
+		w[idx + 2 * i + 0] = a;
+		w[idx + 2 * i + 1] = b;
+	}
 
 	return 0;
 }
 
+int lte_unprecode(struct lte_sym *sym0, struct lte_sym *sym1,
+		  int tx_ants, int rx_ants, int rb, int k0, int k1,
+		  struct cxvec *data, int index)
+{
+	int sc[1][2] = { { k0, k1 } };
+
+	return lte_unprecode_rb(sym0, sym1, tx_ants, rx_ants, rb,
+				sc, 1, data, NULL, index);
+}
+
+/*
+ * 1 Tx - 1 Rx
+ */
+int lte_unprecode_1x1(struct lte_sym *sym0,
+		      int rb, int k0, int k1,
+		      struct cxvec *data, int idx)
+{
+	return lte_unprecode(sym0, NULL, 1, 1, rb, k0, k1, data, idx);
+}
+
 /*
  * 1 Tx - 2 Rx
  */
@@ -105,39 +164,7 @@ int lte_unprecode_1x2(struct lte_sym *sym0, struct lte_sym *sym1,
 		      int rb, int k0, int k1,
 		      struct cxvec *data, int idx)
 {
-	float scale[2];
-	complex float a, b, c, d, e, f, g, h;
-
-	struct lte_ref *ref[2] = { sym0->ref, sym1->ref };
-
-	if (idx + 1 >= data->len) {
-		LOG_DSP_ERR("No room left in precoding output buffer");
-		return -1;
-	}
-
-	/* Channel squared amplitude */
-	a = ref[0]->rb[2][rb]->data[k0];
-	b = ref[0]->rb[2][rb]->data[k1];
-	c = ref[1]->rb[2][rb]->data[k0];
-	d = ref[1]->rb[2][rb]->data[k1];
-
-	scale[0] = 1.0f / (a + c);
-	scale[1] = 1.0f / (b + d);
-
-	a = sym0->rb[rb]->data[k0];
-	b = sym0->rb[rb]->data[k1];
-	c = ref[0]->rb[0][rb]->data[k0];
-	d = ref[0]->rb[0][rb]->data[k1];
-
-	e = sym1->rb[rb]->data[k0];
-	f = sym1->rb[rb]->data[k1];
-	g = ref[1]->rb[0][rb]->data[k0];
-	h = ref[1]->rb[0][rb]->data[k1];
-
-	data->data[idx + 0] = scale[0] * (a * conjf(c) + e * conjf(g));
-	data->data[idx + 1] = scale[1] * (b * conjf(d) + f * conjf(h));
-
-	return 0;
+	return lte_unprecode(sym0, sym1, 1, 2, rb, k0, k1, data, idx);
 }
 
 /*
@@ -146,37 +173,7 @@ int lte_unprecode_1x2(struct lte_sym *sym0, struct lte_sym *sym1,
 int lte_unprecode_2x1(struct lte_sym *sym,
 		      int rb, int k0, int k1, struct cxvec *data, int idx)
 {
-	float scale[2];
-	complex float a, b, c, d, e, f;
-
-	struct lte_ref *ref = sym->ref;
-
-	if (idx + 1 >= data->len) {
-		LOG_DSP_ERR("No room left in precoding output buffer");
-		return -1;
-	}
-
-	/* Channel squared amplitude */
-	a = ref->rb[2][rb]->data[k0];
-	b = ref->rb[2][rb]->data[k1];
-
-	scale[0] = 1.0f / a;
-	scale[1] = 1.0f / b;
-
-	/* Rx antenna 1 symbols */
-	a = sym->rb[rb]->data[k0];
-	b = sym->rb[rb]->data[k1];
-
-	/* Rx antenna 1 channel */
-	c = ref->rb[0][rb]->data[k0];
-	d = ref->rb[1][rb]->data[k1];
-	e = ref->rb[1][rb]->data[k0];
-	f = ref->rb[0][rb]->data[k1];
-
-	data->data[idx + 0] = scale[0] * a * conjf(c) + scale[1] * conjf(b) * d;
-	data->data[idx + 1] = scale[1] * b * conjf(f) + scale[0] * -conjf(a) * e;
-
-	return 0;
+	return lte_unprecode(sym, NULL, 2, 1, rb, k0, k1, data, idx);
 }
 
 /*
@@ -185,48 +182,5 @@ int lte_unprecode_2x1(struct lte_sym *sym,
 int lte_unprecode_2x2(struct lte_sym *sym0, struct lte_sym *sym1,
 		      int rb, int k0, int k1, struct cxvec *data, int idx)
 {
-	float scale[2];
-	complex float a, b, c, d, e, f, g, h, i, j, k, l;
-
-	struct lte_ref *ref[2] = { sym0->ref, sym1->ref };
-
-	if (idx + 1 >= data->len) {
-		LOG_DSP_ERR("No room left in precoding output buffer");
-		return -1;
-	}
-
-	/* Channel squared amplitude */
-	a = ref[0]->rb[2][rb]->data[k0];
-	b = ref[0]->rb[2][rb]->data[k1];
-	c = ref[1]->rb[2][rb]->data[k0];
-	d = ref[1]->rb[2][rb]->data[k1];
-
-	scale[0] = 1.0f / (a + c);
-	scale[1] = 1.0f / (b + d);
-
-	/* Rx antenna 1 symbols */
-	a = sym0->rb[rb]->data[k0];
-	b = sym0->rb[rb]->data[k1];
-
-	/* Rx antenna 1 channel */
-	c = ref[0]->rb[0][rb]->data[k0];
-	d = ref[0]->rb[1][rb]->data[k1];
-	e = ref[0]->rb[1][rb]->data[k0];
-	f = ref[0]->rb[0][rb]->data[k1];
-
-	/* Rx antenna 2 symbols */
-	g = sym1->rb[rb]->data[k0];
-	h = sym1->rb[rb]->data[k1];
-
-	/* Rx antenna 2 channel */
-	i = ref[1]->rb[0][rb]->data[k0];
-	j = ref[1]->rb[1][rb]->data[k1];
-	k = ref[1]->rb[1][rb]->data[k0];
-	l = ref[1]->rb[0][rb]->data[k1];
-
-	data->data[idx + 0] = scale[0] * (a * conjf(c) + g * conjf(i)) +
-			      scale[1] * (conjf(b) * d + conjf(h) * j);
-	data->data[idx + 1] = scale[1] * (b * conjf(f) + h * conjf(l)) +
-			      scale[0] * (-conjf(a) * e + -conjf(g) * k);
-	return 0;
+	return lte_unprecode(sym0, sym1, 2, 2, rb, k0, k1, data, idx);
 }
@@ -8,6 +8,11 @@ int lte_unprecode(struct lte_sym *sym0, struct lte_sym *sym1,
 		  int tx_ants, int rx_ants, int rb, int k0, int k1,
 		  struct cxvec *data, int index);
 
+int lte_unprecode_rb(struct lte_sym *sym0, struct lte_sym *sym1,
+		     int tx_ants, int rx_ants, int rb,
+		     int (*sc)[2], int num,
+		     struct cxvec *data, float *w, int idx);
+
 int lte_unprecode_1x1(struct lte_sym *sym,
 		      int rb, int k0, int k1,
 		      struct cxvec *data, int idx);
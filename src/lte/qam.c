@@ -22,13 +22,20 @@
 #include <stdint.h>
 #include <complex.h>
 #include <string.h>
+#include <math.h>
+
+#if defined(HAVE_SSE4_1) || defined(HAVE_AVX2)
+#include <immintrin.h>
+#endif
 
 #include "sigproc.h"
+#include "qam.h"
 #include "sigvec_internal.h"
 #include "log.h"
 
 #define QAM16DIV	3.16227766017
 #define QAM64DIV	6.48074069841
+#define QAM256DIV	13.0384048104
 #define SCALE8		16.0
 
 /* QPSK hard output */
@@ -66,122 +73,347 @@ int lte_qpsk_decode(struct cxvec *vec, signed char *bits, int len)
 	return 0;
 }
 
-/* QPSK soft output */
-int lte_qpsk_decode2(struct cxvec *vec, signed char *bits, int len)
+/*
+ * Soft demapping
+ *
+ * With amplitudes normalized to the constellation grid, the soft value of
+ * bit pair 'k' of a 2^(2L) point constellation follows from the previous
+ * pair by v(k) = 2^(L-k) - |v(k-1)|, separately for the real and imaginary
+ * parts. Values are weighted, truncated and saturated to +/-127 before
+ * descrambling, so descrambled soft bits never overflow.
+ *
+ * Scrambling sequences are given either as one byte per bit in 'c' or as
+ * packed words in 'mask' with the soft bits of a call starting at bit 'k'.
+ */
+static inline signed char qam_soft(float v, float g)
 {
-	int i;
+	float s = v * g;
 
-	if (len % 2) {
-		LOG_DSP_ARG("Invalid QPSK length ", len);
-		return -1;
+	if (s >= 127.0f)
+		return 127;
+	if (!(s > -127.0f))
+		return -127;
+
+	return (signed char) s;
+}
+
+static inline int qam_scram_bit(const signed char *c,
+				const uint32_t *mask, int k, int i)
+{
+	if (c)
+		return c[i];
+
+	return (mask[(k + i) >> 5] >> ((k + i) & 31)) & 0x01;
+}
+
+static inline void qam_demap_sym(const float *x, float g, float div,
+				 const signed char *c, const uint32_t *mask,
+				 int k0, signed char *bits, int levels)
+{
+	int k;
+	float re = x[0] * div;
+	float im = x[1] * div;
+
+	for (k = 0; k < levels; k++) {
+		if (k) {
+			re = (float) (1 << (levels - k)) - fabsf(re);
+			im = (float) (1 << (levels - k)) - fabsf(im);
+		}
+
+		bits[2 * k + 0] = qam_soft(re, g);
+		bits[2 * k + 1] = qam_soft(im, g);
 	}
 
-	for (i = 0; i < len / 2; i++) {
-		bits[2 * i + 0] = (signed char) (crealf(vec->data[i]) * SCALE8);
-		bits[2 * i + 1] = (signed char) (cimagf(vec->data[i]) * SCALE8);
+	if (!c && !mask)
+		return;
+
+	for (k = 0; k < 2 * levels; k++) {
+		if (!qam_scram_bit(c, mask, k0, k))
+			bits[k] = -bits[k];
 	}
+}
 
-	return 0;
+#if defined(HAVE_SSE4_1) || defined(HAVE_AVX2)
+#define QAM_BLK_SYMS		8
+
+/*
+ * Byte shuffles interleaving the 16-bit real and imaginary soft bit pairs
+ * of three levels (64QAM) into three output vectors
+ */
+static const int8_t qam_ilv3[3][3][16] __attribute__((aligned(16))) = {
+	{
+		{ 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5, -1, -1 },
+		{ -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5 },
+		{ -1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1 },
+	}, {
+		{ -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, 10, 11 },
+		{ -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1 },
+		{ 4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1 },
+	}, {
+		{ -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1, -1, -1 },
+		{ 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1 },
+		{ -1, -1, 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15 },
+	},
+};
+
+#ifdef HAVE_AVX2
+#define QAM_VECS		2
+
+typedef __m256 qvec;
+
+#define Q_LOAD(P)		_mm256_loadu_ps(P)
+#define Q_SET1(V)		_mm256_set1_ps(V)
+#define Q_MUL(A,B)		_mm256_mul_ps(A, B)
+#define Q_SUB(A,B)		_mm256_sub_ps(A, B)
+#define Q_ABS(A)		_mm256_andnot_ps(_mm256_set1_ps(-0.0f), A)
+
+/* Symbol weights repeated for real and imaginary parts */
+static inline void qam_weights(const float *w, qvec *g)
+{
+	const __m256i idx = _mm256_set_epi32(3, 3, 2, 2, 1, 1, 0, 0);
+	const __m256 scale = _mm256_set1_ps(SCALE8);
+
+	g[0] = _mm256_castps128_ps256(_mm_loadu_ps(&w[0]));
+	g[1] = _mm256_castps128_ps256(_mm_loadu_ps(&w[4]));
+	g[0] = _mm256_mul_ps(_mm256_permutevar8x32_ps(g[0], idx), scale);
+	g[1] = _mm256_mul_ps(_mm256_permutevar8x32_ps(g[1], idx), scale);
 }
 
-/* 16QAM soft output */
-int lte_qam16_decode(struct cxvec *vec, signed char *bits, int len)
+/* Truncate and saturate 16 values to 8 bits in order */
+static inline __m128i qam_pack(const qvec *v)
 {
-	int i;
-	float a, b, c, d;
+	__m256i a = _mm256_packs_epi32(_mm256_cvttps_epi32(v[0]),
+				       _mm256_cvttps_epi32(v[1]));
 
-	if (len % 4) {
-		LOG_DSP_ARG("Invalid 16QAM length ", len);
-		return -1;
+	a = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0));
+
+	return _mm_max_epi8(_mm_packs_epi16(_mm256_castsi256_si128(a),
+					    _mm256_extracti128_si256(a, 1)),
+			    _mm_set1_epi8(-127));
+}
+#else
+#define QAM_VECS		4
+
+typedef __m128 qvec;
+
+#define Q_LOAD(P)		_mm_loadu_ps(P)
+#define Q_SET1(V)		_mm_set1_ps(V)
+#define Q_MUL(A,B)		_mm_mul_ps(A, B)
+#define Q_SUB(A,B)		_mm_sub_ps(A, B)
+#define Q_ABS(A)		_mm_andnot_ps(_mm_set1_ps(-0.0f), A)
+
+static inline void qam_weights(const float *w, qvec *g)
+{
+	const __m128 scale = _mm_set1_ps(SCALE8);
+	__m128 w0 = _mm_loadu_ps(&w[0]);
+	__m128 w1 = _mm_loadu_ps(&w[4]);
+
+	g[0] = _mm_mul_ps(_mm_unpacklo_ps(w0, w0), scale);
+	g[1] = _mm_mul_ps(_mm_unpackhi_ps(w0, w0), scale);
+	g[2] = _mm_mul_ps(_mm_unpacklo_ps(w1, w1), scale);
+	g[3] = _mm_mul_ps(_mm_unpackhi_ps(w1, w1), scale);
+}
+
+static inline __m128i qam_pack(const qvec *v)
+{
+	__m128i lo = _mm_packs_epi32(_mm_cvttps_epi32(v[0]),
+				     _mm_cvttps_epi32(v[1]));
+	__m128i hi = _mm_packs_epi32(_mm_cvttps_epi32(v[2]),
+				     _mm_cvttps_epi32(v[3]));
+
+	return _mm_max_epi8(_mm_packs_epi16(lo, hi), _mm_set1_epi8(-127));
+}
+#endif
+
+/* Negation mask of 16 soft bits from scrambling bytes or packed bits */
+static inline __m128i qam_scram_neg(const signed char *c,
+				    const uint32_t *mask, int k)
+{
+	const __m128i spread = _mm_set_epi8(1, 1, 1, 1, 1, 1, 1, 1,
+					    0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i sel = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1,
+					 -128, 64, 32, 16, 8, 4, 2, 1);
+	__m128i v;
+
+	if (c) {
+		v = _mm_loadu_si128((const __m128i *) c);
+	} else {
+		v = _mm_cvtsi32_si128((mask[k >> 5] >> (k & 31)) & 0xffff);
+		v = _mm_and_si128(_mm_shuffle_epi8(v, spread), sel);
 	}
 
-	for (i = 0; i < len / 4; i++) {
-		/* Bits 0 and 1 */
-		a = crealf(vec->data[i]) * QAM16DIV;
-		b = cimagf(vec->data[i]) * QAM16DIV;
-
-		/* Bits 2 and 3 */
-		if (a < 0.0f)
-			c = a + 2.0f;
-		else
-			c = -a + 2.0f;
-
-		if (b < 0.0f)
-			d = b + 2.0f;
-		else
-			d = -b + 2.0f;
-
-		/* Scale soft bits */
-		bits[4 * i + 0] = (int8_t) (a * SCALE8);
-		bits[4 * i + 1] = (int8_t) (b * SCALE8);
-		bits[4 * i + 2] = (int8_t) (c * SCALE8);
-		bits[4 * i + 3] = (int8_t) (d * SCALE8);
+	return _mm_cmpeq_epi8(v, _mm_setzero_si128());
+}
+
+/*
+ * Demap 8 symbols
+ *
+ * Each level is packed into one vector of 16-bit real and imaginary soft
+ * bit pairs, which are then interleaved into symbol order. Descrambling
+ * negates soft bits with a zero scrambling bit.
+ */
+static inline __attribute__((always_inline))
+void qam_demap_blk(const float *x, const float *w, float div,
+		   const signed char *c, const uint32_t *mask, int k0,
+		   signed char *bits, const int levels)
+{
+	int i, k;
+	qvec v[QAM_VECS], u[QAM_VECS], g[QAM_VECS];
+	__m128i lv[4], out[4], a, b, s;
+
+	if (w) {
+		qam_weights(w, g);
+	} else {
+		for (i = 0; i < QAM_VECS; i++)
+			g[i] = Q_SET1(SCALE8);
 	}
 
-	return 0;
+	for (i = 0; i < QAM_VECS; i++)
+		v[i] = Q_MUL(Q_LOAD(&x[16 / QAM_VECS * i]), Q_SET1(div));
+
+	for (k = 0; k < levels; k++) {
+		for (i = 0; i < QAM_VECS; i++) {
+			if (k) {
+				v[i] = Q_SUB(Q_SET1((float) (1 << (levels - k))),
+					     Q_ABS(v[i]));
+			}
+			u[i] = Q_MUL(v[i], g[i]);
+		}
+
+		lv[k] = qam_pack(u);
+	}
+
+	switch (levels) {
+	case 1:
+		out[0] = lv[0];
+		break;
+	case 2:
+		out[0] = _mm_unpacklo_epi16(lv[0], lv[1]);
+		out[1] = _mm_unpackhi_epi16(lv[0], lv[1]);
+		break;
+	case 3:
+		for (i = 0; i < 3; i++) {
+			a = _mm_shuffle_epi8(lv[0],
+				_mm_load_si128((const __m128i *) qam_ilv3[i][0]));
+			b = _mm_shuffle_epi8(lv[1],
+				_mm_load_si128((const __m128i *) qam_ilv3[i][1]));
+			s = _mm_shuffle_epi8(lv[2],
+				_mm_load_si128((const __m128i *) qam_ilv3[i][2]));
+			out[i] = _mm_or_si128(_mm_or_si128(a, b), s);
+		}
+		break;
+	case 4:
+		a = _mm_unpacklo_epi16(lv[0], lv[1]);
+		b = _mm_unpacklo_epi16(lv[2], lv[3]);
+		out[0] = _mm_unpacklo_epi32(a, b);
+		out[1] = _mm_unpackhi_epi32(a, b);
+		a = _mm_unpackhi_epi16(lv[0], lv[1]);
+		b = _mm_unpackhi_epi16(lv[2], lv[3]);
+		out[2] = _mm_unpacklo_epi32(a, b);
+		out[3] = _mm_unpackhi_epi32(a, b);
+		break;
+	}
+
+	for (i = 0; i < levels; i++) {
+		if (c || mask) {
+			s = qam_scram_neg(c ? &c[16 * i] : NULL,
+					  mask, k0 + 16 * i);
+			out[i] = _mm_sub_epi8(_mm_xor_si128(out[i], s), s);
+		}
+
+		_mm_storeu_si128((__m128i *) &bits[16 * i], out[i]);
+	}
 }
+#endif
 
-/* 64QAM soft output */
-int lte_qam64_decode(struct cxvec *vec, signed char *bits, int len)
+static inline __attribute__((always_inline))
+void qam_demap(const float *x, const float *w, float div,
+	       const signed char *c, const uint32_t *mask,
+	       signed char *bits, int n, const int levels)
 {
-	int i;
-	float a, b, c, d, e, f;
+	int i = 0, m = 2 * levels;
+
+#ifdef QAM_BLK_SYMS
+	for (; i + QAM_BLK_SYMS <= n; i += QAM_BLK_SYMS) {
+		qam_demap_blk(&x[2 * i], w ? &w[i] : NULL, div,
+			      c ? &c[m * i] : NULL, mask, m * i,
+			      &bits[m * i], levels);
+	}
+#endif
+	for (; i < n; i++) {
+		qam_demap_sym(&x[2 * i], w ? w[i] * SCALE8 : SCALE8, div,
+			      c ? &c[m * i] : NULL, mask, m * i,
+			      &bits[m * i], levels);
+	}
+}
 
-	if (len % 6) {
-		LOG_DSP_ARG("Invalid 64QAM length ", len);
+static int qam_demap_run(struct cxvec *vec, const float *w,
+			 const signed char *c, const uint32_t *mask,
+			 signed char *bits, int len, int mod)
+{
+	const float *x = (const float *) vec->data;
+
+	if ((mod < 2) || (mod > 8) || (mod % 2)) {
+		LOG_DSP_ARG("Invalid modulation order ", mod);
+		return -1;
+	}
+
+	if ((len % mod) || (len / mod > vec->len)) {
+		LOG_DSP_ARG("Invalid soft demapper length ", len);
 		return -1;
 	}
 
-	for (i = 0; i < len / 6; i++) {
-		/* Bits 0 and 1 */
-		a = crealf(vec->data[i]) * QAM64DIV;
-		b = cimagf(vec->data[i]) * QAM64DIV;
-
-		/* Bits 2 and 3 */
-		if (a > 0.0f)
-			c = -a + 4.0f;
-		else
-			c = a + 4.0f;
-
-		if (b > 0.0f)
-			d = -b + 4.0f;
-		else
-			d = b + 4.0f;
-
-		/* Bits 4 and 5 */
-		if (a > 4.0f)
-			e = -a + 6.0f;
-		else if (a < -4.0f)
-			e = a + 6.0f;
-		else if (a > 0.0f)
-			e = a - 2.0f;
-		else
-			e = -a - 2.0f;
-
-		if (b > 4.0f)
-			f = -b + 6.0f;
-		else if (b < -4.0f)
-			f = b + 6.0f;
-		else if (b > 0.0f)
-			f = b - 2.0f;
-		else
-			f = -b - 2.0f;
-
-		/* Scale soft bits */
-		bits[6 * i + 0] = (int8_t) (a * SCALE8);
-		bits[6 * i + 1] = (int8_t) (b * SCALE8);
-		bits[6 * i + 2] = (int8_t) (c * SCALE8);
-		bits[6 * i + 3] = (int8_t) (d * SCALE8);
-		bits[6 * i + 4] = (int8_t) (e * SCALE8);
-		bits[6 * i + 5] = (int8_t) (f * SCALE8);
+	switch (mod) {
+	case 2:
+		qam_demap(x, w, 1.0f, c, mask, bits, len / mod, 1);
+		break;
+	case 4:
+		qam_demap(x, w, QAM16DIV, c, mask, bits, len / mod, 2);
+		break;
+	case 6:
+		qam_demap(x, w, QAM64DIV, c, mask, bits, len / mod, 3);
+		break;
+	case 8:
+		qam_demap(x, w, QAM256DIV, c, mask, bits, len / mod, 4);
+		break;
 	}
 
 	return 0;
 }
 
+int lte_qam_demap(struct cxvec *vec, const float *w, const signed char *c,
+		  signed char *bits, int len, int mod)
+{
+	return qam_demap_run(vec, w, c, NULL, bits, len, mod);
+}
+
+int lte_qam_demap_mask(struct cxvec *vec, const float *w,
+		       const uint32_t *mask, signed char *bits,
+		       int len, int mod)
+{
+	return qam_demap_run(vec, w, NULL, mask, bits, len, mod);
+}
+
+/* QPSK soft output */
+int lte_qpsk_decode2(struct cxvec *vec, signed char *bits, int len)
+{
+	return lte_qam_demap(vec, NULL, NULL, bits, len, 2);
+}
+
+/* 16QAM soft output */
+int lte_qam16_decode(struct cxvec *vec, signed char *bits, int len)
+{
+	return lte_qam_demap(vec, NULL, NULL, bits, len, 4);
+}
+
+/* 64QAM soft output */
+int lte_qam64_decode(struct cxvec *vec, signed char *bits, int len)
+{
+	return lte_qam_demap(vec, NULL, NULL, bits, len, 6);
+}
+
 /* 256QAM soft output */
 int lte_qam256_decode(struct cxvec *vec, signed char *bits, int len)
 {
-	LOG_DSP_ERR("256-QAM not supported");
-	return -1;
+	return lte_qam_demap(vec, NULL, NULL, bits, len, 8);
 }
@@ -1,6 +1,8 @@
 #ifndef _LTE_QAM_
 #define _LTE_QAM_
 
+#include <stdint.h>
+
 struct cxvec;
 
 int lte_qpsk_decode(struct cxvec *vec, signed char *bits, int len);
@@ -10,4 +12,21 @@ int lte_qam16_decode(struct cxvec *vec, signed char *bits, int len);
 int lte_qam64_decode(struct cxvec *vec, signed char *bits, int len);
 int lte_qam256_decode(struct cxvec *vec, signed char *bits, int len);
 
+/*
+ * Soft demapping with descrambling
+ *
+ * Produces 'len' soft bits of modulation order 'mod' (2, 4, 6 or 8) from
+ * 'len / mod' symbols. Soft bits of each symbol are scaled by its weight
+ * in 'w', typically the channel power normalized to unit mean, and
+ * saturated to +/-127. Soft bits are then descrambled with the 0 / 1
+ * sequence 'c' as in lte_scramble2(). Either 'w' or 'c' may be NULL.
+ * The mask variant takes the scrambling sequence packed as generated by
+ * lte_gen_gold_packed().
+ */
+int lte_qam_demap(struct cxvec *vec, const float *w, const signed char *c,
+		  signed char *bits, int len, int mod);
+int lte_qam_demap_mask(struct cxvec *vec, const float *w,
+		       const uint32_t *mask, signed char *bits,
+		       int len, int mod);
+
 #endif /* _LTE_QAM_ */
@@ -0,0 +1,187 @@
+/*
+ * LTE soft demapper benchmark
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <complex.h>
+
+#include "sigvec.h"
+#include "sigvec_internal.h"
+#include "qam.h"
+#include "scramble.h"
+
+/* Data symbols of a fully allocated 20 MHz subframe */
+#define DEF_SYMS	15000
+#define DEF_REPS	1000
+
+/*
+ * Measures symbol throughput for each modulation order with descrambling
+ * as a separate pass, fused into the demapper, and fused with channel
+ * weighting.
+ */
+struct bench_data {
+	int len;
+	struct cxvec *vec;
+	float *w;
+	signed char *c;
+	signed char *bits;
+};
+
+enum bench_mode {
+	BENCH_SEPARATE,
+	BENCH_FUSED,
+	BENCH_WEIGHTED,
+};
+
+static float frand(float a)
+{
+	return a * (2.0f * rand() / RAND_MAX - 1.0f);
+}
+
+static struct bench_data *gen_data(int len)
+{
+	int i;
+	struct bench_data *data;
+
+	data = (struct bench_data *) malloc(sizeof(*data));
+	data->len = len;
+	data->vec = cxvec_alloc_simple(len);
+	data->w = (float *) malloc(len * sizeof(float));
+	data->c = (signed char *) malloc(8 * len);
+	data->bits = (signed char *) malloc(8 * len);
+
+	for (i = 0; i < len; i++) {
+		data->vec->data[i] = frand(1.0f) + I * frand(1.0f);
+		data->w[i] = 1.0f + frand(0.5f);
+	}
+
+	for (i = 0; i < 8 * len; i++)
+		data->c[i] = rand() & 0x01;
+
+	return data;
+}
+
+static void free_data(struct bench_data *data)
+{
+	cxvec_free(data->vec);
+	free(data->w);
+	free(data->c);
+	free(data->bits);
+	free(data);
+}
+
+/* Millions of symbols per second */
+static double run(struct bench_data *data, int mod,
+		  enum bench_mode mode, int reps)
+{
+	int i, len = data->len * mod;
+	struct timespec t0, t1;
+	double secs;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	for (i = 0; i < reps; i++) {
+		switch (mode) {
+		case BENCH_SEPARATE:
+			lte_qam_demap(data->vec, NULL, NULL,
+				      data->bits, len, mod);
+			lte_scramble2(data->bits, data->c, len);
+			break;
+		case BENCH_FUSED:
+			lte_qam_demap(data->vec, NULL, data->c,
+				      data->bits, len, mod);
+			break;
+		case BENCH_WEIGHTED:
+			lte_qam_demap(data->vec, data->w, data->c,
+				      data->bits, len, mod);
+			break;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	secs = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+	return (double) data->len * reps / secs / 1e6;
+}
+
+static void print_help()
+{
+	fprintf(stdout, "\nOptions:\n"
+		"  -h    This text\n"
+		"  -m    Modulation order 2, 4, 6 or 8 (default = all)\n"
+		"  -s    Symbols per demapping (default = %i)\n"
+		"  -n    Demappings per measurement (default = %i)\n\n",
+		DEF_SYMS, DEF_REPS);
+}
+
+int main(int argc, char **argv)
+{
+	int M = 0, syms = DEF_SYMS, reps = DEF_REPS;
+	int option, mod;
+	double separate, fused, weighted;
+	struct bench_data *data;
+
+	while ((option = getopt(argc, argv, "hm:s:n:")) != -1) {
+		switch (option) {
+		case 'm':
+			M = atoi(optarg);
+			break;
+		case 's':
+			syms = atoi(optarg);
+			break;
+		case 'n':
+			reps = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			print_help();
+			return 0;
+		}
+	}
+
+	if ((syms < 1) || (reps < 1)) {
+		print_help();
+		return 1;
+	}
+
+	data = gen_data(syms);
+
+	fprintf(stdout, "%4s %16s %16s %16s\n", "mod",
+		"separate Msym/s", "fused Msym/s", "weighted Msym/s");
+
+	for (mod = 2; mod <= 8; mod += 2) {
+		if (M && (mod != M))
+			continue;
+
+		separate = run(data, mod, BENCH_SEPARATE, reps);
+		fused = run(data, mod, BENCH_FUSED, reps);
+		weighted = run(data, mod, BENCH_WEIGHTED, reps);
+
+		fprintf(stdout, "%4i %16.1f %16.1f %16.1f\n",
+			mod, separate, fused, weighted);
+	}
+
+	free_data(data);
+
+	return 0;
+}
@@ -18,9 +18,31 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
 #include <gold.h>
 #include "scramble.h"
 
+#define SCRAM_CACHE_LEN		16
+
+struct scram_entry {
+	unsigned init;
+	int len;
+	int words;
+	uint32_t *mask;
+	unsigned long used;
+};
+
+/*
+ * Packed scrambling sequences by initialization value. Sequences of equal
+ * initialization share their prefix, so an entry serves all lengths up to
+ * the generated one and is regenerated in place when a longer one is
+ * requested. Least recently used entries are replaced.
+ */
+struct lte_scram_cache {
+	unsigned long clock;
+	struct scram_entry entries[SCRAM_CACHE_LEN];
+};
+
 void lte_pbch_gen_scrambler(unsigned init, signed char *seq, int len)
 {
 	lte_gen_gold_seq(init, seq, len);
@@ -36,6 +58,65 @@ void lte_ul_pusch_gen_scrambler(unsigned init, signed char *c, int len)
 	lte_gen_gold_seq(init, c, len);
 }
 
+struct lte_scram_cache *lte_scram_cache_alloc()
+{
+	return (struct lte_scram_cache *) calloc(1,
+						 sizeof(struct lte_scram_cache));
+}
+
+void lte_scram_cache_free(struct lte_scram_cache *cache)
+{
+	if (!cache)
+		return;
+
+	for (int i = 0; i < SCRAM_CACHE_LEN; i++)
+		free(cache->entries[i].mask);
+
+	free(cache);
+}
+
+const uint32_t *lte_scram_cache_get(struct lte_scram_cache *cache,
+				    unsigned init, int len)
+{
+	int i, words = (len + 31) / 32;
+	struct scram_entry *e = NULL, *lru = &cache->entries[0];
+	uint32_t *mask;
+
+	for (i = 0; i < SCRAM_CACHE_LEN; i++) {
+		if (cache->entries[i].mask && cache->entries[i].init == init) {
+			e = &cache->entries[i];
+			break;
+		}
+		if (cache->entries[i].used < lru->used)
+			lru = &cache->entries[i];
+	}
+
+	if (!e) {
+		e = lru;
+		e->len = 0;
+	}
+
+	e->init = init;
+	e->used = ++cache->clock;
+
+	if (e->len >= len)
+		return e->mask;
+
+	if (e->words < words) {
+		mask = (uint32_t *) realloc(e->mask, words * sizeof(uint32_t));
+		if (!mask)
+			return NULL;
+
+		e->mask = mask;
+		e->words = words;
+	}
+
+	lte_gen_gold_packed(init, e->mask, len);
+	e->len = len;
+
+	return e->mask;
+}
+
 void lte_scramble(signed char *bits, signed char *c, int len)
 {
 	int i;
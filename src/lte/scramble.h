@@ -1,9 +1,19 @@
 #ifndef _LTE_SCRAMBLE_
 #define _LTE_SCRAMBLE_
 
+#include <stdint.h>
+
+struct lte_scram_cache;
+
 void lte_pbch_gen_scrambler(unsigned init, signed char *seq, int len);
 void lte_pdcch_gen_scrambler(unsigned init, signed char *seq, int len);
 
+/* Cached scrambling sequences packed as by lte_gen_gold_packed() */
+struct lte_scram_cache *lte_scram_cache_alloc();
+void lte_scram_cache_free(struct lte_scram_cache *cache);
+const uint32_t *lte_scram_cache_get(struct lte_scram_cache *cache,
+				    unsigned init, int len);
+
 void lte_scramble(signed char *bits, signed char *c, int len);
 void lte_descramble(signed char *bits, signed char *c, int len);
 
@@ -15,7 +15,7 @@ struct lte_ref;
 struct lte_ref_map;
 struct lte_slot;
 struct lte_subframe;
-struct fft_hdl;
+struct lte_ofdm_grp;
 struct interp_hdl;
 struct cxvec;
 
@@ -64,7 +64,10 @@ struct lte_subframe {
 
 	int *reserve;
 
-	struct fft_hdl *fft;
+	/* Receive channel index within the transform group */
+	int chan;
+	int transformed;
+	struct lte_ofdm_grp *grp;
 	struct interp_hdl *interp;
 };
 
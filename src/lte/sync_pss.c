@@ -30,77 +30,271 @@
 #include "sigvec_internal.h"
 #include "expand.h"
 
+#ifdef HAVE_SSE3
+#include <immintrin.h>
+#endif
+
 #define PSS_LEN		64
 #define SIGN(V)		((V < 0.0f) ? 0 : 1)
 
-/* Bitwise 64 element dot product */
-static int16_t pss_bit_dot_prod(uint64_t xr, uint64_t xi,
-				uint64_t hr, uint64_t hi)
+/* Correlation peak of one PSS hypothesis */
+struct pss_peak {
+	int mag;
+	int pos;
+};
+
+/*
+ * Bitwise 64 element dot product. Sign bits stand for +/-1 values, so a
+ * real product sum is 64 less twice the number of differing bits.
+ */
+static int pss_bit_dot_prod(uint64_t xr, uint64_t xi,
+			    uint64_t hr, uint64_t hi)
 {
-	int16_t s0, s1;
-	uint64_t d0, d1, d2, d3, d4, d5, d6, d7;
+	int s0, s1;
 
-	/* Multiply */
-	d0 = ~(xr ^ hr);
-	d1 = ~(xi ^ hi);
-	d2 = ~(xr ^ hi);
-	d3 = ~(xi ^ hr);
+	s0 = __builtin_popcountll(xi ^ hi) - __builtin_popcountll(xr ^ hr);
+	s1 = 64 - __builtin_popcountll(xr ^ hi) - __builtin_popcountll(xi ^ hr);
 
-	/* Positive sum */
-	d4 = d0 & ~d1;
-	d6 = d2 & d3;
+	return s0 * s0 + s1 * s1;
+}
 
-	/* Negative sum */
-	d5 = ~d0 & d1;
-	d7 = ~d2 & ~d3;
+/*
+ * Sliced samples are packed one bit per sample following 64 zero bits,
+ * which stand in for the samples preceding the buffer. The correlation
+ * window of lag 'i' then starts at bit i + 1 and holds the newest sample in
+ * its most significant bit.
+ */
+static inline uint64_t pss_window(const uint64_t *x, int i)
+{
+	int b = i + 1, s = b & 63;
+	uint64_t w = x[b >> 6] >> s;
 
-	/* Accumulate */
-	s0 = __builtin_popcountll(d4) - __builtin_popcountll(d5);
-	s1 = __builtin_popcountll(d6) - __builtin_popcountll(d7);
+	return s ? w | x[(b >> 6) + 1] << (64 - s) : w;
+}
 
-	return s0 * s0 + s1 * s1;
+/* Bitwise 64 element cross correlation of lags 'start' to 'end' */
+static void pss_bit_corr(const uint64_t *xr, const uint64_t *xi,
+			 int start, int end, const uint64_t *hr,
+			 const uint64_t *hi, struct pss_peak *peak)
+{
+	int i, n, v;
+	uint64_t wr, wi;
+
+	for (i = start; i < end; i++) {
+		wr = pss_window(xr, i);
+		wi = pss_window(xi, i);
+
+		for (n = 0; n < LTE_PSS_NUM; n++) {
+			v = pss_bit_dot_prod(wr, wi, hr[n], hi[n]);
+			if (v > peak[n].mag) {
+				peak[n].mag = v;
+				peak[n].pos = i;
+			}
+		}
+	}
 }
 
-/* Bitwise 64 element cross correlation */
-static void pss_bit_corr(uint8_t *in, int16_t *out, int len,
-			uint64_t hr, uint64_t hi)
+/*
+ * Vector correlation evaluates PSS_LANES consecutive lags per step with one
+ * 64-bit window per lane and all three sequences against each window.
+ * Windows of a step share their source words since steps start at bit
+ * offsets that are multiples of the lane count. With the dot product
+ * written as
+ *
+ *   s0 = pop(xi ^ hi) - pop(xr ^ hr) = pop(xi ^ hi) + pop(xr ^ ~hr) - 64
+ *   s1 = 64 - pop(xr ^ hi) - pop(xi ^ hr)
+ *
+ * each term takes a single population count of a pair of values, and the
+ * sign of s1 is dropped by the square. Lanes keep their own running peak
+ * and the first position reaching it.
+ */
+#if defined(HAVE_AVX512VPOPCNTDQ)
+
+#define PSS_LANES		8
+
+typedef __m512i pss_v;
+
+#define P_SET1(X)		_mm512_set1_epi64(X)
+#define P_LANES()		_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7)
+#define P_ADD(A,B)		_mm512_add_epi64(A, B)
+#define P_SUB(A,B)		_mm512_sub_epi64(A, B)
+#define P_XOR(A,B)		_mm512_xor_si512(A, B)
+#define P_OR(A,B)		_mm512_or_si512(A, B)
+#define P_SRLV(A,B)		_mm512_srlv_epi64(A, B)
+#define P_SLLV(A,B)		_mm512_sllv_epi64(A, B)
+#define P_MUL(A,B)		_mm512_mul_epi32(A, B)
+#define P_STORE(P,V)		_mm512_storeu_si512((void *) (P), V)
+#define P_POP2(A,B)		P_ADD(_mm512_popcnt_epi64(A), \
+				      _mm512_popcnt_epi64(B))
+#define P_PEAK(M,P,V,I) { \
+	__mmask8 k = _mm512_cmpgt_epi64_mask(V, M); \
+	M = _mm512_mask_mov_epi64(M, k, V); \
+	P = _mm512_mask_mov_epi64(P, k, I); \
+}
+#elif defined(HAVE_AVX2)
+
+#define PSS_LANES		4
+
+typedef __m256i pss_v;
+
+#define P_SET1(X)		_mm256_set1_epi64x(X)
+#define P_LANES()		_mm256_setr_epi64x(0, 1, 2, 3)
+#define P_ADD(A,B)		_mm256_add_epi64(A, B)
+#define P_SUB(A,B)		_mm256_sub_epi64(A, B)
+#define P_XOR(A,B)		_mm256_xor_si256(A, B)
+#define P_OR(A,B)		_mm256_or_si256(A, B)
+#define P_SRLV(A,B)		_mm256_srlv_epi64(A, B)
+#define P_SLLV(A,B)		_mm256_sllv_epi64(A, B)
+#define P_MUL(A,B)		_mm256_mul_epi32(A, B)
+#define P_STORE(P,V)		_mm256_storeu_si256((__m256i *) (P), V)
+#define P_POP2(A,B)		_mm256_sad_epu8(_mm256_add_epi8(pss_pop8(A), \
+					pss_pop8(B)), _mm256_setzero_si256())
+#define P_PEAK(M,P,V,I) { \
+	__m256i k = _mm256_cmpgt_epi64(V, M); \
+	M = _mm256_blendv_epi8(M, V, k); \
+	P = _mm256_blendv_epi8(P, I, k); \
+}
+
+/* Per byte population count with a nibble lookup */
+static inline __m256i pss_pop8(__m256i v)
+{
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+					     1, 2, 2, 3, 2, 3, 3, 4,
+					     0, 1, 1, 2, 1, 2, 2, 3,
+					     1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i m = _mm256_set1_epi8(0x0f);
+
+	return _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, m)),
+			       _mm256_shuffle_epi8(lut,
+				_mm256_and_si256(_mm256_srli_epi16(v, 4), m)));
+}
+#endif
+
+#ifdef PSS_LANES
+static void pss_vec_corr(const uint64_t *xr, const uint64_t *xi,
+			 int start, int end, const uint64_t *hr,
+			 const uint64_t *hi, struct pss_peak *peak)
 {
-	uint64_t xr = 0, xi = 0;
+	int i, k, n, b;
+	int64_t m[PSS_LANES], p[PSS_LANES];
+	pss_v wr, wi, v, s0, s1, sr, sl, pos;
+	pss_v vhr[LTE_PSS_NUM], vnr[LTE_PSS_NUM], vhi[LTE_PSS_NUM];
+	pss_v mag[LTE_PSS_NUM], at[LTE_PSS_NUM];
+	const pss_v c64 = P_SET1(64);
+
+	for (n = 0; n < LTE_PSS_NUM; n++) {
+		vhr[n] = P_SET1(hr[n]);
+		vnr[n] = P_SET1(~hr[n]);
+		vhi[n] = P_SET1(hi[n]);
+		mag[n] = at[n] = P_SET1(0);
+	}
+
+	pos = P_ADD(P_SET1(start), P_LANES());
 
-	for (int i = 0; i < len; i++) {
-		xr = (xr >> 1) | ((uint64_t) in[2 * i + 0] << 63);
-		xi = (xi >> 1) | ((uint64_t) in[2 * i + 1] << 63);
+	for (i = start; i < end; i += PSS_LANES) {
+		b = i + 1;
+		sr = P_ADD(P_SET1(b & 63), P_LANES());
+		sl = P_SUB(c64, sr);
 
-		out[i] = pss_bit_dot_prod(xr, xi, hr, hi);
+		wr = P_OR(P_SRLV(P_SET1(xr[b >> 6]), sr),
+			  P_SLLV(P_SET1(xr[(b >> 6) + 1]), sl));
+		wi = P_OR(P_SRLV(P_SET1(xi[b >> 6]), sr),
+			  P_SLLV(P_SET1(xi[(b >> 6) + 1]), sl));
+
+		for (n = 0; n < LTE_PSS_NUM; n++) {
+			s0 = P_SUB(P_POP2(P_XOR(wi, vhi[n]),
+					  P_XOR(wr, vnr[n])), c64);
+			s1 = P_SUB(P_POP2(P_XOR(wr, vhi[n]),
+					  P_XOR(wi, vhr[n])), c64);
+			v = P_ADD(P_MUL(s0, s0), P_MUL(s1, s1));
+
+			P_PEAK(mag[n], at[n], v, pos);
+		}
+
+		pos = P_ADD(pos, P_SET1(PSS_LANES));
+	}
+
+	for (n = 0; n < LTE_PSS_NUM; n++) {
+		P_STORE(m, mag[n]);
+		P_STORE(p, at[n]);
+
+		for (k = 0; k < PSS_LANES; k++) {
+			if ((m[k] > peak[n].mag) ||
+			    ((m[k] == peak[n].mag) && (m[k] > 0) &&
+			     (p[k] < peak[n].pos))) {
+				peak[n].mag = m[k];
+				peak[n].pos = p[k];
+			}
+		}
 	}
 }
+#endif
 
-/* Floating point slice and convert to unpacked 8-bit integer */
-static void pss_slice_cvt(float complex *in, uint8_t *out, int len)
+/*
+ * Peaks of all three sequences in a single pass over the packed samples.
+ * Vector steps cover lags whose windows start on a multiple of the lane
+ * count, with leading and trailing lags correlated bitwise.
+ */
+static void pss_corr(const uint64_t *xr, const uint64_t *xi, int len,
+		     const uint64_t *hr, const uint64_t *hi,
+		     struct pss_peak *peak)
 {
-	for (int i = 0; i < len; i++) {
-		out[2 * i + 0] = SIGN(crealf(in[i]));
-		out[2 * i + 1] = SIGN(cimagf(in[i]));
-	}
+	int end = 0;
+
+	for (int n = 0; n < LTE_PSS_NUM; n++)
+		peak[n].mag = peak[n].pos = 0;
+
+#ifdef PSS_LANES
+	int start = len < PSS_LANES - 1 ? len : PSS_LANES - 1;
+
+	end = start + (len - start) / PSS_LANES * PSS_LANES;
+
+	pss_bit_corr(xr, xi, 0, start, hr, hi, peak);
+	pss_vec_corr(xr, xi, start, end, hr, hi, peak);
+#endif
+	pss_bit_corr(xr, xi, end, len, hr, hi, peak);
 }
 
-/* Find the maximum value and index of a 16-bit sequence */
-static int pss_findmax(int16_t *seq, int len, int *pos)
+/* Floating point slice and pack behind the leading zero word */
+static void pss_slice_pack(float complex *in, uint64_t *xr, uint64_t *xi,
+			   int words, int len)
 {
-	int i, v, p = 0, max = 0;
+	int i = 0, k, n;
+	uint64_t r, q;
 
-	for (i = 0; i < len; i++) {
-		v = seq[i];
-		if (v > max) {
-			max = v;
-			p = i;
-		}
+	for (k = 0; k < words; k++)
+		xr[k] = xi[k] = 0;
+
+#ifdef HAVE_SSE3
+	/* Four samples per step with sign masks of not less than zero */
+	__m128 a, b;
+	const __m128 z = _mm_setzero_ps();
+
+	for (; i + 4 <= len; i += 4) {
+		a = _mm_loadu_ps((const float *) &in[i + 0]);
+		b = _mm_loadu_ps((const float *) &in[i + 2]);
+
+		r = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_shuffle_ps(a, b,
+				    _MM_SHUFFLE(2, 0, 2, 0)), z));
+		q = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_shuffle_ps(a, b,
+				    _MM_SHUFFLE(3, 1, 3, 1)), z));
+
+		xr[(i >> 6) + 1] |= r << (i & 63);
+		xi[(i >> 6) + 1] |= q << (i & 63);
 	}
+#endif
 
-	if (pos)
-		*pos = p;
+	for (; i < len; i += n) {
+		n = 64 - (i & 63) < len - i ? 64 - (i & 63) : len - i;
 
-	return max;
+		for (k = 0, r = q = 0; k < n; k++) {
+			r |= (uint64_t) SIGN(crealf(in[i + k])) << k;
+			q |= (uint64_t) SIGN(cimagf(in[i + k])) << k;
+		}
+
+		xr[(i >> 6) + 1] |= r << (i & 63);
+		xi[(i >> 6) + 1] |= q << (i & 63);
+	}
 }
 
 /* Fractional peak determination with interpolation */
@@ -133,27 +327,25 @@ int lte_pss_search(struct lte_rx *rx, struct cxvec **subframe,
 	int corr_mag = 0;
 	int corr_pos = 0;
 	int len = subframe[0]->len;
+	int words = len / 64 + 2;
 
-	int16_t corr[len];
-	uint8_t sliced[2][2 * len];
+	uint64_t xr[words], xi[words];
+	struct pss_peak peak[2][LTE_PSS_NUM];
 
 	uint64_t pss_r[3] = { rx->pss[0][0], rx->pss[1][0], rx->pss[2][0] };
 	uint64_t pss_i[3] = { rx->pss[0][1], rx->pss[1][1], rx->pss[2][1] };
 
-	for (int i = 0; i < chans; i++)
-		pss_slice_cvt(subframe[i]->data, sliced[i], len);
+	for (int n = 0; n < chans; n++) {
+		pss_slice_pack(subframe[n]->data, xr, xi, words, len);
+		pss_corr(xr, xi, len, pss_r, pss_i, peak[n]);
+	}
 
 	for (int i = 0; i < 3; i++) {
 		for (int n = 0; n < chans; n++) {
-			int pos, mag = 0;
-
-			pss_bit_corr(sliced[n], corr, len, pss_r[i], pss_i[i]);
-
-			mag = pss_findmax(corr, len, &pos);
-			if (mag > corr_mag) {
+			if (peak[n][i].mag > corr_mag) {
 				corr_pss = i;
-				corr_mag = mag;
-				corr_pos = pos;
+				corr_mag = peak[n][i].mag;
+				corr_pos = peak[n][i].pos;
 			}
 		}
 	}
@@ -22,30 +22,35 @@
 #include <string>
 #include <iomanip>
 #include <map>
+#include <sstream>
 #include <complex>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <unistd.h>
 #include <getopt.h>
 
 #include "BufferQueue.h"
+#include "LteBuffer.h"
 #include "SynchronizerPBCH.h"
 #include "SynchronizerPDSCH.h"
 #include "DecoderPDSCH.h"
 #include "DecoderASN1.h"
+#include "ReorderBuffer.h"
+#include "RntiTable.h"
+#include "TaskExecutor.h"
+#include "ThreadPlacement.h"
 #include "FreqAverager.h"
 #include "UHDDevice.h"
 
 extern "C" {
 #include "lte/log.h"
+#include "lte/pdsch_block.h"
+#include "turbo/turbo.h"
+#include "dsp/fft.h"
 }
 
-/*
- * Number of LTE subframe buffers passed between PDSCH processing threads
- */
-#define NUM_RECV_SUBFRAMES        128
-
 enum SampleType {
     COMPLEX_FLOAT,
     COMPLEX_SHORT,
@@ -54,14 +59,24 @@ enum SampleType {
 struct Config {
     std::string args;
     std::string filename;
+    std::string wisdom;
     SampleType sampType = COMPLEX_FLOAT; 
     double freq      = 1e9;
     double gain      = 50;
     unsigned chans   = 1;
     unsigned rbs     = 0;
     unsigned threads = 1;
+    unsigned window  = REORDER_WINDOW;
+    unsigned workers = 0;
+    int priority     = 0;
+    int turboIter    = LTE_PDSCH_DEF_ITER;
+    int turboStop    = LTE_PDSCH_STOP_CRC;
+    int turboWindow  = 0;
+    int turboTrain   = TURBO_DEF_TRAIN;
+    std::vector<int> cpus;
     uint16_t port    = 7878;
     uint16_t rnti    = 0xffff;
+    bool discover    = false;
     UHDDevice<>::ReferenceType ref = UHDDevice<>::REF_INTERNAL;
 };
 
@@ -75,12 +90,23 @@ static void print_help()
         "  -g  --gain     RF receive gain\n"
         "  -r, --ref      Frequency reference (%s)\n"
         "  -j  --threads  Number of PDSCH decoding threads (default = 1)\n"
+        "  -w  --window   PDSCH reorder window in subframes (default = %u)\n"
+        "  -t  --workers  Threads shared for code block decoding (default = 0)\n"
+        "  -P  --cpus     CPU list, synchronizer first then decoders (e.g. 2,4,6)\n"
+        "  -R  --priority SCHED_FIFO priority for sync/decoders (default = off)\n"
+        "  -I  --iter     Maximum turbo decoder iterations (default = %i)\n"
+        "  -S  --stop     Turbo early termination (%s)\n"
+        "  -W  --twindow  Turbo sliding window[,training] steps (e.g. %i,%i)\n"
         "  -b  --rb       Number of LTE resource blocks (default = auto)\n"
         "  -n  --rnti     LTE RNTI (default = 0xFFFF)\n"
+        "  -D  --discover Blind C-RNTI discovery from PDCCH candidates\n"
         "  -p  --port     Wireshark port\n"
         "  -s  --samp     Sample format('short', 'float')\n"
-        "  -F  --file     Read from file instead of device\n\n",
-        "'internal', 'external', 'gps'"
+        "  -F  --file     Read from file instead of device\n"
+        "  -X  --wisdom   FFTW wisdom file, loaded at start and updated with new plans\n\n",
+        "'internal', 'external', 'gps'", REORDER_WINDOW,
+        LTE_PDSCH_DEF_ITER, "'crc', 'hd', 'both', 'off'",
+        TURBO_DEF_WINDOW, TURBO_DEF_TRAIN
     );
 }
 
@@ -111,6 +137,27 @@ static void print_config(Config *config)
         return ss.str();
     };
 
+    const std::map<int, std::string> stopMap = {
+        { LTE_PDSCH_STOP_NONE,   "no early termination" },
+        { LTE_PDSCH_STOP_CRC,    "CRC termination" },
+        { LTE_PDSCH_STOP_STABLE, "hard decision termination" },
+        { LTE_PDSCH_STOP_CRC | LTE_PDSCH_STOP_STABLE,
+                                 "CRC and hard decision termination" },
+    };
+
+    auto cpuString = [](const std::vector<int> &cpus) {
+        std::stringstream ss;
+        for (size_t i = 0; i < cpus.size(); i++)
+            ss << (i ? "," : "") << cpus[i];
+        return cpus.empty() ? std::string("Any") : ss.str();
+    };
+
+    auto windowString = [](int window, int train) {
+        std::stringstream ss;
+        ss << window << " steps, " << train << " training";
+        return window ? ss.str() : std::string("Full block");
+    };
+
     fprintf(stdout,
         "Config:\n"
         "    Device args.............. \"%s\"\n"
@@ -121,8 +168,16 @@ static void print_config(Config *config)
         "    Receive antennas......... %u\n"
         "    Frequency reference...... %s\n"
         "    PDSCH decoding threads... %u\n"
+        "    PDSCH reorder window..... %u\n"
+        "    Code block workers....... %u\n"
+        "    Thread CPUs.............. %s\n"
+        "    Real-time priority....... %i\n"
+        "    Turbo iterations......... %i (%s)\n"
+        "    Turbo window............. %s\n"
         "    LTE resource blocks...... %u\n"
         "    LTE RNTI................. %s\n"
+        "    RNTI discovery........... %s\n"
+        "    FFTW wisdom.............. \"%s\"\n"
         "\n",
         config->args.c_str(),
         config->filename.c_str(),
@@ -132,8 +187,17 @@ static void print_config(Config *config)
         config->chans,
         refMap.at(config->ref).c_str(),
         config->threads,
+        config->window,
+        config->workers,
+        cpuString(config->cpus).c_str(),
+        config->priority,
+        config->turboIter,
+        stopMap.at(config->turboStop).c_str(),
+        windowString(config->turboWindow, config->turboTrain).c_str(),
         config->rbs,
-        rntiString(config->rnti).c_str()
+        rntiString(config->rnti).c_str(),
+        config->discover ? "On" : "Off",
+        config->wisdom.c_str()
     );
 }
 
@@ -151,6 +215,13 @@ static bool handle_options(int argc, char **argv, Config &config)
       { "short", COMPLEX_SHORT },
     };
 
+    const std::map<std::string, int> stopMap = {
+      { "off",  LTE_PDSCH_STOP_NONE },
+      { "crc",  LTE_PDSCH_STOP_CRC },
+      { "hd",   LTE_PDSCH_STOP_STABLE },
+      { "both", LTE_PDSCH_STOP_CRC | LTE_PDSCH_STOP_STABLE },
+    };
+
     auto setParam = [](const auto &m, auto arg, auto &val) {
       auto mi = m.find(arg);
       if (mi == m.end()) {
@@ -168,16 +239,25 @@ static bool handle_options(int argc, char **argv, Config &config)
         { "freq",    1, nullptr, 'f' },
         { "gain",    1, nullptr, 'g' },
         { "threads", 1, nullptr, 'j' },
+        { "window",  1, nullptr, 'w' },
+        { "workers", 1, nullptr, 't' },
+        { "cpus",    1, nullptr, 'P' },
+        { "priority",1, nullptr, 'R' },
+        { "iter",    1, nullptr, 'I' },
+        { "stop",    1, nullptr, 'S' },
+        { "twindow", 1, nullptr, 'W' },
         { "rb",      1, nullptr, 'b' },
         { "rnti",    1, nullptr, 'n' },
+        { "discover",0, nullptr, 'D' },
         { "ref" ,    1, nullptr, 'r' },
         { "port",    1, nullptr, 'p' },
         { "file",    1, nullptr, 'F' },
         { "samp",    1, nullptr, 's' },
+        { "wisdom",  1, nullptr, 'X' },
     };
 
     int option;
-    while ((option = getopt_long(argc, argv, "ha:c:f:g:j:b:n:r:p:F:s:", longopts, nullptr)) != -1) {
+    while ((option = getopt_long(argc, argv, "ha:c:f:g:j:w:t:P:R:I:S:W:b:n:Dr:p:F:s:X:", longopts, nullptr)) != -1) {
         switch (option) {
         case 'a':
             config.args = optarg;
@@ -198,12 +278,72 @@ static bool handle_options(int argc, char **argv, Config &config)
         case 'j':
             config.threads = atoi(optarg);
             break;
+        case 'w':
+            config.window = atoi(optarg);
+            if (!config.window || config.window >= NUM_RECV_SUBFRAMES) {
+                printf("Invalid reorder window\n");
+                return false;
+            }
+            break;
+        case 't': {
+            int workers = atoi(optarg);
+            if (workers < 1 || workers > EXEC_MAX_WORKERS) {
+                printf("Invalid number of code block workers\n");
+                return false;
+            }
+            config.workers = workers;
+            break;
+        }
+        case 'P': {
+            std::stringstream ss(optarg);
+            std::string cpu;
+            while (std::getline(ss, cpu, ',')) {
+                int n = atoi(cpu.c_str());
+                if (n < 0 || n >= CPU_SETSIZE) {
+                    printf("Invalid CPU '%s'\n", cpu.c_str());
+                    return false;
+                }
+                config.cpus.push_back(n);
+            }
+            break;
+        }
+        case 'R':
+            config.priority = atoi(optarg);
+            if (config.priority < 0 || config.priority > 99) {
+                printf("Invalid real-time priority\n");
+                return false;
+            }
+            break;
+        case 'I':
+            config.turboIter = atoi(optarg);
+            if (config.turboIter < 1 || config.turboIter > LTE_PDSCH_MAX_ITER) {
+                printf("Invalid number of turbo iterations\n");
+                return false;
+            }
+            break;
+        case 'S':
+            if (!setParam(stopMap, optarg, config.turboStop)) return false;
+            break;
+        case 'W': {
+            const char *train = strchr(optarg, ',');
+            config.turboWindow = atoi(optarg);
+            if (train) config.turboTrain = atoi(train + 1);
+            if (lte_turbo_check_window(config.turboWindow,
+                                       config.turboTrain)) {
+                printf("Invalid turbo window\n");
+                return false;
+            }
+            break;
+        }
         case 'b':
             config.rbs = atoi(optarg);
             break;
         case 'n':
             config.rnti = std::stoi(optarg, nullptr, 0);
             break;
+        case 'D':
+            config.discover = true;
+            break;
         case 'r':
             if (!setParam(refMap, optarg, config.ref)) return false;
             break;
@@ -221,6 +361,9 @@ static bool handle_options(int argc, char **argv, Config &config)
         case 's':
             if (!setParam(sampMap, optarg, config.sampType)) return false;
             break;
+        case 'X':
+            config.wisdom = optarg;
+            break;
         case 'h':
         default:
             return false;
@@ -269,19 +412,55 @@ public:
     LTEDecoder(Config &config) : config(config) { }
     void start() {
         std::vector<std::thread> threads;
-        auto pdschQueue = std::make_shared<BufferQueue>();
-        auto pdschReturnQueue = std::make_shared<BufferQueue>();
+        auto pdschQueue = std::make_shared<BufferQueue>(NUM_RECV_SUBFRAMES);
+        auto pdschReturnQueue = std::make_shared<BufferQueue>(NUM_RECV_SUBFRAMES);
         auto asn1 = std::make_shared<DecoderASN1>();
 
+        /*
+         * Place the synchronizer before the buffer pool, executor and
+         * synchronizer state are allocated so that they are first touched
+         * on its node
+         */
+        ThreadPlacement placement(config.cpus, config.priority);
+        placement.placeSync();
+
+        auto pool = std::make_shared<LteBufferPool>(NUM_RECV_SUBFRAMES,
+                                                    config.chans);
+        auto reorder = std::make_shared<ReorderBuffer>(config.window);
+        reorder->attachOutboundQueue(pdschReturnQueue);
+        reorder->attachBufferPool(pool);
+        reorder->attachDecoderASN1(asn1);
+
+        /* Executor threads return to the default affinity and scheduling */
+        std::shared_ptr<TaskExecutor> executor;
+        if (config.workers) {
+            executor = std::make_shared<TaskExecutor>(config.workers,
+                [&placement](size_t) { placement.placeDefault(); });
+        }
+
+        std::shared_ptr<RntiTable> rntiTable;
+        if (config.discover)
+            rntiTable = std::make_shared<RntiTable>();
+
         SynchronizerPDSCH<T> sync(config.chans);
         sync.attachInboundQueue(pdschReturnQueue);
         sync.attachOutboundQueue(pdschQueue);
+        sync.attachBufferPool(pool);
 
+        /*
+         * Device streamer threads are created when the device is opened and
+         * inherit the placement of the calling thread, so open it with the
+         * default placement and place the synchronizer again afterwards
+         */
         if (!config.filename.empty()) {
             if (!sync.openFile(config.rbs, config.filename))
                 return;
         } else {
-            if (!sync.openDevice(config.rbs, config.ref, config.args)) {
+            placement.placeDefault();
+            bool opened = sync.openDevice(config.rbs, config.ref, config.args);
+            placement.placeSync();
+
+            if (!opened) {
                 fprintf(stderr, "Radio: Failed to initialize\n");
                 return;
             }
@@ -289,23 +468,59 @@ public:
 
         /* Prime the queue */
         for (int i = 0; i < NUM_RECV_SUBFRAMES; i++)
-            pdschReturnQueue->write(std::make_shared<LteBuffer>(config.chans));
+            pdschReturnQueue->write(i);
  
         asn1->open(config.port);
         std::vector<DecoderPDSCH> decoders(config.threads,
                                            DecoderPDSCH(config.chans));
-        for (auto &d : decoders) {
+        for (unsigned i = 0; i < decoders.size(); i++) {
+            auto &d = decoders[i];
             d.addRNTI(config.rnti);
+            d.setTurboIterations(config.turboIter, config.turboStop);
+            d.setTurboWindow(config.turboWindow, config.turboTrain);
             d.attachInboundQueue(pdschQueue);
-            d.attachOutboundQueue(pdschReturnQueue);
-            d.attachDecoderASN1(asn1);
-            threads.push_back(std::thread(&DecoderPDSCH::start, &d));
+            d.attachBufferPool(pool);
+            d.attachReorderBuffer(reorder);
+            d.attachTaskExecutor(executor);
+            d.attachRntiTable(rntiTable);
+            threads.push_back(std::thread([&placement, &d, i] {
+                placement.placeDecoder(i);
+                d.start();
+            }));
         }
 
         sync.setFreq(config.freq);
         sync.setGain(config.gain);
         sync.start();
 
+        fprintf(stdout, "PDSCH reorder depth %zu (max %zu), %lu late\n",
+                reorder->depth(), reorder->maxDepth(), reorder->lateCount());
+
+        if (rntiTable) {
+            fprintf(stdout, "PDCCH discovered %lu RNTIs, %zu active\n",
+                    rntiTable->discoveredCount(), rntiTable->activeCount());
+        }
+
+        struct lte_pdsch_iter_stats turbo { };
+        for (auto &d : decoders) {
+            auto stats = d.turboStats();
+            turbo.blocks += stats.blocks;
+            turbo.iters += stats.iters;
+            for (int i = 0; i <= LTE_PDSCH_MAX_ITER; i++)
+                turbo.hist[i] += stats.hist[i];
+        }
+
+        if (turbo.blocks) {
+            fprintf(stdout, "PDSCH turbo code blocks %lu, "
+                    "average iterations %.2f\n", turbo.blocks,
+                    (double) turbo.iters / turbo.blocks);
+            for (int i = 1; i <= LTE_PDSCH_MAX_ITER; i++) {
+                if (turbo.hist[i])
+                    fprintf(stdout, "    %2i iterations: %lu\n",
+                            i, turbo.hist[i]);
+            }
+        }
+
         for (auto &t : threads)
             t.join();
     }
@@ -321,6 +536,12 @@ int main(int argc, char **argv)
     }
 
     print_config(&config);
+
+    /* A missing file is created when the first plan is measured */
+    const char *wisdom = config.wisdom.empty() ? nullptr : config.wisdom.c_str();
+    if (wisdom && fft_wisdom_import(wisdom) < 0)
+        fprintf(stdout, "FFTW wisdom not loaded from \"%s\"\n", wisdom);
+
     if (config.sampType == COMPLEX_FLOAT) {
         LTEDecoder<std::complex<float>> decoder(config);
         decoder.start();
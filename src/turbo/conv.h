@@ -34,4 +34,32 @@ int lte_conv_encode(const struct lte_conv_code *code,
 int lte_conv_decode(const struct lte_conv_code *code,
 		    const int8_t *input, uint8_t *output);
 
+/*
+ * Persistent decoder object
+ *
+ * Created once for a code (rate, constraint length and generators) and
+ * reused for any block length of that code without further allocation.
+ * Decoding a block longer than the creation length grows the object.
+ */
+struct vdecoder;
+
+struct vdecoder *alloc_vdec(const struct lte_conv_code *code);
+void free_vdec(struct vdecoder *dec);
+
+int lte_conv_decode_vdec(struct vdecoder *dec,
+			 const struct lte_conv_code *code,
+			 const int8_t *input, uint8_t *output);
+
+/* Number of codewords decoded in lock-step by lte_conv_decode_batch() */
+int lte_conv_batch_lanes();
+
+/*
+ * Decode 'n' codewords of the decoder's code with equal length. Per
+ * codeword return values of lte_conv_decode() are written to 'rc' if not
+ * NULL. Output is identical to decoding each codeword separately.
+ */
+int lte_conv_decode_batch(struct vdecoder *dec,
+			  const struct lte_conv_code *code, int n,
+			  const int8_t **input, uint8_t **output, int *rc);
+
 #endif /* _CONV_H_ */
@@ -0,0 +1,153 @@
+/*
+ * Viterbi decoder for convolutional codes - Multi-codeword SIMD recursion
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Each 16-bit element of a vector belongs to a separate codeword, so one
+ * vector holds the metric of a single trellis state for CONV_LANES equal
+ * length codewords. Butterflies then need no shuffles and all codewords
+ * advance through the trellis in lock-step. Arithmetic matches the single
+ * codeword SSE recursion in conv_sse.h.
+ *
+ * Path decisions for one state are stored as a 32-bit lane mask. Packed
+ * compares without a native mask register set two bits per lane.
+ */
+#ifdef HAVE_SSE3
+#include <stdint.h>
+#include <immintrin.h>
+
+#if defined(HAVE_AVX512BW)
+#define CONV_LANES		32
+#define CONV_VEC_ALIGN		64
+#define CONV_LANE_SHIFT		0
+
+typedef __m512i cvec;
+
+#define CV_LOAD(P)		_mm512_load_si512((const void *) (P))
+#define CV_ZERO()		_mm512_setzero_si512()
+#define CV_SET16(V)		_mm512_set1_epi16(V)
+#define CV_ADDS(A,B)		_mm512_adds_epi16(A, B)
+#define CV_SUBS(A,B)		_mm512_subs_epi16(A, B)
+#define CV_MAX(A,B)		_mm512_max_epi16(A, B)
+#define CV_MIN(A,B)		_mm512_min_epi16(A, B)
+#define CV_GT_MASK(A,B)		((uint32_t) _mm512_cmpgt_epi16_mask(A, B))
+#elif defined(HAVE_AVX2)
+#define CONV_LANES		16
+#define CONV_VEC_ALIGN		32
+#define CONV_LANE_SHIFT		1
+
+typedef __m256i cvec;
+
+#define CV_LOAD(P)		_mm256_load_si256((const __m256i *) (P))
+#define CV_ZERO()		_mm256_setzero_si256()
+#define CV_SET16(V)		_mm256_set1_epi16(V)
+#define CV_ADDS(A,B)		_mm256_adds_epi16(A, B)
+#define CV_SUBS(A,B)		_mm256_subs_epi16(A, B)
+#define CV_MAX(A,B)		_mm256_max_epi16(A, B)
+#define CV_MIN(A,B)		_mm256_min_epi16(A, B)
+#define CV_GT_MASK(A,B)		\
+	((uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi16(A, B)))
+#else
+#define CONV_LANES		8
+#define CONV_VEC_ALIGN		16
+#define CONV_LANE_SHIFT		1
+
+typedef __m128i cvec;
+
+#define CV_LOAD(P)		_mm_load_si128((const __m128i *) (P))
+#define CV_ZERO()		_mm_setzero_si128()
+#define CV_SET16(V)		_mm_set1_epi16(V)
+#define CV_ADDS(A,B)		_mm_adds_epi16(A, B)
+#define CV_SUBS(A,B)		_mm_subs_epi16(A, B)
+#define CV_MAX(A,B)		_mm_max_epi16(A, B)
+#define CV_MIN(A,B)		_mm_min_epi16(A, B)
+#define CV_GT_MASK(A,B)		\
+	((uint32_t) _mm_movemask_epi8(_mm_cmpgt_epi16(A, B)))
+#endif
+
+/* Path decision bit of codeword 'lane' */
+#define CONV_LANE_BIT(L)	(1u << ((L) << CONV_LANE_SHIFT))
+
+/*
+ * Branch metrics
+ *
+ * Generate all 2^N signed combinations of the N lane packed soft inputs of
+ * one trellis stage. Bit 'j' of the pattern index selects a negative
+ * trellis output for input 'j'.
+ */
+static inline void conv_lanes_branch(const int16_t *x, int n, cvec *bm)
+{
+	int i, j;
+	cvec v;
+
+	for (i = 0; i < (1 << n); i++)
+		bm[i] = CV_ZERO();
+
+	for (j = 0; j < n; j++) {
+		v = CV_LOAD(&x[j * CONV_LANES]);
+
+		for (i = 0; i < (1 << n); i++) {
+			if (i & (1 << j))
+				bm[i] = CV_SUBS(bm[i], v);
+			else
+				bm[i] = CV_ADDS(bm[i], v);
+		}
+	}
+}
+
+/*
+ * Combined path metric update
+ *
+ * Butterfly 'i' reads states 2i and 2i+1 and writes states i and i+ns/2
+ * with the branch metric selected by 'pat[i]'. Decisions follow the
+ * convention of SSE_BUTTERFLY where a set bit selects the even state.
+ */
+static inline void conv_lanes_metrics(int ns, const uint8_t *pat,
+				      const cvec *bm, const cvec *sums_p,
+				      cvec *sums_c, uint32_t *paths, int norm)
+{
+	int i, h = ns / 2;
+	cvec m, a, b, min;
+
+	for (i = 0; i < h; i++) {
+		m = bm[pat[i]];
+
+		a = CV_ADDS(sums_p[2 * i + 0], m);
+		b = CV_SUBS(sums_p[2 * i + 1], m);
+		sums_c[i] = CV_MAX(a, b);
+		paths[i] = CV_GT_MASK(a, b);
+
+		a = CV_SUBS(sums_p[2 * i + 0], m);
+		b = CV_ADDS(sums_p[2 * i + 1], m);
+		sums_c[i + h] = CV_MAX(a, b);
+		paths[i + h] = CV_GT_MASK(a, b);
+	}
+
+	if (!norm)
+		return;
+
+	min = sums_c[0];
+	for (i = 1; i < ns; i++)
+		min = CV_MIN(min, sums_c[i]);
+
+	for (i = 0; i < ns; i++)
+		sums_c[i] = CV_SUBS(sums_c[i], min);
+}
+#else
+#define CONV_LANES		1
+#endif /* HAVE_SSE3 */
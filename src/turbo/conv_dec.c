@@ -27,6 +27,7 @@
 #include "conv.h"
 #include "conv_gen.h"
 #include "conv_sse.h"
+#include "conv_batch.h"
 
 #define API_EXPORT	__attribute__((__visibility__("default")))
 #define PARITY(X) __builtin_parity(X)
@@ -57,27 +58,50 @@ struct vtrellis {
 	uint8_t *vals;
 };
 
+/*
+ * Multi-codeword Storage
+ *
+ * len   - Allocated number of trellis stages
+ * pat   - Branch metric pattern of each butterfly
+ * x     - Lane packed soft inputs
+ * sums  - Lane packed path metrics (two sets)
+ * paths - Lane masks of path decisions
+ */
+struct vbatch {
+	int len;
+	uint8_t pat[32];
+	int16_t *x;
+	int16_t *sums;
+	uint32_t *paths;
+};
+
 /*
  * Viterbi Decoder
  *
  * n         - Code order
  * k         - Constraint length
  * len       - Horizontal length of trellis
+ * max_len   - Allocated length of trellis paths
  * recursive - Set to '1' if the code is recursive
  * intrvl    - Normalization interval
  * trellis   - Trellis object
  * punc      - Puncturing sequence
  * paths     - Trellis paths
+ * batch     - Multi-codeword lock-step storage
  */
 struct vdecoder {
 	int n;
 	int k;
 	int len;
+	int max_len;
 	int recursive;
 	int intrvl;
+	unsigned rgen;
+	unsigned gen[4];
 	struct vtrellis *trellis;
 	int *punc;
 	int16_t **paths;
+	struct vbatch batch;
 
 	void (*metric_func)(const int8_t *, const int16_t *,
 			    int16_t *, int16_t *, int);
@@ -322,36 +346,91 @@ static int traceback(struct vdecoder *dec, uint8_t *out, int term, int len)
 }
 
 /* Release decoder object */
-static void free_vdec(struct vdecoder *dec)
+API_EXPORT
+void free_vdec(struct vdecoder *dec)
 {
 	if (!dec)
 		return;
 
-	free(dec->paths[0]);
+	if (dec->paths)
+		free(dec->paths[0]);
 	free(dec->paths);
+	free(dec->batch.x);
+	free(dec->batch.sums);
+	free(dec->batch.paths);
 	free_trellis(dec->trellis);
 	free(dec);
 }
 
+/* Trellis length including flushing bits */
+static int vdec_len(const struct lte_conv_code *code)
+{
+	if (code->term == CONV_TERM_FLUSH)
+		return code->len + code->k - 1;
+
+	return code->len;
+}
+
+/* Grow path storage to at least 'len' trellis stages */
+static int alloc_paths(struct vdecoder *dec, int len)
+{
+	int i, ns = dec->trellis->num_states;
+	int16_t **paths;
+
+	if (len <= dec->max_len)
+		return 0;
+
+	paths = (int16_t **) malloc(sizeof(int16_t *) * len);
+	if (!paths)
+		return -ENOMEM;
+
+	paths[0] = vdec_malloc(ns * len);
+	if (!paths[0]) {
+		free(paths);
+		return -ENOMEM;
+	}
+
+	for (i = 1; i < len; i++)
+		paths[i] = &paths[0][i * ns];
+
+	if (dec->paths)
+		free(dec->paths[0]);
+	free(dec->paths);
+
+	dec->paths = paths;
+	dec->max_len = len;
+
+	return 0;
+}
+
 /*
  * Allocate decoder object
  *
  * Subtract the constraint length K on the normalization interval to
- * accommodate the initialization path metric at state zero.
+ * accommodate the initialization path metric at state zero. Path storage
+ * is sized for the code length and grows on demand if the object is reused
+ * for longer blocks of the same code.
  */
-static struct vdecoder *alloc_vdec(const struct lte_conv_code *code)
+API_EXPORT
+struct vdecoder *alloc_vdec(const struct lte_conv_code *code)
 {
-	int i, ns;
+	int i;
 	struct vdecoder *dec;
 
-	ns = NUM_STATES(code->k);
+	if (((code->k != 5) && (code->k != 7)) ||
+	    (code->n < 2) || (code->n > 4) || (code->len < 1))
+		return NULL;
 
 	dec = (struct vdecoder *) calloc(1, sizeof(struct vdecoder));
 	dec->n = code->n;
 	dec->k = code->k;
+	dec->rgen = code->rgen;
 	dec->recursive = code->rgen ? 1 : 0;
 	dec->intrvl = INT16_MAX / (dec->n * INT8_MAX) - dec->k;
 
+	for (i = 0; i < code->n; i++)
+		dec->gen[i] = code->gen[i];
+
 	if (dec->k == 5) {
 		switch (dec->n) {
 		case 2:
@@ -384,19 +463,14 @@ static struct vdecoder *alloc_vdec(const struct lte_conv_code *code)
 		goto fail;
 	}
 
-	if (code->term == CONV_TERM_FLUSH)
-		dec->len = code->len + code->k - 1;
-	else
-		dec->len = code->len;
+	dec->len = vdec_len(code);
 
 	dec->trellis = generate_trellis(code);
 	if (!dec->trellis)
 		goto fail;
 
-	dec->paths = (int16_t **) malloc(sizeof(int16_t *) * dec->len);
-	dec->paths[0] = vdec_malloc(ns * dec->len);
-	for (i = 1; i < dec->len; i++)
-		dec->paths[i] = &dec->paths[0][i * ns];
+	if (alloc_paths(dec, dec->len))
+		goto fail;
 
 	return dec;
 fail:
@@ -404,6 +478,24 @@ fail:
 	return NULL;
 }
 
+/* Decoder objects are only valid for the code they were created with */
+static int vdec_match(const struct vdecoder *dec,
+		      const struct lte_conv_code *code)
+{
+	int i;
+
+	if ((dec->n != code->n) || (dec->k != code->k) ||
+	    (dec->rgen != code->rgen))
+		return 0;
+
+	for (i = 0; i < code->n; i++) {
+		if (dec->gen[i] != code->gen[i])
+			return 0;
+	}
+
+	return 1;
+}
+
 /* Depuncture sequence with nagative value terminated puncturing matrix */
 static int depuncture(const int8_t *in, const int *punc, int8_t *out, int len)
 {
@@ -471,6 +563,266 @@ static int conv_decode(struct vdecoder *dec, const int8_t *seq,
 	return traceback(dec, out, term, len);
 }
 
+/*
+ * Decode with a persistent decoder object
+ *
+ * Trellis metrics are reset on each call, so the object may be reused for
+ * any block length of the same code. Only a block longer than any seen
+ * before allocates memory.
+ */
+API_EXPORT
+int lte_conv_decode_vdec(struct vdecoder *dec,
+			 const struct lte_conv_code *code,
+			 const int8_t *in, uint8_t *out)
+{
+	if (!dec || (code->len < 1) || !vdec_match(dec, code))
+		return -EINVAL;
+
+	dec->len = vdec_len(code);
+	if (alloc_paths(dec, dec->len))
+		return -ENOMEM;
+
+	return conv_decode(dec, in, code->punc,
+			   out, code->len, code->term);
+}
+
+#if CONV_LANES > 1
+/*
+ * Grow multi-codeword storage to at least 'len' trellis stages
+ *
+ * Branch metric patterns are derived from the trellis outputs on first use.
+ * Set bit 'j' of a pattern marks a negative output for input 'j'.
+ */
+static int alloc_batch(struct vdecoder *dec, int len)
+{
+	int i, j, ns = dec->trellis->num_states;
+	int olen = (dec->n == 2) ? 2 : 4;
+	struct vbatch *b = &dec->batch;
+
+	if (len <= b->len)
+		return 0;
+
+	if (!b->sums) {
+		b->sums = (int16_t *) memalign(CONV_VEC_ALIGN,
+			sizeof(int16_t) * CONV_LANES * ns * 2);
+
+		for (i = 0; i < ns / 2; i++) {
+			b->pat[i] = 0;
+			for (j = 0; j < dec->n; j++) {
+				if (dec->trellis->outputs[olen * i + j] < 0)
+					b->pat[i] |= 1 << j;
+			}
+		}
+	}
+
+	free(b->x);
+	free(b->paths);
+	b->x = (int16_t *) memalign(CONV_VEC_ALIGN,
+		sizeof(int16_t) * CONV_LANES * dec->n * len);
+	b->paths = (uint32_t *) malloc(sizeof(uint32_t) * ns * len);
+
+	if (!b->sums || !b->x || !b->paths) {
+		b->len = 0;
+		return -ENOMEM;
+	}
+
+	b->len = len;
+
+	return 0;
+}
+
+/* Depuncture and transpose codewords into lane packed trellis stages */
+static void load_lanes(struct vdecoder *dec, const int8_t **in,
+		       const int *punc, int n)
+{
+	int i, lane, m = dec->len * dec->n;
+	int16_t *x = dec->batch.x;
+	int8_t depunc[m];
+	const int8_t *seq;
+
+	for (lane = 0; lane < CONV_LANES; lane++) {
+		if (lane >= n) {
+			for (i = 0; i < m; i++)
+				x[i * CONV_LANES + lane] = 0;
+			continue;
+		}
+
+		seq = in[lane];
+		if (punc) {
+			depuncture(seq, punc, depunc, m);
+			seq = depunc;
+		}
+
+		for (i = 0; i < m; i++)
+			x[i * CONV_LANES + lane] = seq[i];
+	}
+}
+
+/* Forward trellis recursion of all lanes, see _conv_decode() */
+static int _conv_decode_lanes(struct vdecoder *dec, int cur)
+{
+	int i, ns = dec->trellis->num_states;
+	struct vbatch *b = &dec->batch;
+	cvec *sums = (cvec *) b->sums;
+	cvec bm[16];
+
+	for (i = 0; i < dec->len; i++) {
+		const int16_t *x = &b->x[i * dec->n * CONV_LANES];
+		int norm = !(i % dec->intrvl);
+
+		/* Constant sizes let the compiler unroll the common codes */
+		if (dec->n == 3)
+			conv_lanes_branch(x, 3, bm);
+		else
+			conv_lanes_branch(x, dec->n, bm);
+
+		if (ns == 64) {
+			conv_lanes_metrics(64, b->pat, bm, &sums[cur * 64],
+					   &sums[!cur * 64],
+					   &b->paths[i * 64], norm);
+		} else {
+			conv_lanes_metrics(ns, b->pat, bm, &sums[cur * ns],
+					   &sums[!cur * ns],
+					   &b->paths[i * ns], norm);
+		}
+		cur = !cur;
+	}
+
+	return cur;
+}
+
+static unsigned lane_path(struct vdecoder *dec, int i,
+			  unsigned state, int lane)
+{
+	uint32_t mask = dec->batch.paths[i * dec->trellis->num_states + state];
+
+	return (mask & CONV_LANE_BIT(lane)) ? 0 : 1;
+}
+
+static unsigned _traceback_lane(struct vdecoder *dec, int lane,
+				unsigned state, uint8_t *out, int len)
+{
+	int i;
+	unsigned path;
+
+	for (i = len - 1; i >= 0; i--) {
+		path = lane_path(dec, i, state, lane);
+		out[i] = dec->trellis->vals[state];
+		state = vstate_lshift(state, dec->k, path);
+	}
+
+	return state;
+}
+
+/* Traceback of one lane for non-recursive codes, see traceback() */
+static int traceback_lane(struct vdecoder *dec, const int16_t *sums,
+			  int lane, uint8_t *out, int term, int len)
+{
+	int i, sum, max_p = -1, max = -1;
+	unsigned state = 0;
+
+	if (term == CONV_TERM_TAIL_BITING) {
+		for (i = 0; i < dec->trellis->num_states; i++) {
+			sum = sums[i * CONV_LANES + lane];
+			if (sum > max) {
+				max_p = max;
+				max = sum;
+				state = i;
+			}
+		}
+		if (max < 0)
+			return -EPROTO;
+	} else {
+		for (i = dec->len - 1; i >= len; i--)
+			state = vstate_lshift(state, dec->k,
+					      lane_path(dec, i, state, lane));
+	}
+
+	state = _traceback_lane(dec, lane, state, out, len);
+
+	if (term == CONV_TERM_TAIL_BITING)
+		_traceback_lane(dec, lane, state, out, len);
+
+	return max - max_p;
+}
+
+/* Decode up to CONV_LANES codewords in lock-step, see conv_decode() */
+static void conv_decode_lanes(struct vdecoder *dec, const int8_t **in,
+			      uint8_t **out, int *rc, int n,
+			      const int *punc, int len, int term)
+{
+	int i, cur = 0, ns = dec->trellis->num_states;
+	cvec *sums = (cvec *) dec->batch.sums;
+
+	load_lanes(dec, in, punc, n);
+
+	for (i = 0; i < ns; i++)
+		sums[i] = CV_ZERO();
+	if (term != CONV_TERM_TAIL_BITING)
+		sums[0] = CV_SET16(INT8_MAX * dec->n * dec->k);
+
+	cur = _conv_decode_lanes(dec, cur);
+
+	if (term == CONV_TERM_TAIL_BITING)
+		cur = _conv_decode_lanes(dec, cur);
+
+	for (i = 0; i < n; i++) {
+		int r = traceback_lane(dec, (int16_t *) &sums[cur * ns],
+				       i, out[i], term, len);
+		if (rc)
+			rc[i] = r;
+	}
+}
+#endif
+
+API_EXPORT
+int lte_conv_batch_lanes()
+{
+	return CONV_LANES;
+}
+
+/*
+ * Decode a batch of equal length codewords
+ *
+ * Non-recursive codes are decoded CONV_LANES codewords at a time with one
+ * codeword per vector element. Other codes, or builds without SIMD support,
+ * decode the codewords one after another with identical results.
+ */
+API_EXPORT
+int lte_conv_decode_batch(struct vdecoder *dec,
+			  const struct lte_conv_code *code, int n,
+			  const int8_t **in, uint8_t **out, int *rc)
+{
+	int i, r;
+
+	if (!dec || (n < 0) || (code->len < 1) || !vdec_match(dec, code))
+		return -EINVAL;
+
+#if CONV_LANES > 1
+	if (!dec->recursive) {
+		dec->len = vdec_len(code);
+		if (alloc_batch(dec, dec->len))
+			return -ENOMEM;
+
+		for (i = 0; i < n; i += CONV_LANES) {
+			conv_decode_lanes(dec, &in[i], &out[i],
+					  rc ? &rc[i] : NULL,
+					  n - i < CONV_LANES ? n - i : CONV_LANES,
+					  code->punc, code->len, code->term);
+		}
+
+		return 0;
+	}
+#endif
+	for (i = 0; i < n; i++) {
+		r = lte_conv_decode_vdec(dec, code, in[i], out[i]);
+		if (rc)
+			rc[i] = r;
+	}
+
+	return 0;
+}
+
 API_EXPORT
 int lte_conv_decode(const struct lte_conv_code *code,
 		    const int8_t *in, uint8_t *out)
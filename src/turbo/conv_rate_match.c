@@ -153,7 +153,9 @@ static void rate_match_rv(struct lte_rate_matcher *match, signed char *e, int E)
 	int *w_null = match->w_null;
 
 	int w_len = V * 3;
-	signed char *w = (signed char *) calloc(w_len, 1);
+	signed char w[w_len];
+
+	memset(w, 0, w_len);
 
 	for (i = 0; i < match->w_null_cnt; i++)
 		w[w_null[i]] = -128;
@@ -169,8 +171,6 @@ static void rate_match_rv(struct lte_rate_matcher *match, signed char *e, int E)
 
 	for (i = 0; i < 3; i++)
 		memcpy(match->v[i], &w[i * V], V * sizeof(char));
-
-	free(w);
 }
 
 static void lte_conv_scramble(signed char *d, int rows, signed char *v,
@@ -264,22 +264,28 @@ static int rate_match_init_fw(struct lte_rate_matcher *match,
 	if ((shift < 0) || (shift > 31))
 		return -EINVAL;
 
-	free(match->w_null);
-	match->w_null = (int *) calloc(MAX_W_NULL, sizeof(int));
+	/* Buffers only grow so that size changes do not reallocate */
+	if (!match->w_null)
+		match->w_null = (int *) calloc(MAX_W_NULL, sizeof(int));
 
 	for (i = 0; i < 3; i++) {
-		free(match->z[i]);
-		match->z[i] = (signed char *) calloc(V, sizeof(char));
+		if (V > match->V_alloc) {
+			free(match->z[i]);
+			match->z[i] = (signed char *) malloc(V * sizeof(char));
+			free(match->v[i]);
+			match->v[i] = (signed char *) malloc(V * sizeof(char));
+		}
 
+		memset(match->z[i], 0, V * sizeof(char));
 		if (d)
 			memcpy(match->z[i], d[i], D * sizeof(char));
 
-		free(match->v[i]);
-		match->v[i] = (signed char *) malloc(V * sizeof(char));
-
 		interlv(match->v[i], D, match->z[i]);
 	}
 
+	if (V > match->V_alloc)
+		match->V_alloc = V;
+
 	rate_match_fw(match, e, E);
 
 	return 0;
@@ -287,15 +293,14 @@ static int rate_match_init_fw(struct lte_rate_matcher *match,
 
 static int rate_match_init_rv(struct lte_rate_matcher *match, int D, int E)
 {
-	if ((D <= 0) || (E <= 0))
+	if ((D <= 0) || (E <= 0) || (E > MAX_E))
 		return -1;
 
-	signed char *e = calloc(E, sizeof(char));
+	signed char e[E];
 
+	memset(e, 0, E * sizeof(char));
 	rate_match_init_fw(match, NULL, D, e, E);
 
-	free(e);
-
 	return 0;
 }
 
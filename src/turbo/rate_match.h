@@ -5,6 +5,7 @@ struct lte_rate_matcher {
 	int E;
 	int D;
 	int V;
+	int V_alloc;
 	int rows;
 	int *w_null;
 	int w_null_cnt;
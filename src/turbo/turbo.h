@@ -40,9 +40,76 @@ int lte_turbo_encode(const struct lte_turbo_code *code,
 int lte_turbo_decode(struct tdecoder *dec, int len, int iter, uint8_t *output,
 		     const int8_t *d0, const int8_t *d1, const int8_t *d2);
 
+/*
+ * Early termination
+ *
+ * After each full iteration the packed hard decisions are passed to 'crc',
+ * which returns nonzero if the block checks. With 'stable' set, decoding
+ * also stops when hard decisions match those of the previous iteration.
+ */
+struct lte_turbo_stop {
+	int (*crc)(void *arg, const uint8_t *bits, int len);
+	void *arg;
+	int stable;
+};
+
+/* Packed output with early termination, returns iterations run */
+int lte_turbo_decode_stop(struct tdecoder *dec, int len, int max_iter,
+			  uint8_t *output, const int8_t *d0,
+			  const int8_t *d1, const int8_t *d2,
+			  const struct lte_turbo_stop *stop);
+
 /* Unpacked output */
 int lte_turbo_decode_unpack(struct tdecoder *dec, int len, int iter,
 			    uint8_t *output, const int8_t *d0,
 			    const int8_t *d1, const int8_t *d2);
 
+/*
+ * Sliding window decoding
+ *
+ * Splits each constituent decoder pass into independently decoded windows
+ * of 'window' trellis steps so that trellis metrics for large blocks stay
+ * cache resident. Windows are spread across SIMD lanes where available.
+ * Window edge metrics are estimated with 'train' training steps. A zero
+ * window restores full block decoding. Not used by lte_turbo_decode_lanes(),
+ * while lte_turbo_decode_batch() decodes blocks one at a time when set.
+ * Window plus training steps on both edges may not exceed the trellis
+ * length. Check returns zero if a window and training length are valid.
+ */
+#define TURBO_MIN_WINDOW	16
+#define TURBO_MAX_WINDOW	(TURBO_MAX_K + 3)
+#define TURBO_DEF_WINDOW	128
+#define TURBO_DEF_TRAIN		32
+
+int lte_turbo_check_window(int window, int train);
+int lte_turbo_set_window(struct tdecoder *dec, int window, int train);
+
+/*
+ * Write extrinsic values directly to their (de)interleaved positions in
+ * the backward recursion (default) instead of running separate QPP
+ * permutation passes. Output is identical either way.
+ */
+void lte_turbo_set_fused(struct tdecoder *dec, int fused);
+
+/* Number of code blocks decoded per pass of the wide SIMD kernel */
+int lte_turbo_lanes();
+
+/* Packed output for up to lte_turbo_lanes() blocks of equal length */
+int lte_turbo_decode_lanes(struct tdecoder *dec, int len, int iter, int n,
+			   uint8_t **output, const int8_t **d0,
+			   const int8_t **d1, const int8_t **d2);
+
+/*
+ * Batched packed output for 'n' blocks of any lengths. Equal length blocks
+ * share the wide kernel and a lane is refilled with the next pending block
+ * as soon as its block terminates. With a sliding window set, blocks are
+ * instead decoded one at a time with the windowed decoder, which keeps
+ * trellis metrics cache resident for large segmented transport blocks.
+ * 'stop' may be NULL. Iterations run for each block are returned in 'iters'.
+ */
+int lte_turbo_decode_batch(struct tdecoder *dec, int n, const int *len,
+			   int max_iter, uint8_t **output, const int8_t **d0,
+			   const int8_t **d1, const int8_t **d2,
+			   const struct lte_turbo_stop *stop, int *iters);
+
 #endif /* _LTE_TURBO_ */
@@ -0,0 +1,232 @@
+/*
+ * LTE Max-Log-MAP turbo decoder - AVX2 / AVX-512 multi-block recursions
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Each 128-bit lane of a wide register carries the 8 trellis states of a
+ * separate code block, so the recursions below are the SSE recursions in
+ * turbo_sse.h applied to two (AVX2) or four (AVX-512) equal length blocks
+ * at once. All byte shuffles and unpacks used are in-lane operations.
+ *
+ * Per-step scalar inputs (systematic, parity, extrinsic and normalization
+ * values) are stored lane interleaved, TURBO_LANES int16 values per
+ * trellis step, and broadcast to their lanes with a single byte shuffle.
+ */
+#include <stdint.h>
+#include <immintrin.h>
+
+/* Lane count, 2 or 4, is set by the including kernel */
+#if TURBO_LANES == 4
+#define TURBO_VEC_ALIGN		64
+
+typedef __m512i tvec;
+
+#define V_LOAD(P)		_mm512_load_si512((const void *) (P))
+#define V_STORE(P,V)		_mm512_store_si512((void *) (P), V)
+#define V_ZERO()		_mm512_setzero_si512()
+#define V_SET16(V)		_mm512_set1_epi16(V)
+#define V_BCAST128(V)		_mm512_broadcast_i32x4(V)
+#define V_ADDS(A,B)		_mm512_adds_epi16(A, B)
+#define V_SUBS(A,B)		_mm512_subs_epi16(A, B)
+#define V_SUB(A,B)		_mm512_sub_epi16(A, B)
+#define V_MAX(A,B)		_mm512_max_epi16(A, B)
+#define V_SRAI(A,N)		_mm512_srai_epi16(A, N)
+#define V_UNPACKLO(A,B)		_mm512_unpacklo_epi16(A, B)
+#define V_UNPACKHI(A,B)		_mm512_unpackhi_epi16(A, B)
+#define V_SHUFFLE8(A,M)		_mm512_shuffle_epi8(A, M)
+#define V_SHUFFLE32(A,I)	_mm512_shuffle_epi32(A, (_MM_PERM_ENUM) (I))
+#define V_SHUFFLELO(A,I)	_mm512_shufflelo_epi16(A, I)
+
+/* No sign instruction; negate where the constant pattern is negative */
+static inline tvec V_SIGN(tvec a, tvec s)
+{
+	return _mm512_mask_sub_epi16(a, _mm512_movepi16_mask(s), V_ZERO(), a);
+}
+
+/* Broadcast word 'j' of packed lane values to all of 128-bit lane 'j' */
+static inline tvec v_lanes_bcast(const int16_t *p)
+{
+	const tvec mask = _mm512_set_epi32(
+		0x07060706, 0x07060706, 0x07060706, 0x07060706,
+		0x05040504, 0x05040504, 0x05040504, 0x05040504,
+		0x03020302, 0x03020302, 0x03020302, 0x03020302,
+		0x01000100, 0x01000100, 0x01000100, 0x01000100);
+
+	return _mm512_shuffle_epi8(_mm512_set1_epi64(*(const int64_t *) p),
+				   mask);
+}
+
+/* Store word 0 of each 128-bit lane as packed lane values */
+static inline void v_lanes_store0(int16_t *p, tvec v)
+{
+	const tvec idx = _mm512_set_epi16(0, 0, 0, 0, 0, 0, 0, 0,
+					  0, 0, 0, 0, 0, 0, 0, 0,
+					  0, 0, 0, 0, 0, 0, 0, 0,
+					  0, 0, 0, 0, 24, 16, 8, 0);
+
+	v = _mm512_permutexvar_epi16(idx, v);
+	_mm_storel_epi64((__m128i *) p, _mm512_castsi512_si128(v));
+}
+#elif TURBO_LANES == 2
+#define TURBO_VEC_ALIGN		32
+
+typedef __m256i tvec;
+
+#define V_LOAD(P)		_mm256_load_si256((const __m256i *) (P))
+#define V_STORE(P,V)		_mm256_store_si256((__m256i *) (P), V)
+#define V_ZERO()		_mm256_setzero_si256()
+#define V_SET16(V)		_mm256_set1_epi16(V)
+#define V_BCAST128(V)		_mm256_broadcastsi128_si256(V)
+#define V_ADDS(A,B)		_mm256_adds_epi16(A, B)
+#define V_SUBS(A,B)		_mm256_subs_epi16(A, B)
+#define V_SUB(A,B)		_mm256_sub_epi16(A, B)
+#define V_MAX(A,B)		_mm256_max_epi16(A, B)
+#define V_SRAI(A,N)		_mm256_srai_epi16(A, N)
+#define V_UNPACKLO(A,B)		_mm256_unpacklo_epi16(A, B)
+#define V_UNPACKHI(A,B)		_mm256_unpackhi_epi16(A, B)
+#define V_SHUFFLE8(A,M)		_mm256_shuffle_epi8(A, M)
+#define V_SHUFFLE32(A,I)	_mm256_shuffle_epi32(A, I)
+#define V_SHUFFLELO(A,I)	_mm256_shufflelo_epi16(A, I)
+#define V_SIGN(A,S)		_mm256_sign_epi16(A, S)
+
+static inline tvec v_lanes_bcast(const int16_t *p)
+{
+	const tvec mask = _mm256_set_epi32(
+		0x03020302, 0x03020302, 0x03020302, 0x03020302,
+		0x01000100, 0x01000100, 0x01000100, 0x01000100);
+
+	return _mm256_shuffle_epi8(_mm256_set1_epi32(*(const int32_t *) p),
+				   mask);
+}
+
+static inline void v_lanes_store0(int16_t *p, tvec v)
+{
+	p[0] = _mm256_extract_epi16(v, 0);
+	p[1] = _mm256_extract_epi16(v, 8);
+}
+#else
+#error "Unsupported number of turbo decoder lanes"
+#endif
+
+#define V_PATTERN16(...)	V_BCAST128(_mm_set_epi16(__VA_ARGS__))
+#define V_PATTERN8(...)		V_BCAST128(_mm_set_epi8(__VA_ARGS__))
+
+/* Word 0 of each lane broadcast across the lane */
+#define LANE_BCAST0_MASK	1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0
+
+/*
+ * Horizontal maximum within each lane, result in word 0 of the lane.
+ * Uses only in-lane shuffles since there is no wide minpos instruction.
+ */
+static inline tvec v_lanes_max(tvec m0)
+{
+	tvec m1, m2;
+
+	m1 = V_SHUFFLE32(m0, _MM_SHUFFLE(0, 0, 3, 2));
+	m2 = V_MAX(m0, m1);
+	m1 = V_SHUFFLELO(m2, _MM_SHUFFLE(0, 0, 3, 2));
+	m2 = V_MAX(m2, m1);
+	m1 = V_SHUFFLELO(m2, _MM_SHUFFLE(0, 0, 0, 1));
+
+	return V_MAX(m2, m1);
+}
+
+/* Forward recursion - see gen_fw_metrics() */
+static inline void gen_fw_metrics_lanes(int16_t *bm,
+					const int16_t *x, const int16_t *z,
+					const int16_t *sums_p, int16_t *sums_c,
+					const int16_t *le, int16_t *norm)
+{
+	tvec m0, m1, m2, m6, m7, m8, m9, m12, m13;
+
+	m0 = v_lanes_bcast(x);
+	m1 = v_lanes_bcast(z);
+	m2 = v_lanes_bcast(le);
+
+	/* Branch metrics */
+	m6 = V_SIGN(m0, V_PATTERN16(LTE_SYSTEM_FW_SHUFFLE));
+	m7 = V_SIGN(m1, V_PATTERN16(LTE_PARITY_FW_SHUFFLE));
+	m8 = V_SIGN(m2, V_PATTERN16(LTE_SYSTEM_FW_SHUFFLE));
+	m8 = V_SRAI(m8, 1);
+
+	m6 = V_ADDS(m6, m7);
+	m6 = V_ADDS(m6, m8);
+	m7 = V_SUBS(V_ZERO(), m6);
+
+	/* Pre-interleave for backward recursion */
+	m8 = V_UNPACKLO(m6, m7);
+	V_STORE(bm, m8);
+
+	/* Forward metrics */
+	m9  = V_LOAD(sums_p);
+	m12 = V_SHUFFLE8(m9, V_PATTERN8(FW_SHUFFLE_MASK0));
+	m13 = V_SHUFFLE8(m9, V_PATTERN8(FW_SHUFFLE_MASK1));
+	m12 = V_ADDS(m12, m6);
+	m13 = V_ADDS(m13, m7);
+
+	m0 = V_MAX(m12, m13);
+	m1 = V_SHUFFLE8(m0, V_PATTERN8(LANE_BCAST0_MASK));
+	m0 = V_SUBS(m0, m1);
+
+	V_STORE(sums_c, m0);
+	v_lanes_store0(norm, m1);
+}
+
+/* Backward recursion and L-value output - see gen_bw_metrics() */
+static inline void gen_bw_metrics_lanes(const int16_t *bm, const int16_t *z,
+					const int16_t *fw, int16_t *bw,
+					const int16_t *norm, int16_t *lval)
+{
+	tvec m0, m1, m3, m4, m5, m6, m9, m10, m11, m12, m13, m14, m15;
+
+	m0 = v_lanes_bcast(z);
+
+	/* Partial branch metrics */
+	m13 = V_SIGN(m0, V_PATTERN16(LTE_PARITY_BW_SHUFFLE));
+
+	/* Backward metrics */
+	m0 = V_LOAD(bw);
+	m1 = V_LOAD(bm);
+	m6 = V_LOAD(fw);
+	m3 = v_lanes_bcast(norm);
+
+	m4 = V_UNPACKLO(m0, m0);
+	m5 = V_UNPACKHI(m0, m0);
+	m4 = V_ADDS(m4, m1);
+	m5 = V_SUBS(m5, m1);
+
+	m1 = V_MAX(m4, m5);
+	m1 = V_SUBS(m1, m3);
+	V_STORE(bw, m1);
+
+	/* L-values */
+	m9  = V_SHUFFLE8(m0, V_PATTERN8(LV_BW_SHUFFLE_MASK0));
+	m10 = V_SHUFFLE8(m0, V_PATTERN8(LV_BW_SHUFFLE_MASK1));
+
+	m11 = V_ADDS(m6, m13);
+	m12 = V_SUBS(m6, m13);
+	m11 = V_ADDS(m11, m9);
+	m12 = V_ADDS(m12, m10);
+
+	/* Maximums */
+	m14 = v_lanes_max(m11);
+	m15 = v_lanes_max(m12);
+	m13 = V_SUB(m15, m14);
+
+	v_lanes_store0(lval, m13);
+}
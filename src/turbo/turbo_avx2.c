@@ -0,0 +1,29 @@
+/*
+ * LTE Max-Log-MAP turbo decoder - AVX2 multi-block kernel
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Built for AVX2 regardless of the native target and selected at runtime */
+#ifdef HAVE_SSE3
+#pragma GCC target("avx2")
+
+#define TURBO_LANES		2
+#define TURBO_LANES_NAME	"avx2"
+#define TURBO_LANES_OPS		turbo_lanes_avx2
+
+#include "turbo_lanes.h"
+#endif
@@ -0,0 +1,257 @@
+/*
+ * LTE turbo decoder benchmark
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "turbo.h"
+
+#define DEF_ITER	4
+#define DEF_REPS	100
+#define SIGNAL		20
+#define NOISE		30
+#define DEF_BATCH	8
+
+/*
+ * Measures decoder cycles per full iteration for each code block size,
+ * with separate QPP permutation passes and with permutation fused into
+ * the backward recursion. Throughput mode instead reports decoded Mbit/s
+ * for blocks decoded one at a time and for batches of equal length blocks
+ * across the SIMD lanes.
+ */
+struct bench_block {
+	int K;
+	uint8_t d[3][TURBO_MAX_K + 4];
+	int8_t soft[3][TURBO_MAX_K + 4];
+	int8_t work[3][TURBO_MAX_K + 4];
+	uint8_t out[TURBO_MAX_K / 8];
+};
+
+/* 3GPP TS 36.212 Release 8: Table 5.1.3-3 block sizes */
+static int next_k(int k)
+{
+	if (k < 512)
+		return k + 8;
+	if (k < 1024)
+		return k + 16;
+	if (k < 2048)
+		return k + 32;
+
+	return k + 64;
+}
+
+static void gen_block(struct bench_block *blk, int K)
+{
+	int i, n;
+	uint8_t in[TURBO_MAX_K];
+	struct lte_turbo_code code = {
+		.n = 2,
+		.k = 4,
+		.len = K,
+		.rgen = 013,
+		.gen = 015,
+	};
+
+	blk->K = K;
+
+	for (i = 0; i < K; i++)
+		in[i] = rand() & 0x01;
+
+	lte_turbo_encode(&code, in, blk->d[0], blk->d[1], blk->d[2]);
+
+	for (n = 0; n < 3; n++) {
+		for (i = 0; i < K + 4; i++) {
+			blk->soft[n][i] = (blk->d[n][i] ? SIGNAL : -SIGNAL) +
+					  rand() % (2 * NOISE + 1) - NOISE;
+		}
+	}
+}
+
+static double run(struct tdecoder *dec, struct bench_block *blk,
+		  int iter, int reps)
+{
+	int i;
+	uint64_t cycles = 0, t;
+
+	for (i = 0; i < reps; i++) {
+		memcpy(blk->work, blk->soft, sizeof(blk->soft));
+
+		t = __rdtsc();
+		lte_turbo_decode(dec, blk->K, iter, blk->out, blk->work[0],
+				 blk->work[1], blk->work[2]);
+		cycles += __rdtsc() - t;
+	}
+
+	return (double) cycles / ((double) reps * iter);
+}
+
+static double now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Decoded Mbit/s of 'n' blocks, batched or one at a time */
+static double run_throughput(struct tdecoder *dec, struct bench_block *blks,
+			     int n, int batch, int iter, int reps)
+{
+	int i, j, len[n], iters[n];
+	uint8_t *out[n];
+	const int8_t *d0[n], *d1[n], *d2[n];
+	double t, elapsed = 0.0;
+
+	for (j = 0; j < n; j++) {
+		len[j] = blks[j].K;
+		out[j] = blks[j].out;
+		d0[j] = blks[j].work[0];
+		d1[j] = blks[j].work[1];
+		d2[j] = blks[j].work[2];
+	}
+
+	for (i = 0; i < reps; i++) {
+		for (j = 0; j < n; j++)
+			memcpy(blks[j].work, blks[j].soft,
+			       sizeof(blks[j].soft));
+
+		t = now();
+		if (batch) {
+			lte_turbo_decode_batch(dec, n, len, iter, out,
+					       d0, d1, d2, NULL, iters);
+		} else {
+			for (j = 0; j < n; j++)
+				lte_turbo_decode(dec, len[j], iter, out[j],
+						 d0[j], d1[j], d2[j]);
+		}
+		elapsed += now() - t;
+	}
+
+	return (double) n * blks[0].K * reps / elapsed / 1e6;
+}
+
+static void print_help()
+{
+	fprintf(stdout, "\nOptions:\n"
+		"  -h    This text\n"
+		"  -k    Code block size (default = all)\n"
+		"  -i    Turbo iterations (default = %i)\n"
+		"  -n    Decodes per measurement (default = %i)\n"
+		"  -w    Sliding window length (default = off)\n"
+		"  -t    Throughput mode, code blocks per batch (e.g. %i)\n\n",
+		DEF_ITER, DEF_REPS, DEF_BATCH);
+}
+
+int main(int argc, char **argv)
+{
+	int K = 0, iter = DEF_ITER, reps = DEF_REPS, window = 0, batch = 0;
+	int option, k, i;
+	double separate, fused;
+	struct tdecoder *dec;
+	struct bench_block *blk;
+
+	while ((option = getopt(argc, argv, "hk:i:n:w:t:")) != -1) {
+		switch (option) {
+		case 'k':
+			K = atoi(optarg);
+			break;
+		case 'i':
+			iter = atoi(optarg);
+			break;
+		case 'n':
+			reps = atoi(optarg);
+			break;
+		case 'w':
+			window = atoi(optarg);
+			break;
+		case 't':
+			batch = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			print_help();
+			return 0;
+		}
+	}
+
+	if ((iter < 1) || (reps < 1) || (batch < 0)) {
+		print_help();
+		return 1;
+	}
+
+	dec = alloc_tdec();
+	blk = (struct bench_block *) malloc((batch ? batch : 1) * sizeof(*blk));
+
+	if (window && lte_turbo_set_window(dec, window, TURBO_DEF_TRAIN)) {
+		fprintf(stderr, "Invalid window length %i\n", window);
+		return 1;
+	}
+
+	if (batch) {
+		fprintf(stdout, "%i lanes, %i blocks per batch, "
+			"%i iterations\n", lte_turbo_lanes(), batch, iter);
+		fprintf(stdout, "%6s %14s %14s %8s\n",
+			"K", "single Mb/s", "batch Mb/s", "speedup");
+	} else {
+		fprintf(stdout, "%6s %14s %14s %8s\n",
+			"K", "separate c/it", "fused c/it", "speedup");
+	}
+
+	for (k = TURBO_MIN_K; k <= TURBO_MAX_K; k = next_k(k)) {
+		if (K && (k != K))
+			continue;
+
+		if (batch) {
+			double single, batched;
+
+			for (i = 0; i < batch; i++)
+				gen_block(&blk[i], k);
+
+			single = run_throughput(dec, blk, batch, 0,
+						iter, reps);
+			batched = run_throughput(dec, blk, batch, 1,
+						 iter, reps);
+
+			fprintf(stdout, "%6i %14.1f %14.1f %7.2fx\n",
+				k, single, batched, batched / single);
+			continue;
+		}
+
+		gen_block(blk, k);
+
+		lte_turbo_set_fused(dec, 0);
+		separate = run(dec, blk, iter, reps);
+
+		lte_turbo_set_fused(dec, 1);
+		fused = run(dec, blk, iter, reps);
+
+		fprintf(stdout, "%6i %14.0f %14.0f %7.2fx\n",
+			k, separate, fused, separate / fused);
+	}
+
+	free(blk);
+	free_tdec(dec);
+
+	return 0;
+}
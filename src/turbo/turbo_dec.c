@@ -26,37 +26,12 @@
 #include <math.h>
 #include "turbo.h"
 #include "turbo_int.h"
+#include "turbo_trellis.h"
 #include "turbo_sse.h"
 
 #define SSE_ALIGN		__attribute__((aligned(16)))
 #define API_EXPORT		__attribute__((__visibility__("default")))
 
-#define NUM_TRELLIS_STATES	8
-#define MAX_TRELLIS_LEN		(TURBO_MAX_K + 3)
-
-/* Initialization value for forward and backward sums */
-#define SUM_INIT		16000
-
-struct tmetric {
-	int16_t bm[NUM_TRELLIS_STATES];
-	int16_t fwsums[NUM_TRELLIS_STATES];
-};
-
-/*
- * Trellis Object
- *
- * sums       - Accumulated path metrics
- * outputs    - Trellis ouput values
- * metrics    - Path metrics
- * vals       - Input value that led to each state
- */
-struct vtrellis {
-	struct tmetric *tm;
-	int16_t *bwsums;
-	int16_t *fwnorm;
-	int16_t lvals[MAX_TRELLIS_LEN];
-};
-
 /*
  * Turbo Decoder
  *
@@ -67,23 +42,69 @@ struct vtrellis {
  * punc      - Puncturing sequence
  * paths     - Trellis paths
  */
+
+/*
+ * Decoder object
+ *
+ * window - Sliding window length in trellis steps, zero for full block
+ * train  - Training steps used to estimate metrics at window edges
+ * fused  - Scatter extrinsic values to (de)interleaved positions in the
+ *          backward pass instead of separate permutation passes
+ * le     - Extrinsic inputs held while windows overwrite the L-values
+ * simd   - Multi-block kernel for this CPU, NULL if unsupported
+ * lanes  - Multi-block kernel state, allocated on first use
+ */
 struct tdecoder {
 	int len;
+	int window;
+	int train;
+	int fused;
 	struct vtrellis trellis[2];
+	const struct turbo_lanes *simd;
+	void *lanes;
+	uint8_t hard[TURBO_MAX_K / 8];
 
 	SSE_ALIGN int16_t bwsums[8];
 	SSE_ALIGN struct tmetric tm[MAX_TRELLIS_LEN + 1];
 	int16_t fwnorm[MAX_TRELLIS_LEN];
+	int16_t le[MAX_TRELLIS_LEN];
 };
 
+/* Widest multi-block kernel supported by the running CPU */
+static const struct turbo_lanes *turbo_lanes_select()
+{
+#ifdef HAVE_SSE3
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f") &&
+	    __builtin_cpu_supports("avx512bw"))
+		return &turbo_lanes_avx512;
+	if (__builtin_cpu_supports("avx2"))
+		return &turbo_lanes_avx2;
+#endif
+	return NULL;
+}
+
+/* Multi-block kernel state or NULL to decode blocks one at a time */
+static void *turbo_lanes_state(struct tdecoder *dec)
+{
+	if (dec->simd && !dec->lanes)
+		dec->lanes = dec->simd->alloc();
+
+	return dec->lanes;
+}
+
 /* Allocate and initialize the trellis object */
 static int generate_trellis(struct vtrellis *trellis,
 			    struct tmetric *tm,
-			    int16_t *bwsums, int16_t *fwnorm)
+			    int16_t *bwsums, int16_t *fwnorm,
+			    int16_t *ext)
 {
 	trellis->tm = tm;
 	trellis->bwsums = bwsums;
 	trellis->fwnorm = fwnorm;
+	trellis->map = NULL;
+	trellis->ext = ext;
 
 	return 0;
 }
@@ -93,6 +114,9 @@ static int generate_trellis(struct vtrellis *trellis,
  */
 static void init_tdec(struct tdecoder *dec, int len)
 {
+	memset(dec->tm[0].fwsums, 0, 8 * sizeof(int16_t));
+	dec->tm[0].fwsums[0] = SUM_INIT;
+
 	memset(dec->trellis[0].lvals, 0, len * sizeof(int16_t));
 	memset(dec->trellis[1].lvals, 0, len * sizeof(int16_t));
 
@@ -105,6 +129,7 @@ API_EXPORT void free_tdec(struct tdecoder *dec)
 	if (!dec)
 		return;
 
+	free(dec->lanes);
 	free(dec);
 }
 
@@ -123,18 +148,20 @@ API_EXPORT struct tdecoder *alloc_tdec()
 
 	dec = (struct tdecoder *) malloc(sizeof(struct tdecoder));
 	dec->len = 0;
+	dec->window = 0;
+	dec->train = 0;
+	dec->fused = 1;
+	dec->simd = turbo_lanes_select();
+	dec->lanes = NULL;
 
-	generate_trellis(&dec->trellis[0], dec->tm,
-			 dec->bwsums, dec->fwnorm);
+	generate_trellis(&dec->trellis[0], dec->tm, dec->bwsums,
+			 dec->fwnorm, dec->trellis[1].lvals);
 
-	generate_trellis(&dec->trellis[1], dec->tm,
-			 dec->bwsums, dec->fwnorm);
+	generate_trellis(&dec->trellis[1], dec->tm, dec->bwsums,
+			 dec->fwnorm, dec->trellis[0].lvals);
 
-	memset(dec->tm[0].fwsums, 0, 8 * sizeof(int16_t));
 	memset(dec->bwsums, 0, 8 * sizeof(int16_t));
 
-	dec->tm[0].fwsums[0] = SUM_INIT;
-
 	return dec;
 }
 
@@ -157,42 +184,130 @@ static int turbo_iterate(struct vtrellis *trellis, int len,
 	}
 
 	/* Backward */
-	for (i = len - 1; i >= 0; i--) {
-		trellis->lvals[i] = gen_bw_metrics(tm[i].bm,
-						   z[i],
+	if (!trellis->map) {
+		for (i = len - 1; i >= 0; i--) {
+			trellis->lvals[i] = gen_bw_metrics(tm[i].bm,
+							   z[i],
+							   tm[i].fwsums,
+							   trellis->bwsums,
+							   trellis->fwnorm[i]);
+		}
+
+		return 0;
+	}
+
+	/* Backward with extrinsic values scattered to the other decoder */
+	for (i = len - 1; i >= len - TERM_LEN; i--) {
+		trellis->lvals[i] = gen_bw_metrics(tm[i].bm, z[i],
 						   tm[i].fwsums,
 						   trellis->bwsums,
 						   trellis->fwnorm[i]);
 	}
 
+	for (; i >= 0; i--) {
+		trellis->ext[trellis->map[i]] = gen_bw_metrics(tm[i].bm, z[i],
+							       tm[i].fwsums,
+							       trellis->bwsums,
+							       trellis->fwnorm[i]);
+	}
+
 	return 0;
 }
 
-static inline void _turbo_decode(struct tdecoder *dec,
-				 int len, int iter, uint8_t *output,
-				 const int8_t *d0, const int8_t *d1,
-				 const int8_t *d2)
+/*
+ * Sliding window recursions
+ *
+ * The block is split into windows that are decoded independently and
+ * only one window of trellis metrics is stored. Forward metrics at the
+ * start and backward metrics at the end of each window are estimated by
+ * running the recursions over 'train' steps of the neighbouring windows,
+ * starting from equiprobable states, or from the terminated state where
+ * training reaches a block boundary. Extrinsic inputs are read from a
+ * copy so that windows do not see L-values already updated by others.
+ */
+static void turbo_window(struct vtrellis *trellis, const int16_t *le,
+			 int len, int s, int w, int train,
+			 const int8_t *x, const int8_t *z)
 {
-	int i;
-	int8_t d0p[len + 3];
-	struct vtrellis *trellis = dec->trellis;
+	int i, t;
+	struct tmetric *tm = trellis->tm;
+	int16_t *bw = trellis->bwsums;
+	SSE_ALIGN int16_t bm[NUM_TRELLIS_STATES];
+	SSE_ALIGN int16_t sums[2][NUM_TRELLIS_STATES];
 
-	turbo_interleave(len, (uint8_t *) d0, (uint8_t *) d0p);
-	turbo_unterm(len, (uint8_t *) d0, (uint8_t *) d1,
-		     (uint8_t *) d2, (uint8_t *) d0p);
+	/* Forward training */
+	memset(sums[0], 0, sizeof(sums[0]));
 
-	init_tdec(dec, len + 3);
+	t = s - train;
+	if (t <= 0) {
+		t = 0;
+		sums[0][0] = SUM_INIT;
+	}
 
-	for (i = 0; i < iter; i++) {
-		turbo_iterate(&trellis[0], dec->len, d0, d1);
-		turbo_interleave_lval(len,
-				      trellis[0].lvals,
-				      trellis[1].lvals);
-
-		turbo_iterate(&trellis[1], dec->len, d0p, d2);
-		turbo_deinterleave_lval(len,
-					trellis[1].lvals,
-					trellis[0].lvals);
+	for (i = t; i < s; i++) {
+		gen_fw_metrics(bm, x[i], z[i], sums[(i - t) & 1],
+			       sums[(i - t + 1) & 1], le[i]);
+	}
+
+	memcpy(tm[0].fwsums, sums[(s - t) & 1], sizeof(sums[0]));
+
+	/* Forward */
+	for (i = 0; i < w; i++) {
+		trellis->fwnorm[i] = gen_fw_metrics(tm[i].bm,
+						    x[s + i], z[s + i],
+						    tm[i].fwsums,
+						    tm[i + 1].fwsums,
+						    le[s + i]);
+	}
+
+	/* Backward training, branch metrics from a throwaway forward step */
+	memset(bw, 0, NUM_TRELLIS_STATES * sizeof(int16_t));
+	memset(sums[0], 0, sizeof(sums[0]));
+
+	t = s + w + train;
+	if (t >= len) {
+		t = len;
+		bw[0] = SUM_INIT;
+	}
+
+	for (i = t - 1; i >= s + w; i--) {
+		gen_fw_metrics(bm, x[i], z[i], sums[0], sums[1], le[i]);
+		gen_bw_metrics(bm, z[i], sums[0], bw, bw[0]);
+	}
+
+	/* Backward */
+	for (i = w - 1; i >= 0; i--) {
+		put_lval(trellis, len, s + i,
+			 gen_bw_metrics(tm[i].bm, z[s + i], tm[i].fwsums,
+					bw, trellis->fwnorm[i]));
+	}
+}
+
+/*
+ * With fused interleaving only termination steps are written in place
+ * and those belong to the final window, so extrinsic inputs need not be
+ * copied.
+ */
+static void turbo_iterate_window(struct tdecoder *dec,
+				 struct vtrellis *trellis, int len,
+				 const int8_t *x, const int8_t *z)
+{
+	const int16_t *le = trellis->lvals;
+
+	if (!trellis->map) {
+		memcpy(dec->le, trellis->lvals, len * sizeof(int16_t));
+		le = dec->le;
+	}
+
+	if (turbo_lanes_state(dec)) {
+		dec->simd->window(dec->lanes, trellis, len,
+				  dec->window, dec->train, x, z, le);
+		return;
+	}
+
+	for (int s = 0; s < len; s += dec->window) {
+		turbo_window(trellis, le, len, s,
+			     MIN(dec->window, len - s), dec->train, x, z);
 	}
 }
 
@@ -224,24 +339,115 @@ static inline void _turbo_decode(struct tdecoder *dec,
 #define SLICE_PACK	SLICE_PACK_BE
 #endif
 
+static void pack_bits(const int16_t *lvals, int len, uint8_t *output)
+{
+	for (int i = 0; i < len / 8; i++)
+		output[i] = SLICE_PACK(lvals, 8 * i);
+}
+
+/*
+ * Early termination check after a full iteration. Hard decisions are
+ * packed into the output buffer for the CRC callback and compared with
+ * the previous iteration for the stability test.
+ */
+static int turbo_converged(struct tdecoder *dec, int len, int i,
+			   uint8_t *output, const struct lte_turbo_stop *stop)
+{
+	pack_bits(dec->trellis[0].lvals, len, output);
+
+	if (stop->crc && stop->crc(stop->arg, output, len))
+		return 1;
+
+	if (stop->stable) {
+		if (i && !memcmp(dec->hard, output, len / 8))
+			return 1;
+		memcpy(dec->hard, output, len / 8);
+	}
+
+	return 0;
+}
+
+/* Returns the number of iterations run */
+static inline int _turbo_decode(struct tdecoder *dec,
+				int len, int iter, uint8_t *output,
+				const int8_t *d0, const int8_t *d1,
+				const int8_t *d2,
+				const struct lte_turbo_stop *stop)
+{
+	int i;
+	int8_t d0p[len + 3];
+	struct vtrellis *trellis = dec->trellis;
+
+	turbo_interleave(len, (uint8_t *) d0, (uint8_t *) d0p);
+	turbo_unterm(len, (uint8_t *) d0, (uint8_t *) d1,
+		     (uint8_t *) d2, (uint8_t *) d0p);
+
+	init_tdec(dec, len + 3);
+
+	trellis[0].map = dec->fused ? turbo_interleave_map(len) : NULL;
+	trellis[1].map = dec->fused ? turbo_deinterleave_map(len) : NULL;
+
+	for (i = 0; i < iter; i++) {
+		if (dec->window)
+			turbo_iterate_window(dec, &trellis[0], dec->len,
+					     d0, d1);
+		else
+			turbo_iterate(&trellis[0], dec->len, d0, d1);
+		if (!trellis[0].map) {
+			turbo_interleave_lval(len,
+					      trellis[0].lvals,
+					      trellis[1].lvals);
+		}
+
+		if (dec->window)
+			turbo_iterate_window(dec, &trellis[1], dec->len,
+					     d0p, d2);
+		else
+			turbo_iterate(&trellis[1], dec->len, d0p, d2);
+		if (!trellis[1].map) {
+			turbo_deinterleave_lval(len,
+						trellis[1].lvals,
+						trellis[0].lvals);
+		}
+
+		if (stop && turbo_converged(dec, len, i, output, stop))
+			return i + 1;
+	}
+
+	return iter;
+}
+
 API_EXPORT
 int lte_turbo_decode(struct tdecoder *dec,
 		     int len, int iter, uint8_t *output,
 		     const int8_t *d0, const int8_t *d1, const int8_t *d2)
 {
-	int i;
-
 	if ((len < TURBO_MIN_K) || len > TURBO_MAX_K)
 		return -EINVAL;
 
-	_turbo_decode(dec, len, iter, output, d0, d1, d2);
-
-	for (i = 0; i < len / 8; i++)
-		output[i] = SLICE_PACK(dec->trellis[0].lvals, 8 * i);
+	_turbo_decode(dec, len, iter, output, d0, d1, d2, NULL);
+	pack_bits(dec->trellis[0].lvals, len, output);
 
 	return 0;
 }
 
+API_EXPORT
+int lte_turbo_decode_stop(struct tdecoder *dec,
+			  int len, int max_iter, uint8_t *output,
+			  const int8_t *d0, const int8_t *d1, const int8_t *d2,
+			  const struct lte_turbo_stop *stop)
+{
+	int iter;
+
+	if ((len < TURBO_MIN_K) || len > TURBO_MAX_K)
+		return -EINVAL;
+
+	iter = _turbo_decode(dec, len, max_iter, output, d0, d1, d2, stop);
+	pack_bits(dec->trellis[0].lvals, len, output);
+
+	return iter;
+}
+
 API_EXPORT
 int lte_turbo_decode_unpack(struct tdecoder *dec,
 			   int len, int iter, uint8_t *output,
@@ -252,10 +458,147 @@ int lte_turbo_decode_unpack(struct tdecoder *dec,
 	if ((len < TURBO_MIN_K) || len > TURBO_MAX_K)
 		return -EINVAL;
 
-	_turbo_decode(dec, len, iter, output, d0, d1, d2);
+	_turbo_decode(dec, len, iter, output, d0, d1, d2, NULL);
 
 	for (i = 0; i < len; i++)
 		output[i] = dec->trellis[0].lvals[i] > 0 ? 1 : 0;
 
 	return 0;
 }
+
+API_EXPORT
+int lte_turbo_check_window(int window, int train)
+{
+	if (!window)
+		return 0;
+
+	if ((window < TURBO_MIN_WINDOW) || (train < 0) || (train > window) ||
+	    (window + 2 * train > TURBO_MAX_WINDOW))
+		return -EINVAL;
+
+	return 0;
+}
+
+API_EXPORT
+int lte_turbo_set_window(struct tdecoder *dec, int window, int train)
+{
+	if (!window) {
+		dec->window = 0;
+		return 0;
+	}
+
+	if (lte_turbo_check_window(window, train))
+		return -EINVAL;
+
+	dec->window = window;
+	dec->train = train;
+
+	return 0;
+}
+
+API_EXPORT
+void lte_turbo_set_fused(struct tdecoder *dec, int fused)
+{
+	dec->fused = fused;
+}
+
+API_EXPORT
+int lte_turbo_lanes()
+{
+	const struct turbo_lanes *simd = turbo_lanes_select();
+
+	return simd ? simd->lanes : 1;
+}
+
+/*
+ * Decode up to lte_turbo_lanes() equal length code blocks with one pass
+ * of the wide kernel. Without AVX2 blocks are decoded one at a time.
+ */
+API_EXPORT
+int lte_turbo_decode_lanes(struct tdecoder *dec, int len, int iter, int n,
+			   uint8_t **output, const int8_t **d0,
+			   const int8_t **d1, const int8_t **d2)
+{
+	if ((len < TURBO_MIN_K) || len > TURBO_MAX_K)
+		return -EINVAL;
+	if ((n < 1) || (n > (dec->simd ? dec->simd->lanes : 1)))
+		return -EINVAL;
+
+	if (n > 1) {
+		int idx[TURBO_MAX_LANES], iters[TURBO_MAX_LANES];
+
+		if (!turbo_lanes_state(dec))
+			return -ENOMEM;
+
+		for (int j = 0; j < n; j++)
+			idx[j] = j;
+
+		dec->simd->decode(dec->lanes, dec->fused, len, iter, n, idx,
+				  output, d0, d1, d2, NULL, iters);
+		return 0;
+	}
+
+	for (int j = 0; j < n; j++)
+		lte_turbo_decode(dec, len, iter, output[j], d0[j], d1[j], d2[j]);
+
+	return 0;
+}
+
+/*
+ * Blocks are grouped by length in order of first appearance. Groups of
+ * two or more blocks are scheduled across the lanes and lone blocks use
+ * the single block decoder. With a sliding window set, all blocks use the
+ * windowed single block decoder since the lanes kernel stores full block
+ * metrics for every lane.
+ */
+API_EXPORT
+int lte_turbo_decode_batch(struct tdecoder *dec, int n, const int *len,
+			   int max_iter, uint8_t **output, const int8_t **d0,
+			   const int8_t **d1, const int8_t **d2,
+			   const struct lte_turbo_stop *stop, int *iters)
+{
+	int i, k, m;
+	int idx[n], done[n];
+
+	if ((n < 1) || (max_iter < 1))
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		if ((len[i] < TURBO_MIN_K) || len[i] > TURBO_MAX_K)
+			return -EINVAL;
+		done[i] = 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (done[i])
+			continue;
+
+		for (k = i, m = 0; k < n; k++) {
+			if (!done[k] && (len[k] == len[i])) {
+				idx[m++] = k;
+				done[k] = 1;
+			}
+		}
+
+		if ((m > 1) && !dec->window && dec->simd) {
+			if (!turbo_lanes_state(dec))
+				return -ENOMEM;
+
+			dec->simd->decode(dec->lanes, dec->fused,
+					  len[i], max_iter, m,
+					  idx, output, d0, d1, d2,
+					  stop, iters);
+			continue;
+		}
+
+		for (k = 0; k < m; k++) {
+			int b = idx[k];
+
+			iters[b] = lte_turbo_decode_stop(dec, len[b], max_iter,
+							 output[b], d0[b],
+							 d1[b], d2[b], stop);
+		}
+	}
+
+	return 0;
+}
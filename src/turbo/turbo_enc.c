@@ -42,6 +42,7 @@ struct lte_interlv_param {
 
 /* Plus one to accommodate indexing from 1 instead of 0 */
 static int *lte_deinterlv_map[MAX_I];
+static int *lte_interlv_map[MAX_I];
 
 /*
  * 3GPP TS 36.212 Release 8
@@ -202,6 +203,28 @@ int turbo_interleave_lval(int k, const int16_t *in, int16_t *out)
 	return 0;
 }
 
+const int *turbo_interleave_map(int k)
+{
+	struct lte_interlv_param *param;
+
+	param = lte_interlv_find_param(k);
+	if (!param)
+		return NULL;
+
+	return lte_interlv_map[param->i];
+}
+
+const int *turbo_deinterleave_map(int k)
+{
+	struct lte_interlv_param *param;
+
+	param = lte_interlv_find_param(k);
+	if (!param)
+		return NULL;
+
+	return lte_deinterlv_map[param->i];
+}
+
 int turbo_deinterleave(int k, const int8_t *in, int8_t *out)
 {
 	int n;
@@ -244,6 +267,72 @@ int turbo_deinterleave_lval(int k, const int16_t *in, int16_t *out)
 	return 0;
 }
 
+/*
+ * Permute whole lane groups so that all blocks share one pass over the
+ * interleaver map. Lane values are moved as single 32 or 64-bit words.
+ */
+int turbo_interleave_lval_lanes(int k, int lanes,
+				const int16_t *in, int16_t *out)
+{
+	int n;
+	struct lte_interlv_param *param;
+
+	if ((k < TURBO_MIN_K) || (k > TURBO_MAX_K))
+		return -EINVAL;
+
+	param = lte_interlv_find_param(k);
+	if (!param)
+		return -EINVAL;
+
+	const int *map = lte_deinterlv_map[param->i];
+
+	switch (lanes) {
+	case 2:
+		for (n = 0; n < k; n++)
+			((uint32_t *) out)[n] = ((const uint32_t *) in)[map[n]];
+		break;
+	case 4:
+		for (n = 0; n < k; n++)
+			((uint64_t *) out)[n] = ((const uint64_t *) in)[map[n]];
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int turbo_deinterleave_lval_lanes(int k, int lanes,
+				  const int16_t *in, int16_t *out)
+{
+	int n;
+	struct lte_interlv_param *param;
+
+	if ((k < TURBO_MIN_K) || (k > TURBO_MAX_K))
+		return -EINVAL;
+
+	param = lte_interlv_find_param(k);
+	if (!param)
+		return -EINVAL;
+
+	const int *map = lte_deinterlv_map[param->i];
+
+	switch (lanes) {
+	case 2:
+		for (n = 0; n < k; n++)
+			((uint32_t *) out)[map[n]] = ((const uint32_t *) in)[n];
+		break;
+	case 4:
+		for (n = 0; n < k; n++)
+			((uint64_t *) out)[map[n]] = ((const uint64_t *) in)[n];
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int encode_n2(const struct lte_turbo_code *code,
 		     const uint8_t *c, uint8_t *x, uint8_t *z)
 {
@@ -381,20 +470,38 @@ static void gen_deinterlv_map(int i)
 	}
 }
 
+/* Inverse permutation for scattering values to interleaved positions */
+static void gen_interlv_map(int i)
+{
+	int n, k;
+
+	k = lte_interlv_params[i].k;
+
+	lte_interlv_map[i] = (int *) malloc(k * sizeof(int));
+
+	for (n = 0; n < k; n++)
+		lte_interlv_map[i][lte_deinterlv_map[i][n]] = n;
+}
+
 __attribute__((constructor)) static void init()
 {
 	int i;
 
 	lte_deinterlv_map[0]= NULL;
+	lte_interlv_map[0]= NULL;
 
-	for (i = 1; i < MAX_I; i++)
+	for (i = 1; i < MAX_I; i++) {
 		gen_deinterlv_map(i);
+		gen_interlv_map(i);
+	}
 }
 
 __attribute__((destructor)) static void release()
 {
 	int i;
 
-	for (i = 1; i < MAX_I; i++)
+	for (i = 1; i < MAX_I; i++) {
 		free(lte_deinterlv_map[i]);
+		free(lte_interlv_map[i]);
+	}
 }
@@ -11,4 +11,17 @@ void turbo_unterm(int len, uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d0p);
 int turbo_interleave_lval(int k, const int16_t *in, int16_t *out);
 int turbo_deinterleave_lval(int k, const int16_t *in, int16_t *out);
 
+/*
+ * Scatter maps for writing values directly to their (de)interleaved
+ * positions, out[map[n]] = in[n]. NULL for invalid lengths.
+ */
+const int *turbo_interleave_map(int k);
+const int *turbo_deinterleave_map(int k);
+
+/* Lane interleaved L-values from 2 or 4 equal length blocks */
+int turbo_interleave_lval_lanes(int k, int lanes,
+				const int16_t *in, int16_t *out);
+int turbo_deinterleave_lval_lanes(int k, int lanes,
+				  const int16_t *in, int16_t *out);
+
 #endif /* _TURBO_INTERLEAVE_ */
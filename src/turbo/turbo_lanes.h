@@ -0,0 +1,416 @@
+/*
+ * LTE Max-Log-MAP turbo decoder - multi-block kernel
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Included once per instruction set by turbo_avx2.c and turbo_avx512.c,
+ * which set the compile target and define TURBO_LANES and the name of the
+ * exported kernel object, TURBO_LANES_OPS.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "turbo_trellis.h"
+#include "turbo_int.h"
+#include "turbo_sse.h"
+#include "turbo_avx.h"
+
+#define LANES_ALIGN		__attribute__((aligned(TURBO_VEC_ALIGN)))
+#define LANES_LEN		(MAX_TRELLIS_LEN * TURBO_LANES)
+#define LANES_STATES		(NUM_TRELLIS_STATES * TURBO_LANES)
+
+struct tmetric_lanes {
+	int16_t bm[LANES_STATES];
+	int16_t fwsums[LANES_STATES];
+} LANES_ALIGN;
+
+/*
+ * Multi-block trellis state
+ *
+ * Same layout as the single block decoder with each trellis step holding
+ * one 8 state vector per lane. Scalar per-step values are stored lane
+ * interleaved. Systematic and parity inputs are widened to 16-bits once
+ * per decode.
+ */
+struct tdecoder_lanes {
+	struct tmetric_lanes tm[MAX_TRELLIS_LEN + 1];
+	LANES_ALIGN int16_t bwsums[LANES_STATES];
+	int16_t fwnorm[LANES_LEN];
+	int16_t lvals[2][LANES_LEN];
+	int16_t x[2][LANES_LEN];
+	int16_t z[2][LANES_LEN];
+	LANES_ALIGN int16_t scratch[3][LANES_STATES];
+	uint8_t hard[TURBO_LANES][TURBO_MAX_K / 8];
+};
+
+static void *alloc_tdec_lanes(void)
+{
+	struct tdecoder_lanes *t;
+
+	if (posix_memalign((void **) &t, TURBO_VEC_ALIGN, sizeof(*t)))
+		return NULL;
+
+	memset(t->bwsums, 0, sizeof(t->bwsums));
+
+	return t;
+}
+
+/* Widen one lane of window inputs starting at block position 'p' */
+static void gather_window(struct tdecoder_lanes *t, int lane, int p,
+			  int span, int len, const int8_t *x,
+			  const int8_t *z, const int16_t *le)
+{
+	int i, lo = MIN(span, p < 0 ? -p : 0), hi = MIN(span, len - p);
+
+	for (i = 0; i < lo; i++) {
+		t->x[0][TURBO_LANES * i + lane] = 0;
+		t->z[0][TURBO_LANES * i + lane] = 0;
+		t->lvals[0][TURBO_LANES * i + lane] = 0;
+	}
+
+	for (; i < hi; i++) {
+		t->x[0][TURBO_LANES * i + lane] = x[p + i];
+		t->z[0][TURBO_LANES * i + lane] = z[p + i];
+		t->lvals[0][TURBO_LANES * i + lane] = le[p + i];
+	}
+
+	for (; i < span; i++) {
+		t->x[0][TURBO_LANES * i + lane] = 0;
+		t->z[0][TURBO_LANES * i + lane] = 0;
+		t->lvals[0][TURBO_LANES * i + lane] = 0;
+	}
+}
+
+/*
+ * Sliding window recursions with one window per SIMD lane
+ *
+ * All lanes run the same number of steps, so the final window is shifted
+ * back to end on the block boundary and its steps overlapping the previous
+ * window are dropped. Training steps beyond the block are zero padded,
+ * which leaves equiprobable states unchanged, and lanes are reset to the
+ * terminated state where training or the window reaches a block boundary.
+ */
+static void lane_init_sums(int16_t *sums, int lane)
+{
+	memset(&sums[NUM_TRELLIS_STATES * lane], 0,
+	       NUM_TRELLIS_STATES * sizeof(int16_t));
+	sums[NUM_TRELLIS_STATES * lane] = SUM_INIT;
+}
+
+static void turbo_iterate_window_lanes(void *state,
+				       struct vtrellis *trellis, int len,
+				       int window, int train,
+				       const int8_t *x, const int8_t *z,
+				       const int16_t *le)
+{
+	struct tdecoder_lanes *t = state;
+	int i, j, k, n, p, w, span;
+	int s[TURBO_LANES];
+	struct tmetric_lanes *tm = t->tm;
+	int16_t *xw = t->x[0], *zw = t->z[0];
+	int16_t *lw = t->lvals[0], *out = t->lvals[1];
+	int16_t *bm = t->scratch[0];
+	int16_t *sums[2] = { t->scratch[1], t->scratch[2] };
+	int16_t norm[TURBO_LANES] __attribute__((aligned(8)));
+
+	w = MIN(window, len);
+	n = (len + w - 1) / w;
+	span = w + 2 * train;
+
+	for (k = 0; k < n; k += TURBO_LANES) {
+		for (j = 0; j < TURBO_LANES; j++) {
+			s[j] = MIN(MIN(k + j, n - 1) * w, len - w);
+			gather_window(t, j, s[j] - train, span, len, x, z, le);
+		}
+
+		/* Forward training */
+		memset(sums[0], 0, LANES_STATES * sizeof(int16_t));
+
+		for (i = 0; i < train; i++) {
+			for (j = 0; j < TURBO_LANES; j++) {
+				if (s[j] - train + i == 0)
+					lane_init_sums(sums[i & 1], j);
+			}
+
+			gen_fw_metrics_lanes(bm, &xw[TURBO_LANES * i],
+					     &zw[TURBO_LANES * i],
+					     sums[i & 1], sums[(i + 1) & 1],
+					     &lw[TURBO_LANES * i], norm);
+		}
+
+		memcpy(tm[0].fwsums, sums[train & 1],
+		       LANES_STATES * sizeof(int16_t));
+
+		for (j = 0; j < TURBO_LANES; j++) {
+			if (!s[j])
+				lane_init_sums(tm[0].fwsums, j);
+		}
+
+		/* Forward */
+		for (i = 0; i < w; i++) {
+			p = TURBO_LANES * (train + i);
+			gen_fw_metrics_lanes(tm[i].bm, &xw[p], &zw[p],
+					     tm[i].fwsums, tm[i + 1].fwsums,
+					     &lw[p], &t->fwnorm[TURBO_LANES * i]);
+		}
+
+		/* Backward training */
+		memset(t->bwsums, 0, LANES_STATES * sizeof(int16_t));
+		memset(sums[0], 0, LANES_STATES * sizeof(int16_t));
+
+		for (i = span - 1; i >= train + w; i--) {
+			for (j = 0; j < TURBO_LANES; j++) {
+				if (s[j] - train + i == len - 1)
+					lane_init_sums(t->bwsums, j);
+			}
+
+			gen_fw_metrics_lanes(bm, &xw[TURBO_LANES * i],
+					     &zw[TURBO_LANES * i],
+					     sums[0], sums[1],
+					     &lw[TURBO_LANES * i], norm);
+
+			for (j = 0; j < TURBO_LANES; j++)
+				norm[j] = t->bwsums[NUM_TRELLIS_STATES * j];
+
+			gen_bw_metrics_lanes(bm, &zw[TURBO_LANES * i], sums[0],
+					     t->bwsums, norm, out);
+		}
+
+		for (j = 0; j < TURBO_LANES; j++) {
+			if (s[j] + w == len)
+				lane_init_sums(t->bwsums, j);
+		}
+
+		/* Backward */
+		for (i = w - 1; i >= 0; i--) {
+			p = TURBO_LANES * (train + i);
+			gen_bw_metrics_lanes(tm[i].bm, &zw[p], tm[i].fwsums,
+					     t->bwsums,
+					     &t->fwnorm[TURBO_LANES * i],
+					     &out[TURBO_LANES * i]);
+		}
+
+		for (j = 0; (j < TURBO_LANES) && (k + j < n); j++) {
+			for (p = (k + j) * w; p < MIN((k + j + 1) * w, len); p++)
+				put_lval(trellis, len, p,
+					 out[TURBO_LANES * (p - s[j]) + j]);
+		}
+	}
+}
+
+/* Extrinsic output is scattered through 'map' to 'ext' unless NULL */
+static void turbo_iterate_lanes(struct tdecoder_lanes *t, int len,
+				const int16_t *x, const int16_t *z,
+				int16_t *lvals, const int *map, int16_t *ext)
+{
+	int i;
+	struct tmetric_lanes *tm = t->tm;
+
+	for (i = 0; i < TURBO_LANES; i++)
+		t->bwsums[NUM_TRELLIS_STATES * i] = SUM_INIT;
+
+	/* Forward */
+	for (i = 0; i < len; i++) {
+		gen_fw_metrics_lanes(tm[i].bm,
+				     &x[TURBO_LANES * i], &z[TURBO_LANES * i],
+				     tm[i].fwsums, tm[i + 1].fwsums,
+				     &lvals[TURBO_LANES * i],
+				     &t->fwnorm[TURBO_LANES * i]);
+	}
+
+	/* Backward */
+	for (i = len - 1; i >= 0; i--) {
+		int16_t *out = &lvals[TURBO_LANES * i];
+
+		if (map && (i < len - TERM_LEN))
+			out = &ext[TURBO_LANES * map[i]];
+
+		gen_bw_metrics_lanes(tm[i].bm, &z[TURBO_LANES * i],
+				     tm[i].fwsums, t->bwsums,
+				     &t->fwnorm[TURBO_LANES * i], out);
+	}
+}
+
+/* Widen one lane of 8-bit soft inputs into the lane interleaved buffer */
+static void widen_lane(int16_t *out, const int8_t *in, int len, int lane)
+{
+	for (int i = 0; i < len; i++)
+		out[TURBO_LANES * i + lane] = in[i];
+}
+
+static void pack_lane(uint8_t *output, const int16_t *lvals, int len, int lane)
+{
+	for (int i = 0; i < len / 8; i++) {
+		uint8_t byte = 0;
+
+		for (int n = 0; n < 8; n++) {
+			int bit = lvals[TURBO_LANES * (8 * i + n) + lane] > 0;
+#ifdef PACK_LE
+			byte |= bit << n;
+#else
+			byte |= bit << (7 - n);
+#endif
+		}
+		output[i] = byte;
+	}
+}
+
+/*
+ * Load a code block into 'lane' with cleared L-values. Input buffers are
+ * modified in place for trellis termination as with the single block
+ * decoder.
+ */
+static void load_lane(struct tdecoder_lanes *t, int len, int lane,
+		      const int8_t *d0, const int8_t *d1, const int8_t *d2)
+{
+	int i;
+	int8_t d0p[len + 3];
+
+	turbo_interleave(len, (uint8_t *) d0, (uint8_t *) d0p);
+	turbo_unterm(len, (uint8_t *) d0, (uint8_t *) d1,
+		     (uint8_t *) d2, (uint8_t *) d0p);
+
+	widen_lane(t->x[0], d0, len + 3, lane);
+	widen_lane(t->x[1], d0p, len + 3, lane);
+	widen_lane(t->z[0], d1, len + 3, lane);
+	widen_lane(t->z[1], d2, len + 3, lane);
+
+	for (i = 0; i < len + 3; i++) {
+		t->lvals[0][TURBO_LANES * i + lane] = 0;
+		t->lvals[1][TURBO_LANES * i + lane] = 0;
+	}
+}
+
+/* Unused lanes decode a copy of lane 0 so every lane carries valid metrics */
+static void mirror_lane(struct tdecoder_lanes *t, int len, int lane)
+{
+	for (int i = 0; i < len + 3; i++) {
+		t->x[0][TURBO_LANES * i + lane] = t->x[0][TURBO_LANES * i];
+		t->x[1][TURBO_LANES * i + lane] = t->x[1][TURBO_LANES * i];
+		t->z[0][TURBO_LANES * i + lane] = t->z[0][TURBO_LANES * i];
+		t->z[1][TURBO_LANES * i + lane] = t->z[1][TURBO_LANES * i];
+		t->lvals[0][TURBO_LANES * i + lane] = 0;
+		t->lvals[1][TURBO_LANES * i + lane] = 0;
+	}
+}
+
+/* Early termination check for one lane - see turbo_converged() */
+static int lane_converged(struct tdecoder_lanes *t, int len, int lane, int i,
+			  uint8_t *output, const struct lte_turbo_stop *stop)
+{
+	pack_lane(output, t->lvals[0], len, lane);
+
+	if (stop->crc && stop->crc(stop->arg, output, len))
+		return 1;
+
+	if (stop->stable) {
+		if (i && !memcmp(t->hard[lane], output, len / 8))
+			return 1;
+		memcpy(t->hard[lane], output, len / 8);
+	}
+
+	return 0;
+}
+
+/*
+ * Decode 'n' equal length blocks selected by 'idx' across the lanes. Each
+ * lane iterates its block until the iteration limit or early termination,
+ * then takes the next pending block, so lanes stay busy while blocks
+ * converge at different rates. Iteration counts are written to 'iters'.
+ */
+static void _turbo_decode_lanes(void *state, int fused,
+				int len, int max_iter, int n, const int *idx,
+				uint8_t **output, const int8_t **d0,
+				const int8_t **d1, const int8_t **d2,
+				const struct lte_turbo_stop *stop, int *iters)
+{
+	struct tdecoder_lanes *t = state;
+	int b, j, next = 0, active = 0;
+	int lane[TURBO_LANES], iter[TURBO_LANES];
+	const int *map[2] = { NULL, NULL };
+
+	if (fused) {
+		map[0] = turbo_interleave_map(len);
+		map[1] = turbo_deinterleave_map(len);
+	}
+
+	for (j = 0; j < TURBO_LANES; j++) {
+		lane_init_sums(t->tm[0].fwsums, j);
+		iter[j] = 0;
+
+		if (next < n) {
+			b = idx[next++];
+			load_lane(t, len, j, d0[b], d1[b], d2[b]);
+			lane[j] = b;
+			active++;
+		} else {
+			mirror_lane(t, len, j);
+			lane[j] = -1;
+		}
+	}
+
+	while (active) {
+		turbo_iterate_lanes(t, len + 3, t->x[0], t->z[0], t->lvals[0],
+				    map[0], t->lvals[1]);
+		if (!map[0]) {
+			turbo_interleave_lval_lanes(len, TURBO_LANES,
+						    t->lvals[0], t->lvals[1]);
+		}
+
+		turbo_iterate_lanes(t, len + 3, t->x[1], t->z[1], t->lvals[1],
+				    map[1], t->lvals[0]);
+		if (!map[1]) {
+			turbo_deinterleave_lval_lanes(len, TURBO_LANES,
+						      t->lvals[1], t->lvals[0]);
+		}
+
+		for (j = 0; j < TURBO_LANES; j++) {
+			b = lane[j];
+			if (b < 0)
+				continue;
+
+			iter[j]++;
+			if (stop && lane_converged(t, len, j, iter[j] - 1,
+						   output[b], stop)) {
+				iters[b] = iter[j];
+			} else if (iter[j] == max_iter) {
+				pack_lane(output[b], t->lvals[0], len, j);
+				iters[b] = iter[j];
+			} else {
+				continue;
+			}
+
+			iter[j] = 0;
+			if (next < n) {
+				b = idx[next++];
+				load_lane(t, len, j, d0[b], d1[b], d2[b]);
+				lane[j] = b;
+			} else {
+				lane[j] = -1;
+				active--;
+			}
+		}
+	}
+}
+
+const struct turbo_lanes TURBO_LANES_OPS = {
+	.name = TURBO_LANES_NAME,
+	.lanes = TURBO_LANES,
+	.alloc = alloc_tdec_lanes,
+	.window = turbo_iterate_window_lanes,
+	.decode = _turbo_decode_lanes,
+};
@@ -423,6 +423,8 @@ static int rate_match_init_fw(struct lte_rate_matcher *match,
 			interlv(match->v[i], D, match->z[i]);
 	}
 
+	match->V_alloc = V;
+
 	rate_match_fw(match, e, E, rv);
 
 	return 0;
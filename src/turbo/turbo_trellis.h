@@ -0,0 +1,109 @@
+/*
+ * LTE Max-Log-MAP turbo decoder - trellis definitions
+ *
+ * Copyright (C) 2015 Ettus Research LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Tom Tsou <tom.tsou@ettus.com>
+ */
+
+#ifndef _TURBO_TRELLIS_H_
+#define _TURBO_TRELLIS_H_
+
+#include <stdint.h>
+#include "turbo.h"
+
+#define NUM_TRELLIS_STATES	8
+#define MAX_TRELLIS_LEN		TURBO_MAX_WINDOW
+
+/* Trellis termination steps, which are not interleaved */
+#define TERM_LEN		3
+
+/* Initialization value for forward and backward sums */
+#define SUM_INIT		16000
+
+#define MIN(a,b)		((a) < (b) ? (a) : (b))
+
+struct tmetric {
+	int16_t bm[NUM_TRELLIS_STATES];
+	int16_t fwsums[NUM_TRELLIS_STATES];
+};
+
+/*
+ * Trellis Object
+ *
+ * sums       - Accumulated path metrics
+ * outputs    - Trellis ouput values
+ * metrics    - Path metrics
+ * vals       - Input value that led to each state
+ * map        - Extrinsic output scatter map, NULL for in place output
+ * ext        - L-values of the other constituent decoder
+ */
+struct vtrellis {
+	struct tmetric *tm;
+	int16_t *bwsums;
+	int16_t *fwnorm;
+	const int *map;
+	int16_t *ext;
+	int16_t lvals[MAX_TRELLIS_LEN];
+};
+
+/*
+ * L-value output for step 'i'. Termination steps stay in place while
+ * others are scattered to their permuted position in the other decoder.
+ * The QPP permutation is a bijection, so windows decoded in any order, or
+ * in parallel, never write the same position.
+ */
+static inline void put_lval(struct vtrellis *trellis, int len, int i,
+			    int16_t lval)
+{
+	if (trellis->map && (i < len - TERM_LEN))
+		trellis->ext[trellis->map[i]] = lval;
+	else
+		trellis->lvals[i] = lval;
+}
+
+/*
+ * Multi-block SIMD kernel
+ *
+ * Built for its instruction set regardless of the native target and
+ * selected at runtime, see turbo_lanes.h.
+ *
+ * lanes  - Code blocks, or windows of one block, decoded per pass
+ * alloc  - Allocate kernel state, released with free()
+ * window - Sliding window recursions of one constituent decoder pass
+ * decode - Decode 'n' equal length blocks selected by 'idx'
+ */
+struct turbo_lanes {
+	const char *name;
+	int lanes;
+	void *(*alloc)(void);
+	void (*window)(void *state, struct vtrellis *trellis, int len,
+		       int window, int train, const int8_t *x,
+		       const int8_t *z, const int16_t *le);
+	void (*decode)(void *state, int fused, int len, int max_iter,
+		       int n, const int *idx, uint8_t **output,
+		       const int8_t **d0, const int8_t **d1,
+		       const int8_t **d2, const struct lte_turbo_stop *stop,
+		       int *iters);
+};
+
+/* Widest supported kernel */
+#define TURBO_MAX_LANES		4
+
+extern const struct turbo_lanes turbo_lanes_avx2;
+extern const struct turbo_lanes turbo_lanes_avx512;
+
+#endif /* _TURBO_TRELLIS_H_ */